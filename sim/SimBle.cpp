@@ -0,0 +1,449 @@
+#include "SimBle.h"
+#include <NimBLEDevice.h>
+#include <atomic>
+#include <condition_variable>
+#include <esp_timer.h>
+#include <map>
+#include <mutex>
+#include <thread>
+
+static std::mutex sink_lock;
+static std::condition_variable sink_changed;
+static std::vector<SimBleReport> reports;
+static std::vector<uint8_t> report_map;
+static uint8_t battery_level = 0;
+static uint32_t battery_updates = 0;
+static uint32_t battery_notifies = 0;
+
+static NimBLEServer *server = nullptr;
+static NimBLEConnInfo conn_info;
+static std::atomic<bool> connected{false};
+static std::map<uint8_t, NimBLECharacteristic *> output_reports;
+static std::map<uint8_t, NimBLECharacteristic *> input_reports;
+static std::atomic<uint32_t> subscribe_delay_ms{0};
+static std::atomic<uint32_t> connection_count{0};
+static std::atomic<uint16_t> min_interval{6};
+static std::atomic<bool> ignore_param_updates{false};
+
+// Congested link: notifications in flight until the next connection event
+static unsigned tx_buffers = 0;
+static std::vector<NimBLECharacteristic *> tx_in_flight;
+static uint32_t tx_refused = 0;
+static bool tx_thread_started = false;
+
+// Identity the firmware advertises with, and the bonds it stored
+static NimBLEAddress own_address("24:58:7c:00:5a:12");
+static std::string device_name;
+static std::vector<NimBLEAddress> bonds;
+
+// ---------------------------------------------------------------------------
+// NimBLE fake
+// ---------------------------------------------------------------------------
+
+bool NimBLECharacteristic::notify() {
+  if (!connected || !_input || !SimBle::takeTxBuffer(this)) {
+    return false;
+  }
+  SimBle::recordNotify(*this, _value.data(), _value.size());
+  return true;
+}
+
+bool NimBLEServer::disconnect(uint16_t connHandle, uint8_t reason) {
+  SimBle::disconnect(reason);
+  return true;
+}
+
+bool NimBLEServer::updateConnParams(uint16_t connHandle, uint16_t minInterval,
+                                    uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+  if (!connected) {
+    return false;
+  }
+  // A real central answers later; a refused update never reaches onConnParamsUpdate
+  if (ignore_param_updates) {
+    return true;
+  }
+  // The simulated central accepts the slowest interval of the requested range,
+  // but not below its own floor
+  conn_info._interval = maxInterval < min_interval ? min_interval.load() : maxInterval;
+  conn_info._latency = latency;
+  conn_info._timeout = timeout;
+  if (_callbacks != nullptr) {
+    _callbacks->onConnParamsUpdate(conn_info);
+  }
+  return true;
+}
+
+size_t NimBLEServer::getConnectedCount() const {
+  return connected ? 1 : 0;
+}
+
+bool NimBLEAdvertising::start(uint32_t duration, const NimBLEAddress *dirAddr) {
+  _advertising = true;
+  _directed = dirAddr != nullptr;
+  _directedAddress = _directed ? *dirAddr : NimBLEAddress();
+  _duration = duration;
+  return true;
+}
+
+void NimBLEAdvertising::complete() {
+  if (!_advertising || _duration == 0) {
+    return;
+  }
+  _advertising = false;
+  if (_onComplete) {
+    _onComplete(this);
+  }
+}
+
+NimBLECharacteristic *NimBLEHIDDevice::getInputReport(uint8_t reportId) {
+  NimBLECharacteristic *&characteristic = _inputReports[reportId];
+  if (characteristic == nullptr) {
+    characteristic = new NimBLECharacteristic(reportId, true);
+    SimBle::registerInputReport(reportId, characteristic);
+  }
+  return characteristic;
+}
+
+NimBLECharacteristic *NimBLEHIDDevice::getOutputReport(uint8_t reportId) {
+  NimBLECharacteristic *&characteristic = _outputReports[reportId];
+  if (characteristic == nullptr) {
+    characteristic = new NimBLECharacteristic(reportId, false);
+    SimBle::registerOutputReport(reportId, characteristic);
+  }
+  return characteristic;
+}
+
+NimBLECharacteristic *NimBLEHIDDevice::getFeatureReport(uint8_t reportId) {
+  return new NimBLECharacteristic(reportId, false);
+}
+
+void NimBLEHIDDevice::setReportMap(uint8_t *map, uint16_t size) {
+  SimBle::setReportMap(map, size);
+}
+
+void NimBLEHIDDevice::setBatteryLevel(uint8_t level, bool notify) {
+  SimBle::setBatteryLevel(level, notify);
+}
+
+void NimBLEDevice::init(const std::string &deviceName) {}
+
+NimBLEServer *NimBLEDevice::createServer() {
+  if (server == nullptr) {
+    server = new NimBLEServer();
+  }
+  return server;
+}
+
+NimBLEServer *NimBLEDevice::getServer() {
+  return createServer();
+}
+
+bool NimBLEDevice::setDeviceName(const std::string &deviceName) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  device_name = deviceName;
+  return true;
+}
+
+bool NimBLEDevice::setOwnAddr(const uint8_t *addr) {
+  if (connected || getServer()->getAdvertising()->isAdvertising()) {
+    return false; // The controller refuses while the address is in use
+  }
+  std::lock_guard<std::mutex> lock(sink_lock);
+  own_address = NimBLEAddress(addr, BLE_ADDR_RANDOM);
+  return true;
+}
+
+NimBLEAddress NimBLEDevice::getAddress() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return own_address;
+}
+
+bool NimBLEDevice::isBonded(const NimBLEAddress &address) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  for (const NimBLEAddress &bond : bonds) {
+    if (bond == address) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NimBLEDevice::deleteBond(const NimBLEAddress &address) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  for (auto it = bonds.begin(); it != bonds.end(); ++it) {
+    if (*it == address) {
+      bonds.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+int NimBLEDevice::getNumBonds() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return (int)bonds.size();
+}
+
+// ---------------------------------------------------------------------------
+// Simulated central and sink
+// ---------------------------------------------------------------------------
+
+static void subscribe_all() {
+  for (const auto &entry : input_reports) {
+    NimBLECharacteristic *characteristic = entry.second;
+    if (characteristic->getCallbacks() != nullptr) {
+      characteristic->getCallbacks()->onSubscribe(characteristic, conn_info, 1);
+    }
+  }
+}
+
+bool SimBle::connect(const char *address, bool bond) {
+  if (connected) {
+    return false;
+  }
+  NimBLEServer *srv = NimBLEDevice::getServer();
+  NimBLEAdvertising *advertising = srv->getAdvertising();
+  const NimBLEAddress central(address);
+  if (!advertising->isAdvertising()) {
+    printf("[SIM] %s cannot connect: not advertising\n", address);
+    return false;
+  }
+  if (advertising->isDirected() && !(advertising->getDirectedAddress() == central)) {
+    printf("[SIM] %s cannot connect: advertising is directed to %s\n", address,
+           advertising->getDirectedAddress().toString().c_str());
+    return false;
+  }
+
+  conn_info = NimBLEConnInfo();
+  conn_info._address = central;
+  connected = true;
+  advertising->stop();
+  if (srv->getCallbacks() != nullptr) {
+    srv->getCallbacks()->onConnect(srv, conn_info);
+  }
+
+  // Pairing, or re-encryption with an existing bond, completes authentication
+  const bool bonded = NimBLEDevice::isBonded(central);
+  if (bond && !bonded) {
+    std::lock_guard<std::mutex> lock(sink_lock);
+    bonds.push_back(central);
+  }
+  conn_info._bonded = bond || bonded;
+  if (conn_info._bonded && srv->getCallbacks() != nullptr) {
+    srv->getCallbacks()->onAuthenticationComplete(conn_info);
+  }
+
+  const uint32_t connection = ++connection_count;
+  const uint32_t delayMs = subscribe_delay_ms;
+  if (delayMs == 0) {
+    subscribe_all();
+  } else {
+    std::thread([connection, delayMs]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+      if (connected && connection_count == connection) {
+        subscribe_all();
+      }
+    }).detach();
+  }
+  return true;
+}
+
+void SimBle::setSubscribeDelay(uint32_t ms) {
+  subscribe_delay_ms = ms;
+}
+
+void SimBle::disconnect(int reason) {
+  if (!connected) {
+    return;
+  }
+  connected = false;
+  NimBLEServer *srv = NimBLEDevice::getServer();
+  if (srv->getCallbacks() != nullptr) {
+    srv->getCallbacks()->onDisconnect(srv, conn_info, reason);
+  }
+}
+
+bool SimBle::isConnected() {
+  return connected;
+}
+
+void SimBle::writeOutputReport(uint8_t reportId, uint8_t value) {
+  auto it = output_reports.find(reportId);
+  if (!connected || it == output_reports.end()) {
+    return;
+  }
+  NimBLECharacteristic *characteristic = it->second;
+  characteristic->setValue(&value, 1);
+  if (characteristic->getCallbacks() != nullptr) {
+    characteristic->getCallbacks()->onWrite(characteristic, conn_info);
+  }
+}
+
+size_t SimBle::reportCount() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return reports.size();
+}
+
+bool SimBle::waitForReports(size_t count, uint32_t timeoutMs) {
+  std::unique_lock<std::mutex> lock(sink_lock);
+  return sink_changed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                               [count] { return reports.size() >= count; });
+}
+
+bool SimBle::getReport(size_t index, SimBleReport &report) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  if (index >= reports.size()) {
+    return false;
+  }
+  report = reports[index];
+  return true;
+}
+
+void SimBle::clearReports() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  reports.clear();
+}
+
+void SimBle::writeReports(FILE *out) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  fprintf(out, "timestamp_us,report_id,data\n");
+  for (const SimBleReport &report : reports) {
+    fprintf(out, "%lld,%u,", (long long)report.timestampUs, report.reportId);
+    for (size_t i = 0; i < report.data.size(); i++) {
+      fprintf(out, i == 0 ? "%02X" : " %02X", report.data[i]);
+    }
+    fprintf(out, "\n");
+  }
+}
+
+std::vector<uint8_t> SimBle::reportMap() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return report_map;
+}
+
+uint8_t SimBle::batteryLevel() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return battery_level;
+}
+
+uint32_t SimBle::batteryUpdates() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return battery_updates;
+}
+
+uint32_t SimBle::batteryNotifies() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return battery_notifies;
+}
+
+void SimBle::recordNotify(const NimBLECharacteristic &characteristic, const uint8_t *data,
+                          size_t length) {
+  SimBleReport report;
+  report.timestampUs = esp_timer_get_time();
+  report.reportId = characteristic.reportId();
+  report.data.assign(data, data + length);
+  {
+    std::lock_guard<std::mutex> lock(sink_lock);
+    reports.push_back(report);
+  }
+  sink_changed.notify_all();
+}
+
+// Frees the TX buffers once per connection event, like the controller
+// sending them, and reports each finished notification
+static void tx_complete_thread() {
+  while (true) {
+    const uint16_t interval = conn_info.getConnInterval();
+    std::this_thread::sleep_for(std::chrono::microseconds(interval * 1250));
+    std::vector<NimBLECharacteristic *> done;
+    {
+      std::lock_guard<std::mutex> lock(sink_lock);
+      done.swap(tx_in_flight);
+    }
+    for (NimBLECharacteristic *characteristic : done) {
+      if (characteristic->getCallbacks() != nullptr) {
+        characteristic->getCallbacks()->onStatus(characteristic, 0);
+      }
+    }
+  }
+}
+
+void SimBle::setTxBuffers(unsigned buffers) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  tx_buffers = buffers;
+  if (buffers != 0 && !tx_thread_started) {
+    tx_thread_started = true;
+    std::thread(tx_complete_thread).detach();
+  }
+}
+
+uint32_t SimBle::txRefused() {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  return tx_refused;
+}
+
+bool SimBle::takeTxBuffer(NimBLECharacteristic *characteristic) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  if (tx_buffers == 0) {
+    return true;
+  }
+  if (tx_in_flight.size() >= tx_buffers) {
+    tx_refused++;
+    return false;
+  }
+  tx_in_flight.push_back(characteristic);
+  return true;
+}
+
+void SimBle::setReportMap(const uint8_t *map, size_t length) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  report_map.assign(map, map + length);
+}
+
+void SimBle::setBatteryLevel(uint8_t level, bool notify) {
+  std::lock_guard<std::mutex> lock(sink_lock);
+  battery_level = level;
+  battery_updates++;
+  battery_notifies += notify ? 1 : 0;
+}
+
+void SimBle::registerOutputReport(uint8_t reportId, NimBLECharacteristic *characteristic) {
+  output_reports[reportId] = characteristic;
+}
+
+void SimBle::registerInputReport(uint8_t reportId, NimBLECharacteristic *characteristic) {
+  input_reports[reportId] = characteristic;
+}
+
+void SimBle::setMinInterval(uint16_t interval) {
+  min_interval = interval;
+}
+
+void SimBle::setIgnoreParamUpdates(bool ignore) {
+  ignore_param_updates = ignore;
+}
+
+void SimBle::connParams(uint16_t &interval, uint16_t &latency, uint16_t &timeout) {
+  interval = conn_info.getConnInterval();
+  latency = conn_info.getConnLatency();
+  timeout = conn_info.getConnTimeout();
+}
+
+void SimBle::advertisingTimeout() {
+  NimBLEDevice::getServer()->getAdvertising()->complete();
+}
+
+void SimBle::printAdvertising() {
+  NimBLEAdvertising *advertising = NimBLEDevice::getServer()->getAdvertising();
+  const std::string address = NimBLEDevice::getAddress().toString();
+  if (!advertising->isAdvertising()) {
+    printf("[SIM] %s: not advertising%s\n", address.c_str(), connected ? " (connected)" : "");
+  } else if (advertising->isDirected()) {
+    printf("[SIM] %s: directed advertising to %s for %u ms\n", address.c_str(),
+           advertising->getDirectedAddress().toString().c_str(),
+           (unsigned)advertising->getDuration());
+  } else {
+    printf("[SIM] %s: advertising as \"%s\"\n", address.c_str(),
+           advertising->getName().c_str());
+  }
+}
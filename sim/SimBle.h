@@ -0,0 +1,116 @@
+/**
+ * @file SimBle.h
+ * @brief Simulated BLE central and report sink behind the NimBLE fake.
+ *
+ * On connect the central subscribes to every input report. Every notify()
+ * on an input report characteristic while a central is connected is stored with its esp_timer_get_time() timestamp, so a run can
+ * be checked report by report or analysed for throughput and latency.
+ */
+
+#ifndef SIM_BLE_H
+#define SIM_BLE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+/** @brief One notification as seen by the central. */
+struct SimBleReport {
+  int64_t timestampUs;
+  uint8_t reportId;
+  std::vector<uint8_t> data;
+};
+
+class NimBLECharacteristic;
+
+class SimBle {
+public:
+  /**
+   * @brief Simulates a central connecting (runs the server's onConnect).
+   *
+   * Fails if the firmware is not advertising or directs its advertising at
+   * another central. With bond, or if the central is already bonded, the
+   * server's onAuthenticationComplete follows.
+   */
+  static bool connect(const char *address = "aa:bb:cc:dd:ee:01", bool bond = false);
+
+  /**
+   * @brief Delay between connecting and the central subscribing to the input reports.
+   *
+   * 0 (the default) subscribes within connect(). Otherwise the subscriptions
+   * arrive later from another thread, as a host discovering or restoring them would.
+   */
+  static void setSubscribeDelay(uint32_t ms);
+
+  /// Simulates the link dropping (runs the server's onDisconnect).
+  static void disconnect(int reason = 0x13);
+
+  static bool isConnected();
+
+  /// Simulates the central writing an output report (e.g. keyboard LEDs).
+  static void writeOutputReport(uint8_t reportId, uint8_t value);
+
+  /// Slowest-first central: requested intervals below this floor (1.25 ms units) are raised.
+  static void setMinInterval(uint16_t interval);
+
+  /// When set, parameter update requests are accepted by the stack but never applied.
+  static void setIgnoreParamUpdates(bool ignore);
+
+  /// Ends a timed (directed) advertising run as the controller would.
+  static void advertisingTimeout();
+
+  /// Prints the advertised identity and mode.
+  static void printAdvertising();
+
+  /// Connection parameters currently in use.
+  static void connParams(uint16_t &interval, uint16_t &latency, uint16_t &timeout);
+
+  /**
+   * @brief Simulates a congested link.
+   *
+   * Each notification takes one of buffers TX buffers, and notify() fails
+   * while none is free. At every connection event the link sends what it
+   * holds, frees the buffers and reports each one to the characteristic's
+   * onStatus(). 0 (the default) means unlimited buffers and no onStatus().
+   */
+  static void setTxBuffers(unsigned buffers);
+
+  /// Notifications refused for lack of a TX buffer.
+  static uint32_t txRefused();
+
+  /// Number of notifications recorded since the last clearReports().
+  static size_t reportCount();
+
+  /// Blocks until at least count notifications were recorded or the timeout expires.
+  static bool waitForReports(size_t count, uint32_t timeoutMs);
+
+  static bool getReport(size_t index, SimBleReport &report);
+
+  static void clearReports();
+
+  /// Writes all recorded notifications as CSV: timestamp_us,report_id,hex bytes.
+  static void writeReports(FILE *out);
+
+  /// Report map registered by the firmware via setReportMap().
+  static std::vector<uint8_t> reportMap();
+
+  /// Last battery level set by the firmware.
+  static uint8_t batteryLevel();
+
+  /// Times the firmware set the battery level.
+  static uint32_t batteryUpdates();
+
+  /// Times setting the battery level notified the host.
+  static uint32_t batteryNotifies();
+
+  // Used by the NimBLE fake
+  static bool takeTxBuffer(NimBLECharacteristic *characteristic);
+  static void recordNotify(const NimBLECharacteristic &characteristic, const uint8_t *data,
+                           size_t length);
+  static void setReportMap(const uint8_t *map, size_t length);
+  static void setBatteryLevel(uint8_t level, bool notify);
+  static void registerOutputReport(uint8_t reportId, NimBLECharacteristic *characteristic);
+  static void registerInputReport(uint8_t reportId, NimBLECharacteristic *characteristic);
+};
+
+#endif // SIM_BLE_H
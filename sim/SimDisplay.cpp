@@ -0,0 +1,330 @@
+// Display.h for the simulation: the bongo frames, key readout and status line are
+// composited into a memory framebuffer with the same layout and frame cap as the device.
+// There is no TFT font or JPEG decoder: every glyph in the atlas is a filled block inside
+// its cell, and the cached bongo frames are synthetic (same body, paws moved per frame).
+#include "Display.h"
+#include "Profiler.h"
+#include <Arduino.h>
+#include <freertos/queue.h>
+#include <atomic>
+#include <mutex>
+#include <string.h>
+
+#define SIM_WHITE 0xFFFF
+#define SIM_BLACK 0x0000
+#define SIM_GREY 0xD69A
+
+TFT_eSPI tft;
+
+static uint16_t framebuffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static FramebufferSink sink(framebuffer, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+static Compositor compositor(DISPLAY_WIDTH, DISPLAY_HEIGHT, sink);
+static uint16_t keyPixels[DISPLAY_KEY_W * DISPLAY_KEY_H];
+static uint16_t waitingPixels[DISPLAY_WAITING_W * DISPLAY_WAITING_H];
+static uint16_t statusPixels[DISPLAY_STATUS_W * DISPLAY_STATUS_H];
+
+static const unsigned long KEY_DISPLAY_DURATION = 5000;
+static const char DISPLAY_WAKE = '\0';
+static QueueHandle_t keyQueue = nullptr;
+static std::mutex statusLock;
+static char statusText[40] = "";
+static bool statusChanged = false;
+static compositor_stats_t displayStats = {};
+
+struct ImageRequest {
+  int imageIndex;
+};
+static const int BONGO_COUNT = 8;
+static const int BONGO_W = DISPLAY_WIDTH;
+static const int BONGO_H = 172;
+static const unsigned long KEY_IDLE_TIMEOUT = 200;
+static QueueHandle_t imageQueue = nullptr;
+static std::atomic<int> keysPressed{0};
+static SpriteCache imageCache(malloc);
+static int bongoFrames[BONGO_COUNT] = {-1, -1, -1, -1, -1, -1, -1, -1};
+static int currentImage = -1;
+static int pendingFrame = -1;
+static DisplayRect pendingDamage = {};
+static display_image_stats_t imageStats = {};
+static display_key_stats_t keyStats = {};
+static GlyphAtlas keyAtlas(malloc);
+static GlyphAtlas statusAtlas(malloc);
+
+static void fill(uint16_t *pixels, int w, int x, int y, int rw, int rh, uint16_t color) {
+  for (int row = y; row < y + rh; row++) {
+    for (int col = x; col < x + rw; col++) {
+      pixels[row * w + col] = color;
+    }
+  }
+}
+
+static void rasterGlyph(char c, uint8_t rows[GLYPH_CELL_H]) {
+  for (int y = 0; y < 7 && c != ' '; y++) {
+    rows[y] = 0xF8; // 5x7 block
+  }
+}
+
+static void drawKey(char key) {
+  const int64_t start = esp_timer_get_time();
+  const bool fromAtlas = keyAtlas.draw(key, keyPixels, DISPLAY_KEY_W, SIM_BLACK, SIM_WHITE);
+  if (!fromAtlas) {
+    fill(keyPixels, DISPLAY_KEY_W, 0, 0, DISPLAY_KEY_W, DISPLAY_KEY_H, SIM_WHITE);
+  }
+  const uint32_t renderUs = (uint32_t)(esp_timer_get_time() - start);
+  {
+    std::lock_guard<std::mutex> lock(statusLock);
+    keyStats.renders++;
+    keyStats.atlasRenders += fromAtlas;
+    keyStats.lastRenderUs = renderUs;
+    keyStats.maxRenderUs = renderUs > keyStats.maxRenderUs ? renderUs : keyStats.maxRenderUs;
+  }
+  compositor.invalidate(DISPLAY_LAYER_KEY);
+  compositor.setVisible(DISPLAY_LAYER_KEY, true);
+  compositor.setVisible(DISPLAY_LAYER_WAITING, false);
+}
+
+static void drawStatus() {
+  char text[sizeof(statusText)];
+  {
+    std::lock_guard<std::mutex> lock(statusLock);
+    memcpy(text, statusText, sizeof(text));
+    statusChanged = false;
+  }
+  fill(statusPixels, DISPLAY_STATUS_W, 0, 0, DISPLAY_STATUS_W, DISPLAY_STATUS_H, SIM_BLACK);
+  int16_t x = 0;
+  for (const char *c = text; *c != '\0' && x + GLYPH_CELL_W <= DISPLAY_STATUS_W; c++, x += GLYPH_CELL_W) {
+    statusAtlas.draw(GlyphAtlas::has(*c) ? *c : '?', statusPixels + x, DISPLAY_STATUS_W, SIM_WHITE, SIM_BLACK);
+  }
+  compositor.invalidate(DISPLAY_LAYER_STATUS);
+}
+
+static bool showPendingFrame() {
+  int frame;
+  DisplayRect damage;
+  {
+    std::lock_guard<std::mutex> lock(statusLock);
+    frame = pendingFrame;
+    damage = pendingDamage;
+    pendingFrame = -1;
+  }
+  const CachedSprite *sprite = frame >= 0 ? imageCache.get(frame) : nullptr;
+  if (sprite == nullptr) {
+    return false;
+  }
+  if (!compositor.visible(DISPLAY_LAYER_BONGO)) {
+    compositor.setLayer(DISPLAY_LAYER_BONGO, sprite->pixels,
+                        DisplayRect{DISPLAY_BONGO_X, DISPLAY_BONGO_Y, sprite->w, sprite->h});
+    compositor.setVisible(DISPLAY_LAYER_BONGO, true);
+  } else {
+    compositor.setPixels(DISPLAY_LAYER_BONGO, sprite->pixels);
+    compositor.invalidate(DISPLAY_LAYER_BONGO, damage);
+  }
+  return true;
+}
+
+static void imageDisplayTask(void *parameter) {
+  while (true) {
+    ImageRequest request;
+    TickType_t ticks = currentImage > 0 ? pdMS_TO_TICKS(KEY_IDLE_TIMEOUT) : portMAX_DELAY;
+    if (!xQueueReceive(imageQueue, &request, ticks)) {
+      if (keysPressed > 0) {
+        continue;
+      }
+      request.imageIndex = 0;
+    }
+    ImageRequest newer;
+    while (xQueueReceive(imageQueue, &newer, 0)) {
+      request = newer;
+      std::lock_guard<std::mutex> lock(statusLock);
+      imageStats.dropped++;
+    }
+    if (request.imageIndex < 0 || request.imageIndex >= BONGO_COUNT ||
+        request.imageIndex == currentImage || bongoFrames[request.imageIndex] < 0) {
+      continue;
+    }
+
+    const int frame = bongoFrames[request.imageIndex];
+    const CachedSprite *sprite = imageCache.get(frame);
+    DisplayRect damage = {0, 0, sprite->w, sprite->h};
+    if (currentImage >= 0 &&
+        !imageCache.diffBounds(bongoFrames[currentImage], frame, damage.x, damage.y, damage.w, damage.h)) {
+      damage = DisplayRect{0, 0, 0, 0};
+    }
+    currentImage = request.imageIndex;
+    {
+      std::lock_guard<std::mutex> lock(statusLock);
+      if (pendingFrame >= 0) {
+        imageStats.dropped++;
+        damage = damage.unite(pendingDamage);
+      }
+      pendingFrame = frame;
+      pendingDamage = damage;
+      imageStats.swapPixels = damage.area();
+    }
+    xQueueSend(keyQueue, &DISPLAY_WAKE, 0);
+  }
+}
+
+static void keyDisplayTask(void *parameter) {
+  unsigned long lastKeyTime = 0;
+  char lastKey = '\0';
+  bool swapping = false;
+  while (true) {
+    const unsigned long now = millis();
+    uint32_t waitMs = compositor.msUntilFrame(now);
+    if (lastKey != '\0' && now - lastKeyTime < KEY_DISPLAY_DURATION) {
+      const uint32_t keyMs = (uint32_t)(KEY_DISPLAY_DURATION - (now - lastKeyTime)) + 1;
+      waitMs = keyMs < waitMs ? keyMs : waitMs;
+    }
+    TickType_t ticks = waitMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitMs);
+
+    char receivedKey;
+    if (xQueueReceive(keyQueue, &receivedKey, ticks) && receivedKey != DISPLAY_WAKE) {
+      lastKey = receivedKey;
+      lastKeyTime = millis();
+      drawKey(receivedKey);
+    }
+    if (statusChanged) {
+      drawStatus();
+    }
+    if (pendingFrame >= 0 && showPendingFrame()) {
+      swapping = true;
+    }
+    if (lastKey != '\0' && millis() - lastKeyTime > KEY_DISPLAY_DURATION) {
+      lastKey = '\0';
+      compositor.setVisible(DISPLAY_LAYER_KEY, false);
+      compositor.setVisible(DISPLAY_LAYER_WAITING, true);
+    }
+
+    const int64_t frameStartUs = esp_timer_get_time();
+    if (compositor.frame(millis())) {
+      const uint32_t frameUs = (uint32_t)(esp_timer_get_time() - frameStartUs);
+      std::lock_guard<std::mutex> lock(statusLock);
+      displayStats = compositor.stats();
+      if (swapping) {
+        imageStats.swaps++;
+        imageStats.lastSwapUs = frameUs;
+        imageStats.maxSwapUs = frameUs > imageStats.maxSwapUs ? frameUs : imageStats.maxSwapUs;
+      }
+      swapping = false;
+    }
+  }
+}
+
+void displayInit() {
+  displayCacheImages();
+}
+
+void displayCacheImages() {
+  if (imageCache.count() > 0) {
+    return;
+  }
+  const int64_t start = esp_timer_get_time();
+  uint16_t block[16 * 16];
+  for (int i = 0; i < BONGO_COUNT; i++) {
+    bongoFrames[i] = imageCache.add("/bongo", BONGO_W, BONGO_H);
+    if (bongoFrames[i] < 0) {
+      continue;
+    }
+    // Fed in 16x16 blocks like a JPEG decoder: white, a grey cat, paws that move per frame
+    for (int by = 0; by < BONGO_H; by += 16) {
+      for (int bx = 0; bx < BONGO_W; bx += 16) {
+        for (int p = 0; p < 16 * 16; p++) {
+          const int x = bx + p % 16;
+          const int y = by + p / 16;
+          const bool cat = x >= 60 && x < 180 && y >= 30 && y < 140;
+          const int pawX = 50 + (i % 4) * 30;
+          const bool paw = y >= 140 - (i / 4) * 12 && y < 160 && x >= pawX && x < pawX + 30;
+          block[p] = paw ? SIM_BLACK : (cat ? SIM_GREY : SIM_WHITE);
+        }
+        imageCache.blit(bongoFrames[i], bx, by, 16, 16, block);
+      }
+    }
+  }
+  imageStats.decodeMs = (uint32_t)((esp_timer_get_time() - start) / 1000);
+}
+
+void displayStartKeyMonitor() {
+  if (keyQueue != nullptr) {
+    return;
+  }
+  keyQueue = xQueueCreate(10, sizeof(char));
+  imageQueue = xQueueCreate(10, sizeof(ImageRequest));
+  profilerWatchQueue("keyQueue", keyQueue);
+  profilerWatchQueue("imageQueue", imageQueue);
+  displayCacheImages();
+  compositor.setLayer(DISPLAY_LAYER_KEY, keyPixels,
+                      DisplayRect{DISPLAY_KEY_X, DISPLAY_KEY_Y, DISPLAY_KEY_W, DISPLAY_KEY_H});
+  compositor.setLayer(DISPLAY_LAYER_WAITING, waitingPixels,
+                      DisplayRect{DISPLAY_WAITING_X, DISPLAY_WAITING_Y, DISPLAY_WAITING_W, DISPLAY_WAITING_H});
+  compositor.setLayer(DISPLAY_LAYER_STATUS, statusPixels,
+                      DisplayRect{DISPLAY_STATUS_X, DISPLAY_STATUS_Y, DISPLAY_STATUS_W, DISPLAY_STATUS_H});
+  fill(waitingPixels, DISPLAY_WAITING_W, 0, 0, DISPLAY_WAITING_W, DISPLAY_WAITING_H, SIM_WHITE);
+  fill(waitingPixels, DISPLAY_WAITING_W, 0, 0, DISPLAY_WAITING_W, 14, SIM_GREY);
+  keyAtlas.build(DISPLAY_KEY_TEXT_SIZE, rasterGlyph);
+  statusAtlas.build(1, rasterGlyph);
+  keyStats.atlasBytes = keyAtlas.bytes() + statusAtlas.bytes();
+  statusChanged = true;
+  compositor.setVisible(DISPLAY_LAYER_STATUS, true);
+  compositor.setMaxFps(DISPLAY_MAX_FPS);
+  compositor.setBackground(SIM_WHITE);
+  xTaskCreate(keyDisplayTask, "KeyDisplayTask", 4096, nullptr, 1, nullptr);
+  xTaskCreate(imageDisplayTask, "ImageDisplayTask", 3072, nullptr, 1, nullptr);
+  ImageRequest idle = {0};
+  xQueueSend(imageQueue, &idle, 0);
+}
+
+void displayKeyPressed(char key) {
+  const int pressed = ++keysPressed;
+  if (imageQueue != nullptr) {
+    ImageRequest request = {pressed == 1 ? 2 + rand() % 6 : 1};
+    xQueueSend(imageQueue, &request, 0);
+  }
+  if (keyQueue != nullptr && key != DISPLAY_WAKE) {
+    xQueueSend(keyQueue, &key, 0);
+  }
+}
+
+void displayKeyReleased() {
+  int pressed = keysPressed;
+  while (pressed > 0 && !keysPressed.compare_exchange_weak(pressed, pressed - 1)) {
+  }
+}
+
+void displaySetStatus(const char *text) {
+  bool changed;
+  {
+    std::lock_guard<std::mutex> lock(statusLock);
+    changed = strncmp(text, statusText, sizeof(statusText) - 1) != 0;
+    if (changed) {
+      strncpy(statusText, text, sizeof(statusText) - 1);
+      statusChanged = true;
+    }
+  }
+  if (changed && keyQueue != nullptr) {
+    xQueueSend(keyQueue, &DISPLAY_WAKE, 0);
+  }
+}
+
+compositor_stats_t displayGetStats() {
+  std::lock_guard<std::mutex> lock(statusLock);
+  return displayStats;
+}
+
+display_key_stats_t displayGetKeyStats() {
+  std::lock_guard<std::mutex> lock(statusLock);
+  return keyStats;
+}
+
+display_image_stats_t displayGetImageStats() {
+  std::lock_guard<std::mutex> lock(statusLock);
+  display_image_stats_t stats = imageStats;
+  stats.cache = imageCache.stats();
+  return stats;
+}
+
+void displayJPEG(const char *filename, int x, int y) {}
+
+void displayClearScreen() {}
+
+void displayListSPIFFSFiles() {}
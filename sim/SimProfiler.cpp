@@ -0,0 +1,68 @@
+// Profiler.h for the simulation: the same TaskProfiler snapshot, fed from the FreeRTOS fake.
+// Run time is each task thread's CPU clock against wall time, so a share is of one host
+// core. Tasks float (no core load line), stacks are host threads (free shown as 0) and the
+// host heap is not measured.
+#include "Profiler.h"
+#include <mutex>
+
+static TaskProfiler profiler;
+static QueueHandle_t queues[PROFILER_MAX_QUEUES];
+static size_t queueCount = 0;
+static std::mutex profilerLock;
+static TaskHandle_t profilerTaskHandle = nullptr;
+
+static void profilerTask(void *parameter) {
+  TickType_t wake = xTaskGetTickCount();
+  profiler_task_t tasks[PROFILER_MAX_TASKS];
+  while (true) {
+    const std::vector<SimFreeRTOS::TaskInfo> list = SimFreeRTOS::tasks();
+    size_t used = 0;
+    for (size_t i = 0; i < list.size() && used < PROFILER_MAX_TASKS; i++) {
+      profiler_task_t &task = tasks[used++];
+      strncpy(task.name, list[i].name.c_str(), PROFILER_NAME_LEN - 1);
+      task.name[PROFILER_NAME_LEN - 1] = '\0';
+      task.id = list[i].id;
+      task.runtime = (uint32_t)list[i].cpuUs;
+      task.stackFree = 0;
+      task.priority = (uint8_t)list[i].priority;
+      task.core = PROFILER_NO_CORE;
+    }
+    {
+      std::lock_guard<std::mutex> lock(profilerLock);
+      profiler.updateTasks(tasks, used, (uint32_t)esp_timer_get_time());
+      for (size_t i = 0; i < queueCount; i++) {
+        profiler.updateQueue((int)i, (uint16_t)uxQueueMessagesWaiting(queues[i]));
+      }
+    }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(PROFILER_PERIOD_MS));
+  }
+}
+
+void profilerBegin() {
+  if (profilerTaskHandle != nullptr) {
+    return;
+  }
+  xTaskCreatePinnedToCore(profilerTask, "profiler", 3072, nullptr, 1, &profilerTaskHandle, 0);
+}
+
+void profilerWatchQueue(const char *name, QueueHandle_t queue) {
+  if (queue == nullptr) {
+    return;
+  }
+  const uint16_t length = (uint16_t)(uxQueueMessagesWaiting(queue) + uxQueueSpacesAvailable(queue));
+  std::lock_guard<std::mutex> lock(profilerLock);
+  const int index = profiler.addQueue(name, length);
+  if (index >= 0) {
+    queues[index] = queue;
+    queueCount = index + 1;
+  }
+}
+
+void profilerDump(ProfilerLineWriter writer) {
+  TaskProfiler copy;
+  {
+    std::lock_guard<std::mutex> lock(profilerLock);
+    copy = profiler;
+  }
+  copy.dump(writer);
+}
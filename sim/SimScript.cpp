@@ -0,0 +1,337 @@
+#include "SimScript.h"
+#include "LatencyStats.h"
+#include "SimBle.h"
+#include "SimUsbHost.h"
+#include <Arduino.h>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define SIM_EXPECT_TIMEOUT_MS 200
+
+static std::map<std::string, hid_host_device_handle_t> devices;
+static size_t expect_cursor = 0;
+
+static bool parse_hex(std::istringstream &args, std::vector<uint8_t> &bytes) {
+  std::string token;
+  while (args >> token) {
+    char *end = nullptr;
+    unsigned long value = strtoul(token.c_str(), &end, 16);
+    if (*end != '\0' || value > 0xFF) {
+      return false;
+    }
+    bytes.push_back((uint8_t)value);
+  }
+  return true;
+}
+
+static void print_hex(const std::vector<uint8_t> &bytes) {
+  for (uint8_t b : bytes) {
+    printf(" %02X", b);
+  }
+}
+
+static void print_line(const char *line) {
+  printf("%s\n", line);
+}
+
+static bool run_command(const std::string &command, std::istringstream &args,
+                        std::string &error) {
+  if (command == "usb-connect") {
+    std::string name, kind;
+    args >> name >> kind;
+    SimHidInterfaceConfig config;
+    if (kind == "keyboard") {
+      // Optionally followed by the report descriptor of the boot interface
+      config = SimUsbHost::bootKeyboard();
+      if (!parse_hex(args, config.descriptor)) {
+        error = "bad descriptor";
+        return false;
+      }
+    } else if (kind == "mouse") {
+      config = SimUsbHost::bootMouse();
+    } else if (kind == "consumer") {
+      config = SimUsbHost::consumerControl();
+    } else if (kind == "descriptor") {
+      config = {0, 0, {}};
+      if (!parse_hex(args, config.descriptor) || config.descriptor.empty()) {
+        error = "bad descriptor";
+        return false;
+      }
+    } else {
+      error = "unknown device kind '" + kind + "'";
+      return false;
+    }
+    hid_host_device_handle_t handle = SimUsbHost::connect(config);
+    if (handle == nullptr) {
+      error = "interface was not started";
+      return false;
+    }
+    devices[name] = handle;
+    return true;
+  }
+
+  if (command == "usb-disconnect" || command == "report") {
+    std::string name;
+    args >> name;
+    auto it = devices.find(name);
+    if (it == devices.end()) {
+      error = "unknown device '" + name + "'";
+      return false;
+    }
+    if (command == "usb-disconnect") {
+      SimUsbHost::disconnect(it->second);
+      devices.erase(it);
+      return true;
+    }
+    std::vector<uint8_t> bytes;
+    if (!parse_hex(args, bytes) || bytes.empty()) {
+      error = "bad report bytes";
+      return false;
+    }
+    if (!SimUsbHost::inject(it->second, bytes.data(), bytes.size())) {
+      error = "interface not started";
+      return false;
+    }
+    return true;
+  }
+
+  if (command == "ble-connect") {
+    std::string address, bond;
+    args >> address >> bond;
+    if (!SimBle::connect(address.empty() ? "aa:bb:cc:dd:ee:01" : address.c_str(),
+                         bond == "bond")) {
+      error = "central could not connect";
+      return false;
+    }
+    return true;
+  }
+
+  if (command == "ble-adv") {
+    SimBle::printAdvertising();
+    return true;
+  }
+
+  if (command == "ble-adv-timeout") {
+    SimBle::advertisingTimeout();
+    return true;
+  }
+
+  if (command == "ble-disconnect") {
+    SimBle::disconnect();
+    return true;
+  }
+
+  if (command == "ble-min-interval") {
+    unsigned interval = 0;
+    if (!(args >> interval)) {
+      error = "expected an interval in 1.25 ms units";
+      return false;
+    }
+    SimBle::setMinInterval((uint16_t)interval);
+    return true;
+  }
+
+  if (command == "ble-ignore-params") {
+    int ignore = 0;
+    if (!(args >> ignore)) {
+      error = "expected 0 or 1";
+      return false;
+    }
+    SimBle::setIgnoreParamUpdates(ignore != 0);
+    return true;
+  }
+
+  if (command == "ble-subscribe-delay") {
+    uint32_t ms = 0;
+    if (!(args >> ms)) {
+      error = "expected milliseconds";
+      return false;
+    }
+    SimBle::setSubscribeDelay(ms);
+    return true;
+  }
+
+  if (command == "ble-congest") {
+    unsigned buffers = 0;
+    if (!(args >> buffers)) {
+      error = "expected TX buffers per connection event (0: unlimited)";
+      return false;
+    }
+    SimBle::setTxBuffers(buffers);
+    return true;
+  }
+
+  if (command == "ble-params") {
+    uint16_t interval, latency, timeout;
+    SimBle::connParams(interval, latency, timeout);
+    printf("[SIM] conn params: interval %u x 1.25 ms, latency %u, timeout %u x 10 ms\n",
+           interval, latency, timeout);
+    return true;
+  }
+
+  if (command == "expect-params") {
+    unsigned interval = 0;
+    unsigned latency = 0;
+    if (!(args >> interval >> latency)) {
+      error = "expected interval (1.25 ms units) and latency";
+      return false;
+    }
+    // Updates land on the BLE host thread; give them the same time as a report
+    uint16_t current, currentLatency, timeout;
+    for (uint32_t waited = 0;; waited++) {
+      SimBle::connParams(current, currentLatency, timeout);
+      if ((current == interval && currentLatency == latency) || waited >= SIM_EXPECT_TIMEOUT_MS) {
+        break;
+      }
+      delay(1);
+    }
+    if (current != interval || currentLatency != latency) {
+      printf("  expected interval %u latency %u, got interval %u latency %u\n", interval, latency, current,
+             currentLatency);
+      error = "connection parameter mismatch";
+      return false;
+    }
+    return true;
+  }
+
+  if (command == "ble-led") {
+    std::vector<uint8_t> bytes;
+    if (!parse_hex(args, bytes) || bytes.size() != 1) {
+      error = "expected one LED byte";
+      return false;
+    }
+    SimBle::writeOutputReport(0x01, bytes[0]);
+    return true;
+  }
+
+  if (command == "serial") {
+    std::string text;
+    std::getline(args >> std::ws, text);
+    text += '\n';
+    SimArduino::feedSerialInput(text.data(), text.size());
+    return true;
+  }
+
+  if (command == "adc") {
+    unsigned millivolts = 0;
+    if (!(args >> millivolts) || millivolts > 3300) {
+      error = "expected millivolts (0-3300)";
+      return false;
+    }
+    SimArduino::setAnalogValue((uint16_t)(millivolts * 4095 / 3300), millivolts);
+    return true;
+  }
+
+  if (command == "battery") {
+    printf("[SIM] battery level %u%%, set %u times, notified %u times\n", SimBle::batteryLevel(),
+           (unsigned)SimBle::batteryUpdates(), (unsigned)SimBle::batteryNotifies());
+    return true;
+  }
+
+  if (command == "wait") {
+    uint32_t ms = 0;
+    args >> ms;
+    delay(ms);
+    return true;
+  }
+
+  if (command == "expect") {
+    std::vector<uint8_t> expected;
+    if (!parse_hex(args, expected) || expected.empty()) {
+      error = "expected report id and bytes";
+      return false;
+    }
+    const uint8_t reportId = expected[0];
+    expected.erase(expected.begin());
+
+    SimBleReport report;
+    if (!SimBle::waitForReports(expect_cursor + 1, SIM_EXPECT_TIMEOUT_MS) ||
+        !SimBle::getReport(expect_cursor, report)) {
+      error = "no BLE report";
+      return false;
+    }
+    expect_cursor++;
+    if (report.reportId != reportId || report.data != expected) {
+      printf("  expected id %02X:", reportId);
+      print_hex(expected);
+      printf("\n  got      id %02X:", report.reportId);
+      print_hex(report.data);
+      printf("\n");
+      error = "BLE report mismatch";
+      return false;
+    }
+    return true;
+  }
+
+  if (command == "skip") {
+    uint32_t count = 0;
+    if (!(args >> count)) {
+      error = "expected a number of notifications";
+      return false;
+    }
+    if (!SimBle::waitForReports(expect_cursor + count, SIM_EXPECT_TIMEOUT_MS)) {
+      error = "fewer BLE reports than skipped";
+      return false;
+    }
+    expect_cursor += count;
+    return true;
+  }
+
+  if (command == "expect-none") {
+    uint32_t ms = 0;
+    args >> ms;
+    if (SimBle::waitForReports(expect_cursor + 1, ms)) {
+      SimBleReport report;
+      SimBle::getReport(expect_cursor, report);
+      printf("  unexpected id %02X:", report.reportId);
+      print_hex(report.data);
+      printf("\n");
+      error = "unexpected BLE report";
+      return false;
+    }
+    return true;
+  }
+
+  if (command == "dump") {
+    SimBle::writeReports(stdout);
+    return true;
+  }
+
+  if (command == "latency") {
+    LatencyStats::dump(print_line);
+    return true;
+  }
+
+  error = "unknown command '" + command + "'";
+  return false;
+}
+
+bool SimScript::run(FILE *in, const char *name) {
+  char buf[512];
+  int lineNumber = 0;
+
+  while (fgets(buf, sizeof(buf), in) != nullptr) {
+    lineNumber++;
+    std::string line(buf);
+    size_t comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+
+    std::istringstream args(line);
+    std::string command;
+    if (!(args >> command)) {
+      continue;
+    }
+
+    std::string error;
+    if (!run_command(command, args, error)) {
+      fflush(stdout);
+      fprintf(stderr, "%s:%d: %s\n", name, lineNumber, error.c_str());
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file SimScript.h
+ * @brief Line-based scripts that drive the simulated USB devices and BLE central.
+ *
+ * One command per line, '#' starts a comment, numbers are decimal and
+ * report bytes are hex:
+ *
+ *   usb-connect <name> keyboard|mouse|consumer|descriptor <hex...>
+ *                                   (keyboard [hex...]: a boot keyboard with that descriptor)
+ *   usb-disconnect <name>
+ *   report <name> <hex...>          inject one input report
+ *   ble-connect [address] [bond]    fails unless the firmware advertises to this central
+ *   ble-adv                         print the advertised address and mode
+ *   ble-adv-timeout                 end a timed (directed) advertising run
+ *   ble-disconnect
+ *   ble-led <hex>                   central writes the keyboard LED report
+ *   ble-min-interval <n>            central raises requested intervals below n x 1.25 ms
+ *   ble-ignore-params 0|1           central leaves parameter update requests unanswered
+ *   ble-subscribe-delay <ms>        central subscribes to the input reports ms after connecting
+ *   ble-congest <n>                 link carries n notifications per connection event (0: unlimited)
+ *   ble-params                      print the current connection parameters
+ *   expect-params <interval> <latency>  connection interval (1.25 ms units) and latency
+ *                                   must match (waits up to 200 ms)
+ *   serial <text>                   feed a line (text and newline) to Serial.read()
+ *   adc <millivolts>                calibrated reading of every ADC pin (battery divider input)
+ *   battery                         print the BLE battery level and how often it was set and notified
+ *   wait <ms>
+ *   expect <report id> <hex...>     next BLE notification must match (waits up to 200 ms)
+ *   skip <n>                        step over the next n notifications (e.g. the
+ *                                   5-report state sync after every connect)
+ *   expect-none <ms>                no BLE notification within ms
+ *   dump                            print all BLE notifications so far (CSV)
+ *   latency                         print the latency histograms
+ *
+ * A failed expectation stops the script and is reported with its line number.
+ */
+
+#ifndef SIM_SCRIPT_H
+#define SIM_SCRIPT_H
+
+#include <stdio.h>
+
+class SimScript {
+public:
+  /// Runs a script from a stream. Returns false on the first failed command.
+  static bool run(FILE *in, const char *name);
+};
+
+#endif // SIM_SCRIPT_H
@@ -0,0 +1,230 @@
+#include "SimUsbHost.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string.h>
+#include <thread>
+
+extern "C" {
+#include "hid_host.h"
+#include "usb/usb_host.h"
+}
+
+struct SimHidInterface {
+  hid_host_dev_params_t params;
+  std::vector<uint8_t> descriptor;
+  hid_host_interface_event_cb_t callback = nullptr;
+  void *callbackArg = nullptr;
+  bool open = false;
+  std::atomic<bool> started{false};
+  uint8_t protocol = HID_REPORT_PROTOCOL_REPORT;
+  // Report being delivered by inject(), read back by the interface callback
+  const uint8_t *pendingData = nullptr;
+  size_t pendingLength = 0;
+};
+
+static std::mutex host_lock;
+static hid_host_driver_event_cb_t driver_callback = nullptr;
+static void *driver_callback_arg = nullptr;
+static uint8_t next_address = 1;
+
+static SimHidInterface *to_interface(hid_host_device_handle_t handle) {
+  return (SimHidInterface *)handle;
+}
+
+// ---------------------------------------------------------------------------
+// hid_host / usb_host fake
+// ---------------------------------------------------------------------------
+
+esp_err_t usb_host_install(const usb_host_config_t *config) {
+  return ESP_OK;
+}
+
+esp_err_t usb_host_lib_handle_events(uint32_t timeout_ticks, uint32_t *event_flags_ret) {
+  *event_flags_ret = 0;
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      timeout_ticks == 0xFFFFFFFFu ? 1000 : timeout_ticks));
+  return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t usb_host_device_free_all(void) {
+  return ESP_OK;
+}
+
+esp_err_t hid_host_install(const hid_host_driver_config_t *config) {
+  std::lock_guard<std::mutex> lock(host_lock);
+  driver_callback = config->callback;
+  driver_callback_arg = config->callback_arg;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_uninstall(void) {
+  std::lock_guard<std::mutex> lock(host_lock);
+  driver_callback = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_device_open(hid_host_device_handle_t hid_dev_handle,
+                               const hid_host_device_config_t *config) {
+  SimHidInterface *iface = to_interface(hid_dev_handle);
+  iface->callback = config->callback;
+  iface->callbackArg = config->callback_arg;
+  iface->open = true;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_device_close(hid_host_device_handle_t hid_dev_handle) {
+  SimHidInterface *iface = to_interface(hid_dev_handle);
+  iface->open = false;
+  iface->started = false;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_device_start(hid_host_device_handle_t hid_dev_handle) {
+  SimHidInterface *iface = to_interface(hid_dev_handle);
+  if (!iface->open) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  iface->started = true;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_device_stop(hid_host_device_handle_t hid_dev_handle) {
+  to_interface(hid_dev_handle)->started = false;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_device_get_params(hid_host_device_handle_t hid_dev_handle,
+                                     hid_host_dev_params_t *dev_params) {
+  *dev_params = to_interface(hid_dev_handle)->params;
+  return ESP_OK;
+}
+
+esp_err_t hid_host_device_get_raw_input_report_data(hid_host_device_handle_t hid_dev_handle,
+                                                    uint8_t *data, size_t data_length_max,
+                                                    size_t *data_length) {
+  SimHidInterface *iface = to_interface(hid_dev_handle);
+  if (iface->pendingData == nullptr) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  size_t length = iface->pendingLength;
+  if (length > data_length_max) {
+    length = data_length_max;
+  }
+  memcpy(data, iface->pendingData, length);
+  *data_length = length;
+  return ESP_OK;
+}
+
+uint8_t *hid_host_get_report_descriptor(hid_host_device_handle_t hid_dev_handle,
+                                        size_t *report_desc_len) {
+  SimHidInterface *iface = to_interface(hid_dev_handle);
+  *report_desc_len = iface->descriptor.size();
+  return iface->descriptor.empty() ? nullptr : iface->descriptor.data();
+}
+
+esp_err_t hid_class_request_set_protocol(hid_host_device_handle_t hid_dev_handle,
+                                         hid_report_protocol_t protocol) {
+  to_interface(hid_dev_handle)->protocol = (uint8_t)protocol;
+  return ESP_OK;
+}
+
+esp_err_t hid_class_request_set_idle(hid_host_device_handle_t hid_dev_handle,
+                                     uint8_t duration, uint8_t report_id) {
+  return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Simulated devices
+// ---------------------------------------------------------------------------
+
+SimHidInterfaceConfig SimUsbHost::bootKeyboard() {
+  return {HID_SUBCLASS_BOOT_INTERFACE, HID_PROTOCOL_KEYBOARD, {}};
+}
+
+SimHidInterfaceConfig SimUsbHost::bootMouse() {
+  return {HID_SUBCLASS_BOOT_INTERFACE, HID_PROTOCOL_MOUSE, {}};
+}
+
+SimHidInterfaceConfig SimUsbHost::consumerControl() {
+  return {HID_SUBCLASS_NO_SUBCLASS,
+          HID_PROTOCOL_NONE,
+          {
+              0x05, 0x0C,       // USAGE_PAGE (Consumer)
+              0x09, 0x01,       // USAGE (Consumer Control)
+              0xA1, 0x01,       // COLLECTION (Application)
+              0x85, 0x03,       //   REPORT_ID (3)
+              0x15, 0x00,       //   LOGICAL_MINIMUM (0)
+              0x26, 0xFF, 0x03, //   LOGICAL_MAXIMUM (0x3FF)
+              0x19, 0x00,       //   USAGE_MINIMUM (0)
+              0x2A, 0xFF, 0x03, //   USAGE_MAXIMUM (0x3FF)
+              0x75, 0x10,       //   REPORT_SIZE (16)
+              0x95, 0x01,       //   REPORT_COUNT (1)
+              0x81, 0x00,       //   INPUT (Data,Array,Abs)
+              0xC0,             // END_COLLECTION
+          }};
+}
+
+hid_host_device_handle_t SimUsbHost::connect(const SimHidInterfaceConfig &config,
+                                             uint32_t timeoutMs) {
+  hid_host_driver_event_cb_t callback;
+  void *callbackArg;
+  SimHidInterface *iface = new SimHidInterface();
+  {
+    std::lock_guard<std::mutex> lock(host_lock);
+    callback = driver_callback;
+    callbackArg = driver_callback_arg;
+    iface->params.addr = next_address++;
+  }
+  if (callback == nullptr) {
+    return nullptr;
+  }
+
+  iface->params.iface_num = 0;
+  iface->params.sub_class = config.subClass;
+  iface->params.proto = config.protocol;
+  iface->descriptor = config.descriptor;
+
+  callback(iface, HID_HOST_DRIVER_EVENT_CONNECTED, callbackArg);
+
+  // USBManager handles the event on its own task; wait for it to start the interface
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (!iface->started) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return nullptr;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  return iface;
+}
+
+bool SimUsbHost::inject(hid_host_device_handle_t handle, const uint8_t *data, size_t length) {
+  SimHidInterface *iface = to_interface(handle);
+  if (iface == nullptr || !iface->started || iface->callback == nullptr) {
+    return false;
+  }
+  iface->pendingData = data;
+  iface->pendingLength = length;
+  iface->callback(handle, HID_HOST_INTERFACE_EVENT_INPUT_REPORT, iface->callbackArg);
+  iface->pendingData = nullptr;
+  return true;
+}
+
+void SimUsbHost::transferError(hid_host_device_handle_t handle) {
+  SimHidInterface *iface = to_interface(handle);
+  if (iface != nullptr && iface->callback != nullptr) {
+    iface->callback(handle, HID_HOST_INTERFACE_EVENT_TRANSFER_ERROR, iface->callbackArg);
+  }
+}
+
+void SimUsbHost::disconnect(hid_host_device_handle_t handle) {
+  // The interface is never freed: stale handles may still sit in USBManager's ring
+  SimHidInterface *iface = to_interface(handle);
+  if (iface != nullptr && iface->open && iface->callback != nullptr) {
+    iface->callback(handle, HID_HOST_INTERFACE_EVENT_DISCONNECTED, iface->callbackArg);
+  }
+}
+
+uint8_t SimUsbHost::protocol(hid_host_device_handle_t handle) {
+  return to_interface(handle)->protocol;
+}
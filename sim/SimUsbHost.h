@@ -0,0 +1,58 @@
+/**
+ * @file SimUsbHost.h
+ * @brief Simulated USB HID devices behind the hid_host fake.
+ *
+ * The calling thread plays the role of the HID driver task: connect() raises
+ * the driver CONNECTED event and waits until USBManager has opened and
+ * started the interface, and inject() delivers an input report through the
+ * interface callback exactly like a completed IN transfer.
+ */
+
+#ifndef SIM_USB_HOST_H
+#define SIM_USB_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+typedef void *hid_host_device_handle_t;
+
+/** @brief What a simulated interface looks like on the bus. */
+struct SimHidInterfaceConfig {
+  uint8_t subClass;                ///< HID_SUBCLASS_BOOT_INTERFACE or 0
+  uint8_t protocol;                ///< HID_PROTOCOL_KEYBOARD / MOUSE / NONE
+  std::vector<uint8_t> descriptor; ///< Report descriptor (non-boot interfaces)
+};
+
+class SimUsbHost {
+public:
+  /// Boot protocol keyboard (8-byte reports).
+  static SimHidInterfaceConfig bootKeyboard();
+
+  /// Boot protocol mouse (buttons, X, Y, wheel).
+  static SimHidInterfaceConfig bootMouse();
+
+  /// Report protocol consumer control with report ID 3 and one 16-bit usage.
+  static SimHidInterfaceConfig consumerControl();
+
+  /**
+   * @brief Plugs in an interface and waits until USBManager has started it.
+   * @return Interface handle, nullptr if it was not started within timeoutMs
+   */
+  static hid_host_device_handle_t connect(const SimHidInterfaceConfig &config,
+                                          uint32_t timeoutMs = 1000);
+
+  /// Delivers one input report on the calling thread (the "HID driver task").
+  static bool inject(hid_host_device_handle_t handle, const uint8_t *data, size_t length);
+
+  /// Raises a transfer error on the interface.
+  static void transferError(hid_host_device_handle_t handle);
+
+  /// Unplugs the interface.
+  static void disconnect(hid_host_device_handle_t handle);
+
+  /// Protocol last selected with SET_PROTOCOL (HID_REPORT_PROTOCOL_*).
+  static uint8_t protocol(hid_host_device_handle_t handle);
+};
+
+#endif // SIM_USB_HOST_H
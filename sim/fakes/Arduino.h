@@ -0,0 +1,101 @@
+/**
+ * @file Arduino.h
+ * @brief Host fake of the Arduino-ESP32 core subset used by the bridge.
+ *
+ * Serial writes to stdout and reads from an injectable input buffer, time
+ * comes from the host steady clock, and analog reads return a value set by
+ * the simulation.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+typedef enum {
+  ADC_0db,
+  ADC_2_5db,
+  ADC_6db,
+  ADC_11db
+} adc_attenuation_t;
+
+uint16_t analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+void analogSetAttenuation(adc_attenuation_t attenuation);
+
+/** @brief Stand-in for the USB CDC / UART serial port. */
+class SimSerial {
+public:
+  void begin(unsigned long baud) {}
+  void end() {}
+  operator bool() const { return true; }
+
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *data, size_t len);
+  size_t print(const char *s);
+  size_t print(const std::string &s) { return print(s.c_str()); }
+  size_t print(char c);
+  size_t print(long n);
+  size_t print(unsigned long n);
+  size_t print(int n) { return print((long)n); }
+  size_t print(unsigned int n) { return print((unsigned long)n); }
+  size_t print(double n);
+  size_t println() { return print("\n"); }
+
+  template <typename T>
+  size_t println(const T &value) {
+    size_t n = print(value);
+    return n + println();
+  }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void flush();
+
+  int available();
+  int read();
+  int peek();
+};
+
+extern SimSerial Serial;
+
+/** @brief Hooks the simulation uses to drive the Arduino fake. */
+namespace SimArduino {
+/// Queues bytes to be returned by Serial.read().
+void feedSerialInput(const char *data, size_t len);
+
+/// Value returned by analogRead() (raw, 12-bit) and analogReadMilliVolts().
+void setAnalogValue(uint16_t raw, uint32_t millivolts);
+
+/// Redirects Serial output; nullptr silences it.
+void setSerialOutput(FILE *out);
+} // namespace SimArduino
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,7 @@
+#ifndef SIM_NIMBLE_DESCRIPTOR_H
+#define SIM_NIMBLE_DESCRIPTOR_H
+
+// The NimBLE fake lives in a single header
+#include "NimBLEDevice.h"
+
+#endif // SIM_NIMBLE_DESCRIPTOR_H
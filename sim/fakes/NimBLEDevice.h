@@ -0,0 +1,244 @@
+/**
+ * @file NimBLEDevice.h
+ * @brief Host fake of the NimBLE-Arduino 2.x API subset used by BleDevice.
+ *
+ * There is no radio: notify() hands the characteristic value to SimBle
+ * (sim/SimBle.h), which timestamps and records it, and SimBle drives the
+ * server callbacks to simulate a central connecting, disconnecting or
+ * writing the keyboard LED output report.
+ */
+
+#ifndef SIM_NIMBLE_DEVICE_H
+#define SIM_NIMBLE_DEVICE_H
+
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define HID_KEYBOARD 0x03C1
+#define HID_MOUSE 0x03C2
+#define HID_JOYSTICK 0x03C3
+
+#define BLE_ADDR_PUBLIC 0
+#define BLE_ADDR_RANDOM 1
+#define BLE_OWN_ADDR_PUBLIC 0
+#define BLE_OWN_ADDR_RANDOM 1
+#define BLE_GAP_CONN_MODE_NON 0
+#define BLE_GAP_CONN_MODE_DIR 1
+#define BLE_GAP_CONN_MODE_UND 2
+
+class NimBLEServer;
+class NimBLECharacteristic;
+
+class NimBLEUUID {
+public:
+  NimBLEUUID(uint16_t uuid = 0) : _uuid(uuid) {}
+  uint16_t value() const { return _uuid; }
+
+private:
+  uint16_t _uuid;
+};
+
+/** @brief Address bytes are little-endian; toString() prints them most significant first. */
+class NimBLEAddress {
+public:
+  NimBLEAddress(const std::string &address = "00:00:00:00:00:00", uint8_t type = BLE_ADDR_PUBLIC)
+      : _type(type) {
+    unsigned b[6] = {};
+    sscanf(address.c_str(), "%x:%x:%x:%x:%x:%x", &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]);
+    for (int i = 0; i < 6; i++) {
+      _val[i] = (uint8_t)b[i];
+    }
+  }
+  NimBLEAddress(const uint8_t address[6], uint8_t type) : _type(type) {
+    memcpy(_val, address, 6);
+  }
+
+  std::string toString() const {
+    char text[18];
+    snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x", _val[5], _val[4], _val[3],
+             _val[2], _val[1], _val[0]);
+    return text;
+  }
+  const uint8_t *getVal() const { return _val; }
+  uint8_t getType() const { return _type; }
+  bool operator==(const NimBLEAddress &other) const {
+    return _type == other._type && memcmp(_val, other._val, 6) == 0;
+  }
+
+private:
+  uint8_t _val[6] = {};
+  uint8_t _type;
+};
+
+/** @brief Connection parameters of the simulated link. */
+class NimBLEConnInfo {
+public:
+  NimBLEAddress getAddress() const { return _address; }
+  NimBLEAddress getIdAddress() const { return _address; }
+  bool isBonded() const { return _bonded; }
+  uint16_t getConnHandle() const { return _handle; }
+  uint16_t getConnInterval() const { return _interval; }
+  uint16_t getConnLatency() const { return _latency; }
+  uint16_t getConnTimeout() const { return _timeout; }
+  uint16_t getMTU() const { return _mtu; }
+
+  NimBLEAddress _address;
+  uint16_t _handle = 1;
+  uint16_t _interval = 24; ///< 1.25 ms units (30 ms)
+  uint16_t _latency = 0;
+  uint16_t _timeout = 400; ///< 10 ms units
+  uint16_t _mtu = 23;
+  bool _bonded = false;
+};
+
+class NimBLECharacteristicCallbacks {
+public:
+  virtual ~NimBLECharacteristicCallbacks() {}
+  virtual void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) {}
+  /// A notification finished (code 0) or failed; called from the stack's task.
+  virtual void onStatus(NimBLECharacteristic *pCharacteristic, int code) {}
+  /// The central wrote the CCCD (subValue 1: notifications) or restored it for a bond.
+  virtual void onSubscribe(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo,
+                           uint16_t subValue) {}
+};
+
+class NimBLECharacteristic {
+public:
+  NimBLECharacteristic(uint8_t reportId, bool input) : _reportId(reportId), _input(input) {}
+
+  void setCallbacks(NimBLECharacteristicCallbacks *callbacks) { _callbacks = callbacks; }
+  NimBLECharacteristicCallbacks *getCallbacks() const { return _callbacks; }
+
+  void setValue(const uint8_t *data, size_t length) { _value.assign(data, data + length); }
+  std::string getValue() const { return std::string(_value.begin(), _value.end()); }
+
+  /// Records the current value in the SimBle sink if a central is connected
+  /// and the simulated link has a TX buffer free (see SimBle::setTxBuffers).
+  bool notify();
+
+  uint8_t reportId() const { return _reportId; }
+  bool isInput() const { return _input; }
+
+private:
+  uint8_t _reportId;
+  bool _input;
+  std::vector<uint8_t> _value;
+  NimBLECharacteristicCallbacks *_callbacks = nullptr;
+};
+
+class NimBLEService {
+public:
+  NimBLEUUID getUUID() const { return NimBLEUUID(0x1812); }
+};
+
+class NimBLEAdvertising {
+public:
+  typedef std::function<void(NimBLEAdvertising *)> advCompleteCB_t;
+
+  bool setName(const std::string &name) { _name = name; return true; }
+  void setAppearance(uint16_t appearance) {}
+  void addServiceUUID(const NimBLEUUID &uuid) {}
+  void enableScanResponse(bool enable) {}
+  void setConnectableMode(uint8_t mode) { _mode = mode; }
+  void setMinInterval(uint16_t interval) {}
+  void setMaxInterval(uint16_t interval) {}
+  void setAdvertisingCompleteCallback(advCompleteCB_t callback) { _onComplete = callback; }
+
+  /// Directed when dirAddr is given; SimBle::advertisingTimeout() ends a timed run.
+  bool start(uint32_t duration = 0, const NimBLEAddress *dirAddr = nullptr);
+  bool stop() { _advertising = false; return true; }
+  bool isAdvertising() const { return _advertising; }
+  const std::string &getName() const { return _name; }
+  bool isDirected() const { return _directed; }
+  const NimBLEAddress &getDirectedAddress() const { return _directedAddress; }
+  uint32_t getDuration() const { return _duration; }
+
+  /// Ends advertising the way the controller would on a timeout.
+  void complete();
+
+private:
+  std::string _name;
+  bool _advertising = false;
+  uint8_t _mode = BLE_GAP_CONN_MODE_UND;
+  bool _directed = false;
+  NimBLEAddress _directedAddress;
+  uint32_t _duration = 0;
+  advCompleteCB_t _onComplete;
+};
+
+class NimBLEServerCallbacks {
+public:
+  virtual ~NimBLEServerCallbacks() {}
+  virtual void onConnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo) {}
+  virtual void onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo, int reason) {}
+  virtual void onMTUChange(uint16_t MTU, NimBLEConnInfo &connInfo) {}
+  virtual void onConnParamsUpdate(NimBLEConnInfo &connInfo) {}
+  virtual void onAuthenticationComplete(NimBLEConnInfo &connInfo) {}
+};
+
+class NimBLEServer {
+public:
+  void setCallbacks(NimBLEServerCallbacks *callbacks, bool deleteCallbacks = true) {
+    _callbacks = callbacks;
+  }
+  NimBLEServerCallbacks *getCallbacks() const { return _callbacks; }
+  NimBLEAdvertising *getAdvertising() { return &_advertising; }
+  bool startAdvertising() { return _advertising.start(); }
+  void advertiseOnDisconnect(bool enable) {}
+  bool disconnect(uint16_t connHandle, uint8_t reason = 0x13);
+  bool updateConnParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval,
+                        uint16_t latency, uint16_t timeout);
+  size_t getConnectedCount() const;
+
+private:
+  NimBLEServerCallbacks *_callbacks = nullptr;
+  NimBLEAdvertising _advertising;
+};
+
+class NimBLEHIDDevice {
+public:
+  NimBLEHIDDevice(NimBLEServer *server) {}
+
+  NimBLECharacteristic *getInputReport(uint8_t reportId);
+  NimBLECharacteristic *getOutputReport(uint8_t reportId);
+  NimBLECharacteristic *getFeatureReport(uint8_t reportId);
+
+  void setManufacturer(const std::string &name) {}
+  void setPnp(uint8_t sig, uint16_t vid, uint16_t pid, uint16_t version) {}
+  void setHidInfo(uint8_t country, uint8_t flags) {}
+  void setReportMap(uint8_t *map, uint16_t size);
+  void startServices() {}
+  void setBatteryLevel(uint8_t level, bool notify = false);
+  NimBLEService *getHidService() { return &_hidService; }
+
+private:
+  std::map<uint8_t, NimBLECharacteristic *> _inputReports;
+  std::map<uint8_t, NimBLECharacteristic *> _outputReports;
+  NimBLEService _hidService;
+};
+
+class NimBLEDevice {
+public:
+  static void init(const std::string &deviceName);
+  static NimBLEServer *createServer();
+  static NimBLEServer *getServer();
+  static NimBLEAdvertising *getAdvertising() { return getServer()->getAdvertising(); }
+  static void setSecurityAuth(bool bonding, bool mitm, bool sc) {}
+  static void setPower(int8_t dbm) {}
+  static bool setDeviceName(const std::string &deviceName);
+  static bool setOwnAddrType(uint8_t type) { return true; }
+  static bool setOwnAddr(const uint8_t *addr);
+  static NimBLEAddress getAddress();
+
+  // Bonds live in SimBle
+  static bool isBonded(const NimBLEAddress &address);
+  static bool deleteBond(const NimBLEAddress &address);
+  static int getNumBonds();
+};
+
+#endif // SIM_NIMBLE_DEVICE_H
@@ -0,0 +1,7 @@
+#ifndef SIM_NIMBLE_HID_DEVICE_H
+#define SIM_NIMBLE_HID_DEVICE_H
+
+// The NimBLE fake lives in a single header
+#include "NimBLEDevice.h"
+
+#endif // SIM_NIMBLE_HID_DEVICE_H
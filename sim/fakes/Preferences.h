@@ -0,0 +1,63 @@
+/**
+ * @file Preferences.h
+ * @brief Host fake of the Arduino-ESP32 Preferences (NVS) API.
+ *
+ * Values live in process memory, keyed by namespace and key, so they
+ * survive a simulated re-init of the firmware objects but not the process.
+ */
+
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false) {
+    _namespace = name;
+    _readOnly = readOnly;
+    return true;
+  }
+  void end() { _namespace.clear(); }
+
+  size_t putBytes(const char *key, const void *value, size_t len) {
+    if (_readOnly || _namespace.empty()) {
+      return 0;
+    }
+    const uint8_t *bytes = static_cast<const uint8_t *>(value);
+    store()[_namespace + "/" + key].assign(bytes, bytes + len);
+    return len;
+  }
+
+  size_t getBytesLength(const char *key) {
+    auto it = store().find(_namespace + "/" + key);
+    return it == store().end() ? 0 : it->second.size();
+  }
+
+  size_t getBytes(const char *key, void *buf, size_t maxLen) {
+    auto it = store().find(_namespace + "/" + key);
+    if (it == store().end() || it->second.size() > maxLen) {
+      return 0;
+    }
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+  bool remove(const char *key) { return store().erase(_namespace + "/" + key) > 0; }
+
+private:
+  static std::map<std::string, std::vector<uint8_t>> &store() {
+    static std::map<std::string, std::vector<uint8_t>> values;
+    return values;
+  }
+
+  std::string _namespace;
+  bool _readOnly = false;
+};
+
+#endif // SIM_PREFERENCES_H
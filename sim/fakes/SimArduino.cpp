@@ -0,0 +1,137 @@
+#include "Arduino.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <stdarg.h>
+#include <thread>
+
+SimSerial Serial;
+
+static const auto start_time = std::chrono::steady_clock::now();
+
+static std::mutex serial_lock;
+static FILE *serial_out = stdout;
+static std::deque<uint8_t> serial_in;
+
+static uint16_t analog_raw = 2048;
+static uint32_t analog_millivolts = 1300;
+
+int64_t esp_timer_get_time(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start_time)
+      .count();
+}
+
+unsigned long millis() {
+  return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)esp_timer_get_time();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+uint16_t analogRead(uint8_t pin) {
+  return analog_raw;
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin) {
+  return analog_millivolts;
+}
+
+void analogReadResolution(uint8_t bits) {}
+
+void analogSetAttenuation(adc_attenuation_t attenuation) {}
+
+size_t SimSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t SimSerial::write(const uint8_t *data, size_t len) {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  if (serial_out == nullptr) {
+    return len;
+  }
+  return fwrite(data, 1, len, serial_out);
+}
+
+size_t SimSerial::print(const char *s) {
+  return write((const uint8_t *)s, strlen(s));
+}
+
+size_t SimSerial::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t SimSerial::print(long n) {
+  return printf("%ld", n);
+}
+
+size_t SimSerial::print(unsigned long n) {
+  return printf("%lu", n);
+}
+
+size_t SimSerial::print(double n) {
+  return printf("%.2f", n);
+}
+
+size_t SimSerial::printf(const char *format, ...) {
+  char buf[512];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return write((const uint8_t *)buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+}
+
+void SimSerial::flush() {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  if (serial_out != nullptr) {
+    fflush(serial_out);
+  }
+}
+
+int SimSerial::available() {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  return (int)serial_in.size();
+}
+
+int SimSerial::read() {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  if (serial_in.empty()) {
+    return -1;
+  }
+  int c = serial_in.front();
+  serial_in.pop_front();
+  return c;
+}
+
+int SimSerial::peek() {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  return serial_in.empty() ? -1 : serial_in.front();
+}
+
+void SimArduino::feedSerialInput(const char *data, size_t len) {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  serial_in.insert(serial_in.end(), data, data + len);
+}
+
+void SimArduino::setAnalogValue(uint16_t raw, uint32_t millivolts) {
+  analog_raw = raw;
+  analog_millivolts = millivolts;
+}
+
+void SimArduino::setSerialOutput(FILE *out) {
+  std::lock_guard<std::mutex> lock(serial_lock);
+  serial_out = out;
+}
@@ -0,0 +1,242 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SimTask {
+  std::string name;
+  std::mutex lock;
+  std::condition_variable wake;
+  uint32_t notifyCount = 0;
+  uint32_t id = 0;
+  UBaseType_t priority = 0;
+  BaseType_t core = tskNO_AFFINITY;
+  clockid_t clock;
+  std::atomic<bool> clockReady{false};
+};
+
+struct SimQueue {
+  std::mutex lock;
+  std::condition_variable changed;
+  std::deque<std::vector<uint8_t>> items;
+  size_t length;
+  size_t itemSize;
+};
+
+struct SimSemaphore {
+  std::mutex lock;
+  std::condition_variable changed;
+  bool taken = false;
+};
+
+static thread_local TaskHandle_t current_task = nullptr;
+static std::mutex task_list_lock;
+static std::vector<TaskHandle_t> task_list;
+static const auto start_time = std::chrono::steady_clock::now();
+
+// Waits on cv until pred() holds or the tick timeout expires; portMAX_DELAY waits forever
+template <typename Pred>
+static bool wait_ticks(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                       TickType_t ticks, Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t coreId) {
+  TaskHandle_t task = new SimTask();
+  task->name = name != nullptr ? name : "";
+  task->priority = priority;
+  task->core = coreId;
+  {
+    std::lock_guard<std::mutex> lock(task_list_lock);
+    task_list.push_back(task);
+    task->id = (uint32_t)task_list.size();
+  }
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  std::thread([fn, arg, task]() {
+    current_task = task;
+    if (pthread_getcpuclockid(pthread_self(), &task->clock) == 0) {
+      task->clockReady.store(true, std::memory_order_release);
+    }
+    fn(arg);
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (current_task == nullptr) {
+    current_task = new SimTask();
+    current_task->name = "main";
+  }
+  return current_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->lock);
+  if (!wait_ticks(task->wake, lock, ticksToWait, [task] { return task->notifyCount > 0; })) {
+    return 0;
+  }
+  const uint32_t count = task->notifyCount;
+  task->notifyCount = clearCountOnExit ? 0 : count - 1;
+  return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  if (task == nullptr) {
+    return pdFAIL;
+  }
+  {
+    std::lock_guard<std::mutex> lock(task->lock);
+    task->notifyCount++;
+  }
+  task->wake.notify_one();
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t period) {
+  *previousWake += period;
+  const TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(*previousWake - now) > 0) {
+    vTaskDelay(*previousWake - now);
+  }
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start_time)
+      .count();
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  QueueHandle_t queue = new SimQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait) {
+  if (queue == nullptr) {
+    return pdFAIL;
+  }
+  std::unique_lock<std::mutex> lock(queue->lock);
+  if (!wait_ticks(queue->changed, lock, ticksToWait,
+                  [queue] { return queue->items.size() < queue->length; })) {
+    return pdFAIL;
+  }
+  const uint8_t *bytes = (const uint8_t *)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  lock.unlock();
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait) {
+  if (queue == nullptr) {
+    vTaskDelay(ticksToWait == portMAX_DELAY ? 1 : ticksToWait);
+    return pdFAIL;
+  }
+  std::unique_lock<std::mutex> lock(queue->lock);
+  if (!wait_ticks(queue->changed, lock, ticksToWait,
+                  [queue] { return !queue->items.empty(); })) {
+    return pdFAIL;
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  lock.unlock();
+  queue->changed.notify_all();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  if (queue == nullptr) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(queue->lock);
+  return (UBaseType_t)queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+  if (queue == nullptr) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(queue->lock);
+  return (UBaseType_t)(queue->length - queue->items.size());
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new SimSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+  if (semaphore == nullptr) {
+    return pdFAIL;
+  }
+  std::unique_lock<std::mutex> lock(semaphore->lock);
+  if (!wait_ticks(semaphore->changed, lock, ticksToWait,
+                  [semaphore] { return !semaphore->taken; })) {
+    return pdFAIL;
+  }
+  semaphore->taken = true;
+  return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  if (semaphore == nullptr) {
+    return pdFAIL;
+  }
+  {
+    std::lock_guard<std::mutex> lock(semaphore->lock);
+    if (!semaphore->taken) {
+      return pdFAIL;
+    }
+    semaphore->taken = false;
+  }
+  semaphore->changed.notify_one();
+  return pdPASS;
+}
+
+std::vector<SimFreeRTOS::TaskInfo> SimFreeRTOS::tasks() {
+  std::vector<TaskInfo> result;
+  std::lock_guard<std::mutex> lock(task_list_lock);
+  for (TaskHandle_t task : task_list) {
+    TaskInfo info;
+    info.name = task->name;
+    info.id = task->id;
+    info.priority = task->priority;
+    info.core = task->core;
+    info.cpuUs = 0;
+    timespec used;
+    if (task->clockReady.load(std::memory_order_acquire) && clock_gettime(task->clock, &used) == 0) {
+      info.cpuUs = (uint64_t)used.tv_sec * 1000000 + used.tv_nsec / 1000;
+    }
+    result.push_back(info);
+  }
+  return result;
+}
@@ -0,0 +1,21 @@
+#ifndef SIM_TFT_ESPI_H
+#define SIM_TFT_ESPI_H
+
+#include <stdint.h>
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+
+/** @brief Text-only stand-in for the TFT driver; drawing calls are ignored. */
+class TFT_eSPI {
+public:
+  void init() {}
+  void setRotation(uint8_t r) {}
+  void fillScreen(uint32_t color) {}
+  void setTextColor(uint16_t fg, uint16_t bg) {}
+  void setTextSize(uint8_t size) {}
+  void setCursor(int16_t x, int16_t y) {}
+  int printf(const char *format, ...) { return 0; }
+};
+
+#endif // SIM_TFT_ESPI_H
@@ -0,0 +1,6 @@
+#ifndef SIM_DRIVER_ADC_H
+#define SIM_DRIVER_ADC_H
+
+// Nothing from the legacy ADC driver is used by the simulated sources yet.
+
+#endif // SIM_DRIVER_ADC_H
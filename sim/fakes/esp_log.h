@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_LOG_H
+#define SIM_ESP_LOG_H
+
+#include <stdio.h>
+
+// All levels go to stdout; the simulation is run with full debug logging
+#define SIM_ESP_LOG(letter, tag, format, ...) printf(letter " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) SIM_ESP_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) SIM_ESP_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) SIM_ESP_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) SIM_ESP_LOG("D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) SIM_ESP_LOG("V", tag, format, ##__VA_ARGS__)
+
+#endif // SIM_ESP_LOG_H
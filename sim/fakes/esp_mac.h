@@ -0,0 +1,29 @@
+/**
+ * @file esp_mac.h
+ * @brief Host fake of the ESP-IDF MAC address API.
+ */
+
+#ifndef SIM_ESP_MAC_H
+#define SIM_ESP_MAC_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+  ESP_MAC_WIFI_STA,
+  ESP_MAC_WIFI_SOFTAP,
+  ESP_MAC_BT,
+  ESP_MAC_ETH,
+} esp_mac_type_t;
+
+/// A fixed Espressif-range MAC; the last byte is the interface type like on a chip.
+inline esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+  const uint8_t base[6] = {0x24, 0x58, 0x7C, 0x00, 0x5A, 0x10};
+  for (int i = 0; i < 6; i++) {
+    mac[i] = base[i];
+  }
+  mac[5] += (uint8_t)type;
+  return ESP_OK;
+}
+
+#endif // SIM_ESP_MAC_H
@@ -0,0 +1,13 @@
+#ifndef SIM_FREERTOS_SEMPHR_H
+#define SIM_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct SimSemaphore *SemaphoreHandle_t;
+
+/// A mutex semaphore; like FreeRTOS, taking it twice from one task blocks.
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif // SIM_FREERTOS_SEMPHR_H
@@ -0,0 +1,39 @@
+#ifndef SIM_FREERTOS_TASK_H
+#define SIM_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+#include <string>
+#include <vector>
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t coreId);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle);
+
+/// Creates a handle for threads the fake did not start (e.g. main) on first use.
+TaskHandle_t xTaskGetCurrentTaskHandle();
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t period);
+TickType_t xTaskGetTickCount();
+
+/** @brief Hooks the simulation uses to inspect the fake. */
+namespace SimFreeRTOS {
+struct TaskInfo {
+  std::string name;
+  uint32_t id;
+  UBaseType_t priority;
+  BaseType_t core; ///< As passed to xTaskCreatePinnedToCore
+  uint64_t cpuUs;  ///< CPU time the task's thread has used
+};
+
+/// Tasks started through xTaskCreate*, in creation order.
+std::vector<TaskInfo> tasks();
+} // namespace SimFreeRTOS
+
+#endif // SIM_FREERTOS_TASK_H
@@ -0,0 +1,90 @@
+/**
+ * @file hid_host.h
+ * @brief Host fake of the ESP32 USB Host HID driver API.
+ *
+ * Interfaces are created and driven by SimUsbHost (sim/SimUsbHost.h); this
+ * header only mirrors the C API that USBManager calls. The event enums are
+ * plain integers so they match the forward declarations in USBManager.h.
+ */
+
+#ifndef SIM_HID_HOST_H
+#define SIM_HID_HOST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef void *hid_host_device_handle_t;
+typedef unsigned int hid_host_driver_event_t;
+typedef unsigned int hid_host_interface_event_t;
+
+#define HID_HOST_DRIVER_EVENT_CONNECTED 0u
+
+#define HID_HOST_INTERFACE_EVENT_INPUT_REPORT 0u
+#define HID_HOST_INTERFACE_EVENT_TRANSFER_ERROR 1u
+#define HID_HOST_INTERFACE_EVENT_DISCONNECTED 2u
+
+#define HID_SUBCLASS_NO_SUBCLASS 0x00
+#define HID_SUBCLASS_BOOT_INTERFACE 0x01
+
+#define HID_PROTOCOL_NONE 0x00
+#define HID_PROTOCOL_KEYBOARD 0x01
+#define HID_PROTOCOL_MOUSE 0x02
+
+typedef enum {
+  HID_REPORT_PROTOCOL_BOOT = 0x00,
+  HID_REPORT_PROTOCOL_REPORT = 0x01,
+} hid_report_protocol_t;
+
+typedef void (*hid_host_driver_event_cb_t)(hid_host_device_handle_t hid_device_handle,
+                                           const hid_host_driver_event_t event, void *arg);
+
+typedef void (*hid_host_interface_event_cb_t)(hid_host_device_handle_t hid_device_handle,
+                                              const hid_host_interface_event_t event,
+                                              void *arg);
+
+typedef struct {
+  bool create_background_task;
+  size_t task_priority;
+  size_t stack_size;
+  int core_id;
+  hid_host_driver_event_cb_t callback;
+  void *callback_arg;
+} hid_host_driver_config_t;
+
+typedef struct {
+  hid_host_interface_event_cb_t callback;
+  void *callback_arg;
+} hid_host_device_config_t;
+
+typedef struct {
+  uint8_t addr;
+  uint8_t iface_num;
+  uint8_t sub_class;
+  uint8_t proto;
+} hid_host_dev_params_t;
+
+esp_err_t hid_host_install(const hid_host_driver_config_t *config);
+esp_err_t hid_host_uninstall(void);
+
+esp_err_t hid_host_device_open(hid_host_device_handle_t hid_dev_handle,
+                               const hid_host_device_config_t *config);
+esp_err_t hid_host_device_close(hid_host_device_handle_t hid_dev_handle);
+esp_err_t hid_host_device_start(hid_host_device_handle_t hid_dev_handle);
+esp_err_t hid_host_device_stop(hid_host_device_handle_t hid_dev_handle);
+
+esp_err_t hid_host_device_get_params(hid_host_device_handle_t hid_dev_handle,
+                                     hid_host_dev_params_t *dev_params);
+esp_err_t hid_host_device_get_raw_input_report_data(hid_host_device_handle_t hid_dev_handle,
+                                                    uint8_t *data, size_t data_length_max,
+                                                    size_t *data_length);
+uint8_t *hid_host_get_report_descriptor(hid_host_device_handle_t hid_dev_handle,
+                                        size_t *report_desc_len);
+
+esp_err_t hid_class_request_set_protocol(hid_host_device_handle_t hid_dev_handle,
+                                         hid_report_protocol_t protocol);
+esp_err_t hid_class_request_set_idle(hid_host_device_handle_t hid_dev_handle,
+                                     uint8_t duration, uint8_t report_id);
+
+#endif // SIM_HID_HOST_H
@@ -0,0 +1,12 @@
+#ifndef SIM_HID_USAGE_KEYBOARD_H
+#define SIM_HID_USAGE_KEYBOARD_H
+
+// Subset of the ESP-IDF keyboard usage IDs referenced by the simulated sources.
+enum {
+  HID_KEY_1 = 0x1E,
+  HID_KEY_2 = 0x1F,
+  HID_KEY_3 = 0x20,
+  HID_KEY_SCROLL_LOCK = 0x47,
+};
+
+#endif // SIM_HID_USAGE_KEYBOARD_H
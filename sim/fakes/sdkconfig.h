@@ -0,0 +1,7 @@
+#ifndef SIM_SDKCONFIG_H
+#define SIM_SDKCONFIG_H
+
+// Host simulation: no ESP-IDF configuration. CONFIG_ARDUHAL_ESP_LOG is left
+// undefined so sources fall back to esp_log.h.
+
+#endif // SIM_SDKCONFIG_H
@@ -0,0 +1,25 @@
+#ifndef SIM_USB_USB_HOST_H
+#define SIM_USB_USB_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_INTR_FLAG_LEVEL1 (1 << 1)
+
+#define USB_HOST_LIB_EVENT_FLAGS_NO_CLIENTS 0x01
+#define USB_HOST_LIB_EVENT_FLAGS_ALL_FREE 0x02
+
+typedef struct {
+  bool skip_phy_setup;
+  int intr_flags;
+} usb_host_config_t;
+
+esp_err_t usb_host_install(const usb_host_config_t *config);
+
+/// The simulated host library never has events; this just blocks for the timeout.
+esp_err_t usb_host_lib_handle_events(uint32_t timeout_ticks, uint32_t *event_flags_ret);
+
+esp_err_t usb_host_device_free_all(void);
+
+#endif // SIM_USB_USB_HOST_H
@@ -0,0 +1,3 @@
+// The bridge sources are parked as .hx/.cppx so the device build skips them;
+// the simulation builds them through these forwarding headers.
+#include "../../srcs/Bridge.hx"
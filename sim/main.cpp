@@ -0,0 +1,1435 @@
+/**
+ * @file main.cpp
+ * @brief Native simulation of the USB-to-BLE bridge.
+ *
+ * Runs Bridge against the hid_host and NimBLE fakes, then either plays a
+ * script (see SimScript.h) or runs the keyboard throughput benchmark.
+ *
+ *   program --script typing.sim [--csv reports.csv] [--quiet]
+ *   program --bench 10000 [--interval-us 1000] [--congest 1] [--quiet]
+ *   program --bench-parse 1000000
+ *   program --test-notify
+ *   program --test-governor
+ *   program --test-ring 1000000
+ *   program --test-keys
+ *   program --bench-keys 1000000
+ *   program --bench-keymap 100000
+ *   program --test-keymap-example
+ *   program --bench-inject 3
+ *   program --bench-display 100
+ *   program --bench-gif 200
+ *   program --bench-assets assets.bin
+ *   program --joystick-trace trace.csv
+ *   program --test-pointer
+ *   program --bench-pointer 1000000
+ *   program --bench-reconnect 20
+ *
+ * The exit status is non-zero if a script expectation fails or the
+ * benchmark host misses key edges that no input ring overflow accounts
+ * for, so runs can gate CI.
+ */
+
+#include <Arduino.h>
+#include "AssetBundle.h"
+#include "BinLog.h"
+#include "Bridge.h"
+#include "ConnParamGovernor.h"
+#include "Display.h"
+#include "GifBandRenderer.h"
+#include "HidReportParser.h"
+#include "JoystickFilter.h"
+#include "KeymapDefault.h"
+#include "LatencyStats.h"
+#include "Metrics.h"
+#include "NotifyScheduler.h"
+#include "PointerIntegrator.h"
+#include "ReplayBuffer.h"
+#include "SimBle.h"
+#include "SimScript.h"
+#include "SimUsbHost.h"
+#include "SpriteCache.h"
+#include "SpscRing.h"
+#include "TextInjector.h"
+#include "USBManager.h"
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void loop_task(void *arg) {
+  // The Arduino loop task
+  while (true) {
+    Bridge::loop();
+    vTaskDelay(1);
+  }
+}
+
+static void print_line(const char *line) {
+  printf("%s\n", line);
+}
+
+// Key presses and releases the host saw: bit changes in the NKRO reports
+static void host_key_edges(uint32_t &presses, uint32_t &releases) {
+  presses = releases = 0;
+  uint8_t held[KEY_NKRO_REPORT_SIZE] = {};
+  SimBleReport report;
+  for (size_t i = 0; SimBle::getReport(i, report); i++) {
+    if (report.reportId != 0x05 || report.data.size() != KEY_NKRO_REPORT_SIZE) {
+      continue;
+    }
+    for (size_t b = 1; b < KEY_NKRO_REPORT_SIZE; b++) {
+      presses += __builtin_popcount(report.data[b] & ~held[b]);
+      releases += __builtin_popcount(held[b] & ~report.data[b]);
+      held[b] = report.data[b];
+    }
+  }
+}
+
+static bool run_benchmark(uint32_t count, uint32_t intervalUs) {
+  hid_host_device_handle_t keyboard = SimUsbHost::connect(SimUsbHost::bootKeyboard());
+  if (keyboard == nullptr) {
+    fprintf(stderr, "bench: keyboard was not started\n");
+    return false;
+  }
+  SimBle::connect();
+  delay(10);
+  SimBle::clearReports();
+  LatencyStats::reset();
+  USBManager::resetInputStats();
+
+  // Alternate press and release of 'a' so every report changes the state
+  const uint8_t press[8] = {0, 0, 0x04, 0, 0, 0, 0, 0};
+  const uint8_t release[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+  const int64_t start = esp_timer_get_time();
+  int64_t next = start;
+  for (uint32_t i = 0; i < count; i++) {
+    while (esp_timer_get_time() < next) {
+    }
+    SimUsbHost::inject(keyboard, (i & 1) ? release : press, 8);
+    next += intervalUs;
+  }
+  // Every report changes the key, so the host must see one edge per report.
+  // Nothing slows the injection down: past what the link carries the input
+  // ring overflows, and each report it drops may hide two edges (its own and
+  // the one undoing it), never more. The newest report is never lost, so the
+  // host ends with the key released
+  notify_stats_t notifyStats = {};
+  uint32_t presses = 0;
+  uint32_t releases = 0;
+  bool complete = false;
+  for (int waited = 0; waited < 2000 && !complete; waited++) {
+    notifyStats = Bridge::getNotifyStats();
+    host_key_edges(presses, releases);
+    complete = presses + releases + 2 * USBManager::getInputStats().overflows >= count &&
+               presses == releases;
+    if (!complete) {
+      delay(1);
+    }
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  const size_t notified = SimBle::reportCount();
+  usb_input_stats_t stats = USBManager::getInputStats();
+  printf("[BENCH] %u reports injected, %u notified in %lld us (%.0f reports/s)\n",
+         (unsigned)count, (unsigned)notified, (long long)elapsed,
+         elapsed > 0 ? notified * 1e6 / elapsed : 0.0);
+  printf("[BENCH] input ring high-watermark %u/%u, overflows %u, resyncs %u\n", stats.highWatermark,
+         stats.capacity, stats.overflows, stats.resyncs);
+  printf("[BENCH] notify: %u flushes, %u coalesced, %u waits on a full queue\n",
+         (unsigned)notifyStats.flushes, (unsigned)notifyStats.coalesced[NOTIFY_KEYBOARD],
+         (unsigned)notifyStats.refused[NOTIFY_KEYBOARD]);
+  printf("[BENCH] host saw %u of %u key edges\n", (unsigned)(presses + releases), (unsigned)count);
+  if (SimBle::txRefused() > 0) {
+    const Metric *retries = Metrics::find("ble.notify_retries");
+    const Metric *drops = Metrics::find("ble.held_drops");
+    printf("[BENCH] congested link: %u notifications refused, %u retries, %u held reports dropped\n",
+           (unsigned)SimBle::txRefused(),
+           retries ? (unsigned)static_cast<const MetricCounter *>(retries)->value() : 0u,
+           drops ? (unsigned)static_cast<const MetricCounter *>(drops)->value() : 0u);
+  }
+  // The host must end up with the key released, whatever was dropped on the way
+  SimBleReport last;
+  const bool released = notified > 0 && SimBle::getReport(notified - 1, last) &&
+                        std::all_of(last.data.begin(), last.data.end(), [](uint8_t b) { return b == 0; });
+  if (!released) {
+    printf("[BENCH] the host was left with a key held\n");
+  }
+  LatencyStats::dump(print_line);
+  return complete && released;
+}
+
+// Descriptor corpus: one input report per descriptor and what it must decode to
+struct ParseCase {
+  const char *name;
+  std::vector<uint8_t> descriptor; ///< Empty: the boot keyboard plan
+  std::vector<uint8_t> report;
+  const char *expect;
+};
+
+static std::vector<ParseCase> parse_corpus() {
+  std::vector<uint8_t> nkroReport(34, 0);
+  nkroReport[0] = 0x01;       // Report ID
+  nkroReport[1] = 0x02;       // Left Shift
+  nkroReport[2] = 0x10;       // A (0x04)
+  nkroReport[2 + 31] = 0x80;  // 0xFF, the last bit of the bitmap
+  return {
+      {"boot keyboard", {}, {0x02, 0x00, 0x04, 0x05, 0x00, 0x00, 0x00, 0x00}, "mod 02 keys 04 05"},
+      {"256-bit NKRO bitmap",
+       {0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,
+        0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x19, 0x00, 0x2A, 0xFF, 0x00, 0x96, 0x00, 0x01,
+        0x81, 0x02, 0xC0},
+       nkroReport,
+       "mod 02 keys 04 FF"},
+      {"16-bit mouse with report ID",
+       {0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x02, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19, 0x01,
+        0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x05, 0x81, 0x02, 0x75, 0x03, 0x95, 0x01,
+        0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x16, 0x01, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10,
+        0x95, 0x02, 0x81, 0x06, 0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06,
+        0xC0, 0xC0},
+       {0x02, 0x11, 0x2C, 0x01, 0xD4, 0xFE, 0xFF},
+       "buttons 11 x 300 y -300 wheel -1"},
+      {"buttons from usage 0",
+       {0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09, 0x19, 0x00, 0x29, 0x03,
+        0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x04, 0x81, 0x02, 0x95, 0x04, 0x81, 0x01, 0x05, 0x01,
+        0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06, 0xC0, 0xC0},
+       {0x0E, 0x05, 0xFB},
+       "buttons 07 x 5 y -5 wheel 0"},
+      {"16-bit consumer array", SimUsbHost::consumerControl().descriptor, {0x03, 0xE9, 0x00}, "consumer 00E9"},
+  };
+}
+
+static std::string describe_decoded(const HidDecodedReport &report) {
+  std::string text;
+  char part[64]; // The mouse line with every delta at its widest needs 42
+  if (report.kinds & HID_REPORT_KIND_KEYBOARD) {
+    snprintf(part, sizeof(part), "mod %02X keys", report.modifiers);
+    text += part;
+    for (int key = 0; key < 256; key++) {
+      if (report.keys.test(key)) {
+        snprintf(part, sizeof(part), " %02X", key);
+        text += part;
+      }
+    }
+  }
+  if (report.kinds & HID_REPORT_KIND_MOUSE) {
+    snprintf(part, sizeof(part), "buttons %02X x %d y %d wheel %d", report.buttons, report.x, report.y,
+             report.wheel);
+    text += part;
+  }
+  if (report.kinds & HID_REPORT_KIND_CONSUMER) {
+    text += "consumer";
+    for (uint8_t i = 0; i < report.consumerCount; i++) {
+      snprintf(part, sizeof(part), " %04X", report.consumer[i]);
+      text += part;
+    }
+  }
+  return text;
+}
+
+static bool run_parse_benchmark(uint32_t count) {
+  const std::vector<ParseCase> corpus = parse_corpus();
+  std::vector<HidInterfacePlan> plans(corpus.size());
+  bool ok = true;
+
+  // Every descriptor must parse and its report decode to the expected content
+  const int64_t parseStart = esp_timer_get_time();
+  for (size_t i = 0; i < corpus.size(); i++) {
+    const ParseCase &c = corpus[i];
+    if (c.descriptor.empty()) {
+      hidBuildBootKeyboardPlan(plans[i]);
+    } else if (!hidParseReportDescriptor(c.descriptor.data(), c.descriptor.size(), plans[i])) {
+      printf("[BENCH] parse: %s: descriptor rejected\n", c.name);
+      ok = false;
+    }
+  }
+  const int64_t parseUs = esp_timer_get_time() - parseStart;
+
+  HidDecodedReport decoded;
+  for (size_t i = 0; i < corpus.size(); i++) {
+    const ParseCase &c = corpus[i];
+    const bool known = hidDecodeReport(plans[i], c.report.data(), c.report.size(), decoded);
+    const std::string got = known ? describe_decoded(decoded) : "unknown report ID";
+    if (got != c.expect) {
+      printf("[BENCH] parse: %s: expected \"%s\", got \"%s\"\n", c.name, c.expect, got.c_str());
+      ok = false;
+    }
+  }
+
+  // Decode cost per report, round robin over the corpus
+  uint32_t checksum = 0;
+  const int64_t start = esp_timer_get_time();
+  for (uint32_t i = 0; i < count; i++) {
+    const size_t n = i % corpus.size();
+    hidDecodeReport(plans[n], corpus[n].report.data(), corpus[n].report.size(), decoded);
+    checksum += decoded.modifiers + decoded.buttons + decoded.consumerCount;
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  printf("[BENCH] parse: %u descriptors in %lld us, %u reports decoded in %lld us (%.1f ns/report, checksum %u)%s\n",
+         (unsigned)corpus.size(), (long long)parseUs, (unsigned)count, (long long)elapsed,
+         count > 0 ? elapsed * 1000.0 / count : 0.0, (unsigned)checksum, ok ? "" : " FAILED");
+  return ok;
+}
+
+// An item as large as a USB input event, filled so that a torn copy shows
+struct RingItem {
+  uint32_t sequence;
+  uint8_t payload[60];
+};
+
+static bool run_ring_test(uint32_t count) {
+  // A small ring so the producer keeps finding it full and the indices wrap often
+  static SpscRing<RingItem, 16> ring;
+  uint32_t mismatches = 0;
+  uint32_t retries = 0;
+
+  const int64_t start = esp_timer_get_time();
+  std::thread consumer([&]() {
+    RingItem item;
+    uint32_t expected = 0;
+    while (expected < count) {
+      if (!ring.pop(item)) {
+        std::this_thread::yield();
+        continue;
+      }
+      bool intact = item.sequence == expected;
+      for (uint8_t b : item.payload) {
+        intact = intact && b == (uint8_t)item.sequence;
+      }
+      if (!intact) {
+        mismatches++;
+      }
+      expected = item.sequence + 1;
+    }
+  });
+  for (uint32_t i = 0; i < count; i++) {
+    RingItem item;
+    item.sequence = i;
+    memset(item.payload, (uint8_t)i, sizeof(item.payload));
+    while (!ring.push(item)) {
+      retries++;
+      std::this_thread::yield();
+    }
+  }
+  consumer.join();
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  const bool ok = mismatches == 0 && ring.size() == 0;
+  printf("[TEST] ring: %u items through a %u-slot ring in %lld us, %u full retries, high watermark %u, "
+         "%u out of order or torn: %s\n",
+         (unsigned)count, (unsigned)ring.capacity(), (long long)elapsed, (unsigned)retries,
+         (unsigned)ring.highWatermark(), (unsigned)mismatches, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static KeyBitmap key_bitmap(std::initializer_list<uint8_t> keys) {
+  KeyBitmap bitmap;
+  bitmap.clear();
+  for (uint8_t key : keys) {
+    bitmap.set(key);
+  }
+  return bitmap;
+}
+
+static bool check(bool condition, const char *what) {
+  if (!condition) {
+    printf("[TEST] %s: FAILED\n", what);
+  }
+  return condition;
+}
+
+// KeyStateEngine edges across sources and KeyReportBuilder report bytes
+static bool run_key_state_test() {
+  KeyStateEngine engine;
+  KeyStateDiff diff;
+  bool ok = true;
+
+  ok &= check(engine.update(0, 0x00, key_bitmap({0x04, 0x05}), diff) && diff.pressedCount == 2,
+              "two keys pressed");
+  ok &= check(!engine.update(0, 0x00, key_bitmap({0x05, 0x04}), diff), "same keys in other slots are no change");
+  ok &= check(engine.update(0, 0x02, key_bitmap({0x05}), diff) && diff.releasedCount == 1 &&
+                  diff.released.test(0x04) && diff.pressedCount == 0 && diff.modifiersPressed == 0x02,
+              "release and modifier press in one report");
+  ok &= check(engine.update(1, 0x00, key_bitmap({0x05, 0xFF}), diff) && diff.pressedCount == 1 &&
+                  diff.pressed.test(0xFF),
+              "second source adds only its new key");
+  ok &= check(engine.update(0, 0x00, key_bitmap({}), diff) && diff.releasedCount == 0 &&
+                  diff.modifiersReleased == 0x02,
+              "key still held by the other source is not released");
+  ok &= check(engine.releaseSource(1, diff) && diff.releasedCount == 2 && engine.keys().empty(),
+              "unplugged source releases its keys");
+
+  KeyReportBuilder builder;
+  uint8_t boot[KEY_BOOT_REPORT_SIZE];
+  uint8_t nkro[KEY_NKRO_REPORT_SIZE];
+  builder.build(0x02, key_bitmap({0x04, KEY_NKRO_MAX_USAGE, 0x87}), true, boot, nkro);
+  ok &= check(nkro[0] == 0x02 && nkro[1] == 0x10 && nkro[KEY_NKRO_REPORT_SIZE - 1] == 0x80,
+              "NKRO bitmap carries modifiers, 0x04 and the top usage");
+  ok &= check(boot[0] == 0 && boot[2] == 0x87 && boot[3] == 0, "usages above the bitmap go in the boot report");
+
+  builder.reset();
+  builder.build(0x00, key_bitmap({0x04, 0x05, 0xFF}), false, boot, nkro);
+  ok &= check(boot[2] == 0x04 && boot[3] == 0x05 && boot[4] == 0xFF, "boot report carries usages up to 0xFF");
+  builder.build(0x00, key_bitmap({0x05, 0xFF}), false, boot, nkro);
+  ok &= check(boot[2] == 0x00 && boot[3] == 0x05 && boot[4] == 0xFF, "held keys keep their boot slot");
+  builder.build(0x00, key_bitmap({0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A}), false, boot, nkro);
+  ok &= check(boot[2] == KEY_ERROR_ROLLOVER && boot[7] == KEY_ERROR_ROLLOVER, "seven keys report ErrorRollOver");
+
+  printf("[TEST] key state: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static bool run_key_state_benchmark(uint32_t count) {
+  // Rolling typing: every report presses one key and releases the one pressed three reports before
+  KeyStateEngine engine;
+  KeyReportBuilder builder;
+  KeyStateDiff diff;
+  uint8_t boot[KEY_BOOT_REPORT_SIZE];
+  uint8_t nkro[KEY_NKRO_REPORT_SIZE];
+  uint32_t edges = 0;
+  const int64_t start = esp_timer_get_time();
+  for (uint32_t i = 0; i < count; i++) {
+    KeyBitmap keys;
+    keys.clear();
+    for (uint32_t k = 0; k < 3; k++) {
+      keys.set((uint8_t)(0x04 + (i + k) % 0x60));
+    }
+    if (engine.update(0, (uint8_t)(i & 0x02), keys, diff)) {
+      edges += diff.pressedCount + diff.releasedCount;
+      builder.build(engine.modifiers(), engine.keys(), true, boot, nkro);
+    }
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  printf("[BENCH] key state: %u reports in %lld us (%.1f ns/report), %u key edges\n", (unsigned)count,
+         (long long)elapsed, count > 0 ? elapsed * 1000.0 / count : 0.0, (unsigned)edges);
+  return true;
+}
+
+// Taps far faster than the link drains them: a full keyboard queue must refuse the push,
+// the producer retries after the next connection event, and every edge reaches the output
+static bool run_notify_test() {
+  const uint32_t taps = 200;
+  NotifyScheduler scheduler;
+  NotifyItem items[NOTIFY_MAX_ITEMS_PER_EVENT];
+  const LatencyTrace trace = {};
+  int64_t nowUs = 0;
+  KeyBitmap sent;
+  sent.clear();
+  uint32_t presses = 0;
+  uint32_t releases = 0;
+  uint32_t retries = 0;
+
+  auto drainOneEvent = [&]() {
+    nowUs += scheduler.connectionInterval();
+    const uint8_t count = scheduler.collect(nowUs, items, NOTIFY_MAX_ITEMS_PER_EVENT);
+    for (uint8_t i = 0; i < count; i++) {
+      if (items[i].type != NOTIFY_KEYBOARD) {
+        continue;
+      }
+      for (int w = 0; w < KEY_BITMAP_WORDS; w++) {
+        presses += __builtin_popcount(items[i].keys.words[w] & ~sent.words[w]);
+        releases += __builtin_popcount(sent.words[w] & ~items[i].keys.words[w]);
+      }
+      sent = items[i].keys;
+    }
+  };
+
+  for (uint32_t i = 0; i < 2 * taps; i++) {
+    KeyBitmap keys;
+    keys.clear();
+    if (i % 2 == 0) {
+      keys.set((uint8_t)(0x04 + (i / 2) % 26));
+    }
+    while (!scheduler.pushKeyboard(0, keys, trace)) {
+      retries++;
+      drainOneEvent();
+    }
+  }
+  while (scheduler.pending()) {
+    drainOneEvent();
+  }
+
+  const notify_stats_t &stats = scheduler.stats();
+  const bool ok = presses == taps && releases == taps && retries > 0 &&
+                  stats.refused[NOTIFY_KEYBOARD] == retries && sent.empty();
+  printf("[TEST] notify: %u taps, host saw %u presses and %u releases, %u pushes refused and retried: %s\n",
+         (unsigned)taps, (unsigned)presses, (unsigned)releases, (unsigned)retries, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static bool same_params(const conn_params_t &a, const conn_params_t &b) {
+  return a.minInterval == b.minInterval && a.maxInterval == b.maxInterval && a.latency == b.latency &&
+         a.timeout == b.timeout;
+}
+
+// ConnParamGovernor on simulated time: every transition of the default config, then
+// rejections and host choices with the idle levels pushed out of the way
+static bool run_governor_test() {
+  const conn_governor_config_t defaults = connGovernorDefaultConfig();
+  const conn_params_t hostDefault = {24, 24, 0, 400}; // What a host typically starts with
+  conn_params_t request = {};
+  bool ok = true;
+
+  // Settle delay, tighten, both idle step-downs and the way back
+  ConnParamGovernor governor;
+  governor.onConnect(0, hostDefault);
+  ok &= check(governor.msUntilDue(0) == defaults.connectSettleMs, "first request due after the settle delay");
+  ok &= check(!governor.poll(defaults.connectSettleMs - 1, request), "no request while the host settles");
+  ok &= check(governor.poll(defaults.connectSettleMs, request) && same_params(request, defaults.active),
+              "the active level is requested after the settle delay");
+  governor.onRequestResult(1000, true);
+  ok &= check(governor.msUntilDue(1000) == defaults.responseTimeoutMs, "an open request is due at its timeout");
+  governor.onParamsUpdated(1010, defaults.active);
+  ok &= check(governor.stats().accepted == 1 && same_params(governor.currentParams(), defaults.active),
+              "the requested parameters are accepted");
+
+  governor.onActivity(1500);
+  ok &= check(governor.msUntilDue(1500) == defaults.idleAfterMs[0], "the first step-down is due after the idle time");
+  ok &= check(!governor.poll(1500 + defaults.idleAfterMs[0] - 1, request), "activity keeps the active level");
+  ok &= check(governor.poll(1500 + defaults.idleAfterMs[0], request) && same_params(request, defaults.idle[0]) &&
+                  governor.targetLevel() == 1,
+              "idle steps down to the first relaxed level");
+  governor.onParamsUpdated(3510, {24, 24, 4, 400});
+  ok &= check(governor.msUntilDue(3510) == defaults.idleAfterMs[1] - 2010, "the second step-down is due next");
+  ok &= check(governor.poll(1500 + defaults.idleAfterMs[1], request) && same_params(request, defaults.idle[1]) &&
+                  governor.targetLevel() == 2,
+              "longer idle steps down to the slowest level");
+  governor.onParamsUpdated(31510, {48, 48, 8, 600});
+  ok &= check(governor.msUntilDue(31510) == UINT32_MAX && governor.stats().relaxed == 2,
+              "at the slowest level only activity changes anything");
+  governor.onActivity(40000);
+  ok &= check(governor.poll(40000, request) && same_params(request, defaults.active) &&
+                  governor.stats().tightened == 1,
+              "the next report re-tightens right away");
+
+  // A target change while a request is in flight: the answer to the old one is
+  // accepted and the new target is requested at once
+  governor.onParamsUpdated(40010, defaults.active);
+  ok &= check(governor.poll(42000, request) && governor.targetLevel() == 1, "idle again, step-down requested");
+  governor.onActivity(42005);
+  governor.onParamsUpdated(42010, {24, 24, 4, 400});
+  ok &= check(governor.stats().accepted == 5 && governor.msUntilDue(42010) == 0,
+              "an answer to a stale target is accepted and the new target is due");
+  ok &= check(governor.poll(42010, request) && same_params(request, defaults.active),
+              "the new target is requested without a retry delay");
+
+  governor.onDisconnect();
+  ok &= check(!governor.poll(50000, request) && governor.msUntilDue(50000) == UINT32_MAX,
+              "nothing is requested without a connection");
+
+  // Refused and unanswered requests, then the retry limit
+  conn_governor_config_t config = defaults;
+  config.idleAfterMs[0] = 100000;
+  config.idleAfterMs[1] = 200000;
+  ConnParamGovernor refused(config);
+  refused.onConnect(0, hostDefault);
+  ok &= check(refused.poll(1000, request), "first request");
+  refused.onRequestResult(1000, false);
+  ok &= check(refused.stats().rejected == 1 && refused.msUntilDue(1000) == config.retryDelayMs,
+              "a refused request is retried after the retry delay");
+  ok &= check(!refused.poll(1000 + config.retryDelayMs - 1, request), "no retry before the delay");
+  ok &= check(refused.poll(1000 + config.retryDelayMs, request) && refused.stats().retries == 1, "first retry");
+  ok &= check(!refused.poll(6000 + config.responseTimeoutMs - 1, request), "an open request waits for its answer");
+  ok &= check(!refused.poll(6000 + config.responseTimeoutMs, request) && refused.stats().rejected == 2,
+              "an unanswered request times out as rejected");
+  ok &= check(refused.poll(9000 + config.retryDelayMs, request) && refused.stats().retries == 2, "second retry");
+  refused.onRequestResult(14000, false);
+  ok &= check(!refused.poll(20000, request) && !refused.poll(90000, request) && refused.stats().requests == 3,
+              "past the retry limit the host's parameters are kept");
+  ok &= check(refused.msUntilDue(20000) == config.idleAfterMs[0] - 20000,
+              "a settled governor is only due at the next step-down");
+  ok &= check(refused.poll(config.idleAfterMs[0], request) && same_params(request, config.idle[0]),
+              "a new target is requested again");
+
+  // The host applies something else (a 15 ms floor): counted as adjusted, retried, then kept
+  ConnParamGovernor adjusted(config);
+  adjusted.onConnect(0, hostDefault);
+  uint32_t nowMs = config.connectSettleMs;
+  for (int i = 0; i <= config.maxRetries; i++) {
+    ok &= check(adjusted.poll(nowMs, request), "the active level is requested from a host with a floor");
+    adjusted.onRequestResult(nowMs, true);
+    adjusted.onParamsUpdated(nowMs + 10, {12, 12, 0, 400});
+    nowMs += 10 + config.retryDelayMs;
+  }
+  ok &= check(adjusted.stats().adjusted == (uint32_t)config.maxRetries + 1 && !adjusted.poll(nowMs, request) &&
+                  adjusted.currentParams().minInterval == 12,
+              "the host's adjusted parameters are kept after the retries");
+
+  printf("[TEST] governor: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static uint32_t keymap_bench_outputs = 0;
+
+static void keymap_bench_output(uint8_t modifiers, const KeyBitmap &keys) {
+  keymap_bench_outputs++;
+}
+
+static bool run_keymap_benchmark(uint32_t count) {
+  // Standalone engine on simulated time: typing with Caps Lock taps and holds and the Fn layer
+  // of the example keymap, which exercises more of the engine than the pass-through default
+  KeymapEngine engine(keymapExample);
+  engine.setOutputCallback(keymap_bench_output);
+  static const uint8_t sequence[][2] = {
+      {0x00, 0x04}, {0x00, 0x00}, {0x00, 0x39}, {0x00, 0x00}, // a, Caps tap
+      {0x00, 0x39}, {0x00, 0x39}, {0x00, 0x39}, {0x00, 0x39}, // Caps held past the term
+      {0x00, 0x65}, {0x00, 0x0B}, {0x00, 0x00}, {0x02, 0x05}, // Menu+H, Shift+b
+      {0x00, 0x00}, {0x00, 0x2C}, {0x00, 0x00}, {0x00, 0x00}, // space
+  };
+  const size_t steps = sizeof(sequence) / sizeof(sequence[0]);
+
+  KeyBitmap keys;
+  uint32_t nowMs = 0;
+  const int64_t start = esp_timer_get_time();
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t *step = sequence[i % steps];
+    keys.clear();
+    if (step[1] == 0x0B) {
+      keys.set(0x65); // Menu stays down while H is pressed
+    }
+    if (step[1] != 0) {
+      keys.set(step[1]);
+    }
+    // 60 ms per step, so the held Caps Lock crosses the tapping term
+    nowMs += 60;
+    engine.update(nowMs, step[0], keys);
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  const keymap_stats_t &stats = engine.stats();
+  printf("[BENCH] keymap: %u reports in %lld us (%.1f ns/report), %u outputs, "
+         "%u taps, %u holds, %u layer changes\n",
+         (unsigned)count, (long long)elapsed, count > 0 ? elapsed * 1000.0 / count : 0.0,
+         (unsigned)keymap_bench_outputs, (unsigned)stats.taps, (unsigned)stats.holds,
+         (unsigned)stats.layerChanges);
+  return stats.updates == count;
+}
+
+static std::string keymap_test_log;
+
+static void keymap_test_output(uint8_t modifiers, const KeyBitmap &keys) {
+  char text[8];
+  snprintf(text, sizeof(text), " %02X", modifiers);
+  keymap_test_log += text;
+  for (int key = 0; key < 256; key++) {
+    if (keys.test(key)) {
+      snprintf(text, sizeof(text), ":%02X", key);
+      keymap_test_log += text;
+    }
+  }
+}
+
+// Feeds the example keymap (-DKEYMAP_EXAMPLE=1) physical states on simulated time and
+// checks the output states after each one ("<modifiers>:<key>..." in emit order)
+static bool run_keymap_example_test() {
+  struct Step {
+    uint32_t atMs;
+    uint8_t modifiers;
+    uint8_t keys[2];
+    const char *expect;
+  };
+  static const Step steps[] = {
+      // Caps Lock tap: Caps Lock on release
+      {0, 0x00, {0x39}, ""},
+      {50, 0x00, {}, " 00:39 00"},
+      // Caps Lock + A within the tapping term: Ctrl+A
+      {1000, 0x00, {0x39}, ""},
+      {1010, 0x00, {0x39, 0x04}, " 01:04"},
+      {1020, 0x00, {}, " 00"},
+      // Caps Lock held past the term: Left Control on its own
+      {2000, 0x00, {0x39}, ""},
+      {2250, 0x00, {0x39}, " 01"},
+      {2260, 0x00, {}, " 00"},
+      // Menu + H: Left Arrow, Menu itself is never sent
+      {3000, 0x00, {0x65}, ""},
+      {3010, 0x00, {0x65, 0x0B}, " 00:50"},
+      {3020, 0x00, {}, " 00"},
+      // Menu + M toggles the Mac layer: Left Alt becomes Left GUI, and back
+      {4000, 0x00, {0x65}, ""},
+      {4005, 0x00, {0x65, 0x10}, ""},
+      {4010, 0x00, {}, ""},
+      {4020, 0x04, {}, " 08"},
+      {4030, 0x00, {}, " 00"},
+      {5000, 0x00, {0x65}, ""},
+      {5005, 0x00, {0x65, 0x10}, ""},
+      {5010, 0x00, {}, ""},
+      {5020, 0x04, {}, " 04"},
+      {5030, 0x00, {}, " 00"},
+      // Both Shifts together: Caps Lock
+      {6000, 0x02, {}, ""},
+      {6010, 0x22, {}, " 00:39"},
+      {6020, 0x00, {}, " 00"},
+      // Shift alone goes out once the combo term expires
+      {7000, 0x02, {}, ""},
+      {7100, 0x02, {}, " 02"},
+      {7110, 0x00, {}, " 00"},
+      // Shift tapped within the combo term: pressed and released, not lost
+      {8000, 0x02, {}, ""},
+      {8020, 0x00, {}, " 02 00"},
+  };
+
+  KeymapEngine engine(keymapExample);
+  engine.setOutputCallback(keymap_test_output);
+  bool ok = true;
+  for (const Step &step : steps) {
+    keymap_test_log.clear();
+    engine.tick(step.atMs);
+    KeyBitmap keys;
+    keys.clear();
+    for (uint8_t key : step.keys) {
+      if (key != 0) {
+        keys.set(key);
+      }
+    }
+    engine.update(step.atMs, step.modifiers, keys);
+    if (keymap_test_log != step.expect) {
+      printf("[TEST] keymap example at %u ms: expected \"%s\", got \"%s\"\n", (unsigned)step.atMs,
+             step.expect, keymap_test_log.c_str());
+      ok = false;
+    }
+  }
+  printf("[TEST] keymap example: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/// Decodes typed text from the NKRO reports like a host would: one new key per report
+static bool decode_typed_text(std::string &text) {
+  char charOf[2][256] = {};
+  for (int c = 1; c < 128; c++) {
+    uint8_t key;
+    uint8_t modifiers;
+    if (textInjectLookup((char)c, key, modifiers)) {
+      charOf[modifiers != 0][key] = (char)c;
+    }
+  }
+
+  uint8_t held[KEY_NKRO_REPORT_SIZE] = {};
+  SimBleReport report;
+  for (size_t i = 0; SimBle::getReport(i, report); i++) {
+    if (report.reportId != 0x05 || report.data.size() < KEY_NKRO_REPORT_SIZE) {
+      continue;
+    }
+    int fresh = 0;
+    for (int key = 0; key <= KEY_NKRO_MAX_USAGE; key++) {
+      const uint8_t bit = (uint8_t)(1u << (key & 7));
+      const bool down = report.data[1 + key / 8] & bit;
+      const bool was = held[1 + key / 8] & bit;
+      if (down && !was) {
+        text += charOf[(report.data[0] & 0x22) != 0][key];
+        fresh++;
+      }
+    }
+    memcpy(held, report.data.data(), KEY_NKRO_REPORT_SIZE);
+    if (fresh > 1) {
+      fprintf(stderr, "bench: report %u presses %d keys at once\n", (unsigned)i, fresh);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool run_inject_pass(const std::string &text, bool packed, double &cps) {
+  SimBle::clearReports();
+  const int64_t start = esp_timer_get_time();
+  size_t queued = 0;
+  while (queued < text.size()) {
+    // The queue takes a few lines at a time; retry once it has drained a bit
+    queued += Bridge::typeText(text.c_str() + queued, packed);
+    delay(10);
+  }
+  for (int waited = 0; waited < 10000 && Bridge::isTyping(); waited++) {
+    delay(1);
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  std::string typed;
+  const bool decoded = decode_typed_text(typed);
+  cps = elapsed > 0 ? text.size() * 1e6 / elapsed : 0.0;
+  printf("[BENCH] inject %s: %u chars, %u reports in %lld us (%.0f chars/s)\n",
+         packed ? "packed" : "naive", (unsigned)text.size(), (unsigned)SimBle::reportCount(),
+         (long long)elapsed, cps);
+  if (!decoded || typed != text) {
+    fprintf(stderr, "bench: %s pass typed \"%s\"\n", packed ? "packed" : "naive", typed.c_str());
+    return false;
+  }
+  return true;
+}
+
+static bool run_inject_benchmark(uint32_t repeat) {
+  SimBle::connect();
+  // Typing keeps the link at the tightest interval the governor asks for
+  delay(1500);
+
+  std::string text;
+  for (uint32_t i = 0; i < repeat; i++) {
+    text += "The quick brown fox jumps over the lazy dog; PACK my box with 5 dozen jugs!\n";
+  }
+  double packedCps = 0;
+  double naiveCps = 0;
+  bool ok = run_inject_pass(text, true, packedCps);
+  ok = run_inject_pass(text, false, naiveCps) && ok;
+  printf("[BENCH] inject: packed is %.2fx naive\n", naiveCps > 0 ? packedCps / naiveCps : 0.0);
+  return ok;
+}
+
+static void run_display_pass(const char *name, uint32_t count, uint32_t gapMs) {
+  // Let the previous pass flush, then count only this one
+  delay(100);
+  const compositor_stats_t before = displayGetStats();
+  const display_image_stats_t imagesBefore = displayGetImageStats();
+  for (uint32_t i = 0; i < count; i++) {
+    displayKeyPressed((char)('a' + i % 26));
+    displayKeyReleased();
+    delay(gapMs);
+  }
+  delay(100);
+  const compositor_stats_t after = displayGetStats();
+  const display_image_stats_t imagesAfter = displayGetImageStats();
+  const display_key_stats_t keys = displayGetKeyStats();
+
+  // The old key task cleared a 240x160 region (clipped to the screen) and drew the glyph
+  // straight to the TFT for every key
+  const DisplayRect screen = {0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT};
+  const uint32_t legacyPerKey = DisplayRect{40, 40, 240, 160}.intersect(screen).area() +
+                                DISPLAY_KEY_W * DISPLAY_KEY_H;
+  const uint32_t pixels = after.pixels - before.pixels;
+  printf("[BENCH] display %s (%u ms/key): %u keys, %u frames, %u pixels (%.0f/key), "
+         "legacy %u/key\n",
+         name, (unsigned)gapMs, (unsigned)count, (unsigned)(after.frames - before.frames),
+         (unsigned)pixels, count > 0 ? (double)pixels / count : 0.0, (unsigned)legacyPerKey);
+  printf("[BENCH] display %s: %u bongo swaps (%u requests dropped), last swap %u px, "
+         "max swap flush %u us\n",
+         name, (unsigned)(imagesAfter.swaps - imagesBefore.swaps),
+         (unsigned)(imagesAfter.dropped - imagesBefore.dropped), (unsigned)imagesAfter.swapPixels,
+         (unsigned)imagesAfter.maxSwapUs);
+  printf("[BENCH] display %s: key render %u us last, %u us max, %u of %u from the atlas (%u KB)\n", name,
+         (unsigned)keys.lastRenderUs, (unsigned)keys.maxRenderUs, (unsigned)keys.atlasRenders,
+         (unsigned)keys.renders, (unsigned)(keys.atlasBytes / 1024));
+}
+
+static bool run_display_benchmark(uint32_t count) {
+  displayStartKeyMonitor();
+  const display_image_stats_t images = displayGetImageStats();
+  printf("[BENCH] display: %u frames cached, %u KB, filled in %u ms\n", images.cache.frames,
+         (unsigned)(images.cache.bytes / 1024), (unsigned)images.decodeMs);
+  run_display_pass("typing", count, 80);
+  run_display_pass("burst", count, 5);
+  return displayGetStats().frames > 0;
+}
+
+// Counts what GIF frames cost the display bus: transactions (one address window and one lock each)
+class GifBenchSink : public DisplaySink {
+public:
+  GifBenchSink(uint16_t *pixels, int16_t width, int16_t height) : _framebuffer(pixels, width, height) {}
+
+  bool begin() override {
+    locks++;
+    return true;
+  }
+  void write(const DisplayRect &rect, const uint16_t *pixels) override {
+    _framebuffer.write(rect, pixels);
+    transactions++;
+    pixelCount += rect.area();
+  }
+  void end() override {}
+
+  uint32_t locks = 0;
+  uint32_t transactions = 0;
+  uint32_t pixelCount = 0;
+
+private:
+  FramebufferSink _framebuffer;
+};
+
+static const int16_t GIF_BENCH_W = 320;
+static const int16_t GIF_BENCH_H = 240;
+static const int16_t GIF_BENCH_SPRITE = 96;
+static const uint8_t GIF_BENCH_TRANSPARENT = 255;
+
+// Like an optimised GIF: a full first frame, then a 96x96 frame rectangle around a moving
+// round sprite, transparent outside it
+static void gif_bench_frame(uint32_t frame, int16_t &x, int16_t &y, int16_t &w, int16_t &h,
+                            uint8_t *indices) {
+  if (frame == 0) {
+    x = 0;
+    y = 0;
+    w = GIF_BENCH_W;
+    h = GIF_BENCH_H;
+    for (int32_t i = 0; i < (int32_t)w * h; i++) {
+      indices[i] = (uint8_t)((i / GIF_BENCH_W + i % GIF_BENCH_W) % 200);
+    }
+    return;
+  }
+  x = (int16_t)((frame * 8) % (GIF_BENCH_W - GIF_BENCH_SPRITE));
+  y = 72;
+  w = GIF_BENCH_SPRITE;
+  h = GIF_BENCH_SPRITE;
+  const int16_t r = GIF_BENCH_SPRITE / 2 - 8;
+  for (int16_t row = 0; row < h; row++) {
+    for (int16_t col = 0; col < w; col++) {
+      const int16_t dx = col - w / 2;
+      const int16_t dy = row - h / 2;
+      indices[row * w + col] =
+          dx * dx + dy * dy <= r * r ? (uint8_t)(200 + (frame + row / 8) % 50) : GIF_BENCH_TRANSPARENT;
+    }
+  }
+}
+
+static bool run_gif_benchmark(uint32_t frames) {
+  static uint16_t palette[256];
+  static uint8_t indices[GIF_BENCH_W * GIF_BENCH_H];
+  static uint16_t reference[GIF_BENCH_W * GIF_BENCH_H];
+  static uint16_t canvas[GIF_BENCH_W * GIF_BENCH_H];
+  static uint16_t lineScreen[GIF_BENCH_W * GIF_BENCH_H];
+  static uint16_t bandScreen[GIF_BENCH_W * GIF_BENCH_H];
+  for (int i = 0; i < 256; i++) {
+    palette[i] = (uint16_t)(i * 0x0101);
+  }
+
+  // Per-line path: every line of the frame rectangle is converted and pushed with its own lock
+  GifBenchSink lineSink(lineScreen, GIF_BENCH_W, GIF_BENCH_H);
+  uint32_t lineUs = 0;
+  for (uint32_t f = 0; f < frames; f++) {
+    int16_t x, y, w, h;
+    gif_bench_frame(f, x, y, w, h, indices);
+    const uint32_t start = micros();
+    for (int16_t row = 0; row < h; row++) {
+      uint16_t line[GIF_BENCH_W];
+      const uint8_t *s = indices + row * w;
+      for (int16_t col = 0; col < w; col++) {
+        const uint16_t below = lineScreen[(y + row) * GIF_BENCH_W + x + col];
+        line[col] = s[col] == GIF_BENCH_TRANSPARENT ? below : palette[s[col]];
+      }
+      lineSink.begin();
+      lineSink.write(DisplayRect{x, (int16_t)(y + row), w, 1}, line);
+      lineSink.end();
+    }
+    lineUs += micros() - start;
+  }
+
+  // Band path
+  GifBenchSink bandSink(bandScreen, GIF_BENCH_W, GIF_BENCH_H);
+  GifBandRenderer renderer(canvas, GIF_BENCH_W, GIF_BENCH_H, 0, 0, bandSink);
+  uint32_t bandUs = 0;
+  for (uint32_t f = 0; f < frames; f++) {
+    int16_t x, y, w, h;
+    gif_bench_frame(f, x, y, w, h, indices);
+    const uint32_t start = micros();
+    for (int16_t row = 0; row < h; row++) {
+      renderer.drawLine(y + row, x, w, indices + row * w, palette, GIF_BENCH_TRANSPARENT);
+    }
+    renderer.endFrame();
+    bandUs += micros() - start;
+
+    for (int16_t row = 0; row < h; row++) {
+      for (int16_t col = 0; col < w; col++) {
+        const uint8_t index = indices[row * w + col];
+        if (index != GIF_BENCH_TRANSPARENT) {
+          reference[(y + row) * GIF_BENCH_W + x + col] = palette[index];
+        }
+      }
+    }
+  }
+
+  const bool same = memcmp(bandScreen, reference, sizeof(reference)) == 0 &&
+                    memcmp(lineScreen, reference, sizeof(reference)) == 0;
+  if (!same) {
+    fprintf(stderr, "bench: GIF band output differs from the reference\n");
+  }
+
+  // Bus estimate for the device: 40 MHz SPI (0.4 us per pixel) plus about 5 us per transaction
+  // for the lock, the address window and the DMA set-up
+  const double lineBusUs = lineSink.pixelCount * 0.4 + lineSink.transactions * 5.0;
+  const double bandBusUs = bandSink.pixelCount * 0.4 + bandSink.transactions * 5.0;
+  const gif_band_stats_t &stats = renderer.stats();
+  printf("[BENCH] gif per-line: %u frames, %.1f transactions/frame, %.1f locks/frame, %.0f px/frame, "
+         "%.1f us CPU/frame, ~%.0f us bus/frame\n",
+         (unsigned)frames, (double)lineSink.transactions / frames, (double)lineSink.locks / frames,
+         (double)lineSink.pixelCount / frames, (double)lineUs / frames, lineBusUs / frames);
+  printf("[BENCH] gif bands: %u frames, %.1f transactions/frame, %.1f locks/frame, %.0f px/frame, "
+         "%.1f us CPU/frame, ~%.0f us bus/frame, %u transparent lines skipped\n",
+         (unsigned)frames, (double)bandSink.transactions / frames, (double)bandSink.locks / frames,
+         (double)bandSink.pixelCount / frames, (double)bandUs / frames, bandBusUs / frames,
+         (unsigned)stats.skippedLines);
+  printf("[BENCH] gif: bands need %.1fx fewer transactions and %.2fx the bus time\n",
+         bandSink.transactions > 0 ? (double)lineSink.transactions / bandSink.transactions : 0.0,
+         lineBusUs > 0 ? bandBusUs / lineBusUs : 0.0);
+  return same;
+}
+
+// Loads a bundle from tools/pack_assets.py the way the firmware does: checks it, then fills a
+// frame cache from every pre-converted image
+static bool run_assets_benchmark(const char *path) {
+  FILE *in = fopen(path, "rb");
+  if (in == nullptr) {
+    fprintf(stderr, "bench: cannot open %s\n", path);
+    return false;
+  }
+  std::vector<uint8_t> image;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+    image.insert(image.end(), chunk, chunk + n);
+  }
+  fclose(in);
+
+  AssetBundle bundle;
+  int64_t start = esp_timer_get_time();
+  if (!bundle.attach(image.data(), (uint32_t)image.size()) || !bundle.verify()) {
+    fprintf(stderr, "bench: %s is not a valid asset bundle or a checksum differs\n", path);
+    return false;
+  }
+  const int64_t verifyUs = esp_timer_get_time() - start;
+  printf("[BENCH] assets: %u files, %u bytes, checked in %u us\n", bundle.count(), (unsigned)bundle.size(),
+         (unsigned)verifyUs);
+
+  static const char *FORMATS[] = {"raw", "rgb565", "rle565"};
+  SpriteCache cache(malloc);
+  uint16_t row[ASSET_MAX_WIDTH];
+  for (uint16_t i = 0; i < bundle.count(); i++) {
+    asset_view_t asset;
+    bundle.get(i, asset);
+    if (asset.format == ASSET_FORMAT_RAW) {
+      printf("[BENCH] assets: %-16s raw %u bytes\n", bundle.name(i), (unsigned)asset.size);
+      continue;
+    }
+    const int frame = cache.add(bundle.name(i), asset.width, asset.height);
+    if (frame < 0) {
+      return false;
+    }
+    start = esp_timer_get_time();
+    AssetPixelReader reader(asset);
+    for (uint16_t y = 0; y < asset.height && reader.read(row, asset.width); y++) {
+      cache.blit(frame, 0, y, asset.width, 1, row);
+    }
+    const int64_t blitUs = esp_timer_get_time() - start;
+    printf("[BENCH] assets: %-16s %s %ux%u, %u bytes (%u as RGB565), filled in %u us\n", bundle.name(i),
+           FORMATS[asset.format], asset.width, asset.height, (unsigned)asset.size,
+           (unsigned)(asset.width * asset.height * 2), (unsigned)blitUs);
+  }
+  return true;
+}
+
+// Mouse mode before PointerIntegrator: filtered counts around 2048, a 100 count deadzone,
+// 0.01 pixels per count and update truncated, at most 10 pixels per update
+static int8_t float_pointer_update(int delta) {
+  if (abs(delta) < 100) {
+    delta = 0;
+  }
+  return constrain((int8_t)(delta * 0.01), -10, 10);
+}
+
+/// Calibrated deflection as filtered counts off centre, for a stick spanning +/-2047 counts
+static int deflection_counts(int16_t deflection) {
+  return (int)deflection * 2047 / JOYSTICK_AXIS_MAX;
+}
+
+// Pixels one axis moves in durationUs, with updates spaced periodUs apart, or 1..2*periodUs
+// apart (pseudo-random, like late wake-ups) when jitter is set
+static int64_t pointer_distance(int16_t deflection, uint32_t durationUs, uint32_t periodUs, bool jitter) {
+  PointerAxis axis;
+  const uint16_t curve[POINTER_CURVE_POINTS] = POINTER_CURVE_DEFAULT;
+  uint32_t seed = 12345;
+  int64_t pixels = 0;
+  for (uint32_t elapsed = 0; elapsed < durationUs;) {
+    uint32_t step = periodUs;
+    if (jitter) {
+      seed = seed * 1103515245 + 12345;
+      step = 1 + (seed >> 8) % (2 * periodUs);
+    }
+    step = std::min(step, durationUs - elapsed);
+    elapsed += step;
+    pixels += axis.update(deflection, step, curve);
+  }
+  return pixels;
+}
+
+// Presses and releases one key; 20 ms per keystroke
+static void type_keystroke(hid_host_device_handle_t keyboard, uint32_t index) {
+  uint8_t press[8] = {0, 0, (uint8_t)(0x04 + index % 26), 0, 0, 0, 0, 0};
+  const uint8_t release[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  SimUsbHost::inject(keyboard, press, 8);
+  delay(10);
+  SimUsbHost::inject(keyboard, release, 8);
+  delay(10);
+}
+
+// Key presses the host saw
+static uint32_t host_keystrokes() {
+  uint32_t presses;
+  uint32_t releases;
+  host_key_edges(presses, releases);
+  return presses;
+}
+
+static bool run_reconnect_benchmark(uint32_t cycles) {
+  const uint32_t subscribeMs = 30;
+  const uint32_t outageMs = 200;
+  hid_host_device_handle_t keyboard = SimUsbHost::connect(SimUsbHost::bootKeyboard());
+  if (keyboard == nullptr) {
+    fprintf(stderr, "bench: keyboard was not started\n");
+    return false;
+  }
+  SimBle::setSubscribeDelay(subscribeMs);
+
+  // Steady typing across link drops: 100 ms connected, a 200 ms outage, and the
+  // reconnect with the host subscribing 30 ms later
+  bool ok = true;
+  const uint32_t windows[] = {REPLAY_DEFAULT_WINDOW_MS, 0};
+  for (uint32_t windowMs : windows) {
+    Bridge::setReplayWindow(windowMs);
+    SimBle::connect();
+    delay(subscribeMs + 20);
+    SimBle::clearReports();
+
+    uint32_t typed = 0;
+    for (uint32_t cycle = 0; cycle < cycles; cycle++) {
+      for (int i = 0; i < 5; i++) {
+        type_keystroke(keyboard, typed++);
+      }
+      SimBle::disconnect();
+      for (uint32_t i = 0; i < outageMs / 20; i++) {
+        type_keystroke(keyboard, typed++);
+      }
+      SimBle::connect();
+      for (int i = 0; i < 5; i++) {
+        type_keystroke(keyboard, typed++);
+      }
+    }
+    delay(200);
+    SimBle::disconnect();
+
+    const uint32_t seen = host_keystrokes();
+    const uint32_t lost = seen < typed ? typed - seen : 0;
+    printf("[BENCH] reconnect, replay %s: %u keystrokes typed over %u reconnects, %u reached the host, "
+           "%u lost (%.1f%%)\n",
+           windowMs != 0 ? "on" : "off", (unsigned)typed, (unsigned)cycles, (unsigned)seen, (unsigned)lost,
+           typed > 0 ? lost * 100.0 / typed : 0.0);
+    if (windowMs != 0 && lost != 0) {
+      ok = false;
+    }
+    delay(20);
+  }
+  Bridge::setReplayWindow(REPLAY_DEFAULT_WINDOW_MS);
+  SimBle::setSubscribeDelay(0);
+  return ok;
+}
+
+static bool run_pointer_test() {
+  const uint16_t curve[POINTER_CURVE_POINTS] = POINTER_CURVE_DEFAULT;
+  const uint32_t reportUs = 1000000 / 125;
+  bool ok = true;
+
+  ok &= check(PointerIntegrator::speedQ16(3072, curve) == 12u * 65536, "speed interpolates between curve points");
+  ok &= check(PointerIntegrator::speedQ16(-3072, curve) == 12u * 65536, "speed ignores the direction");
+
+  PointerAxis rest;
+  int moved = 0;
+  for (int i = 0; i < 125; i++) {
+    moved += rest.update(0, reportUs, curve);
+  }
+  ok &= check(moved == 0 && rest.remainderQ16() == 0, "no deflection, no motion");
+
+  // 5 px/s: most reports are 0, but a second of them adds up to 5 pixels in both directions
+  PointerAxis slowRight;
+  PointerAxis slowLeft;
+  int right = 0;
+  int left = 0;
+  for (int i = 0; i < 125; i++) {
+    right += slowRight.update(2048, reportUs, curve);
+    left += slowLeft.update(-2048, reportUs, curve);
+  }
+  ok &= check(right == 5 && left == -5, "slow speed accumulates instead of truncating");
+
+  // A 1 s stall at full speed: one full report, one report's worth carried, the rest dropped
+  PointerAxis stalled;
+  const int first = stalled.update(32767, 1000000, curve);
+  const int carried = stalled.update(32767, 0, curve);
+  const int after = stalled.update(32767, 0, curve);
+  ok &= check(first == POINTER_MAX_REPORT && carried == POINTER_MAX_REPORT && after == 0,
+              "a long gap carries at most one report's worth");
+
+  PointerIntegrator integrator;
+  int8_t dx, dy;
+  integrator.update(32767, -32767, 100000, dx, dy);
+  const int full = (int)((uint64_t)PointerIntegrator::speedQ16(32767, curve) * 100000 / 65536 / 1000000);
+  ok &= check(full >= 119 && dx == full && dy == -full, "both axes move at full speed over 100 ms");
+  integrator.reset();
+  integrator.update(0, 0, 0, dx, dy);
+  ok &= check(dx == 0 && dy == 0, "reset drops the remainder");
+
+  printf("[TEST] pointer: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static bool run_pointer_benchmark(uint32_t count) {
+  const uint16_t curve[POINTER_CURVE_POINTS] = POINTER_CURVE_DEFAULT;
+  const uint32_t reportUs = 1000000 / 125;
+  const uint32_t durationUs = 10000000;
+  const int16_t deflections[] = {0, 600, 2048, 6000, 12000, 20000, 32767};
+  bool ok = true;
+
+  // Drift: the distance is speed x time, whether updates are regular or jittered, and back
+  // and forth for the same time ends where it started
+  for (int16_t deflection : deflections) {
+    const int64_t expected = (int64_t)PointerIntegrator::speedQ16(deflection, curve) * durationUs / 65536 / 1000000;
+    const int64_t regular = pointer_distance(deflection, durationUs, reportUs, false);
+    const int64_t jittered = pointer_distance(deflection, durationUs, reportUs, true);
+
+    PointerAxis axis;
+    int64_t net = 0;
+    for (uint32_t elapsed = 0; elapsed < durationUs; elapsed += reportUs) {
+      net += axis.update(deflection, reportUs, curve);
+    }
+    for (uint32_t elapsed = 0; elapsed < durationUs; elapsed += reportUs) {
+      net += axis.update((int16_t)-deflection, reportUs, curve);
+    }
+
+    // The old path per 10 s, with loop() at 100 Hz and at 1 kHz
+    const int counts = deflection_counts(deflection);
+    const int64_t float100 = (int64_t)float_pointer_update(counts) * 100 * 10;
+    const int64_t float1000 = (int64_t)float_pointer_update(counts) * 1000 * 10;
+
+    const bool exact = llabs(regular - expected) <= 1 && llabs(jittered - expected) <= 1 && llabs(net) <= 1;
+    printf("[BENCH] pointer: deflection %5d (%4d counts) 10 s: %5lld px expected, %5lld regular, %5lld jittered, "
+           "%lld back and forth; float path %lld px at 100 Hz, %lld px at 1 kHz%s\n",
+           deflection, counts, (long long)expected, (long long)regular, (long long)jittered, (long long)net,
+           (long long)float100, (long long)float1000, exact ? "" : " DRIFT");
+    ok = exact && ok;
+  }
+
+  // Cost per update of both paths
+  PointerIntegrator integrator;
+  int64_t sum = 0;
+  int64_t start = esp_timer_get_time();
+  for (uint32_t i = 0; i < count; i++) {
+    int8_t dx, dy;
+    const int16_t x = (int16_t)((i * 37) % 65535 - 32767);
+    integrator.update(x, (int16_t)-x, reportUs, dx, dy);
+    sum += dx + dy;
+  }
+  const int64_t fixedUs = esp_timer_get_time() - start;
+  start = esp_timer_get_time();
+  for (uint32_t i = 0; i < count; i++) {
+    const int counts = deflection_counts((int16_t)((i * 37) % 65535 - 32767));
+    sum += float_pointer_update(counts) + float_pointer_update(-counts);
+  }
+  const int64_t floatUs = esp_timer_get_time() - start;
+  printf("[BENCH] pointer: %u updates, fixed point %.1f ns/update, float path %.1f ns/update (%lld)\n",
+         (unsigned)count, count > 0 ? fixedUs * 1000.0 / count : 0.0, count > 0 ? floatUs * 1000.0 / count : 0.0,
+         (long long)sum);
+  return ok;
+}
+
+// Replays joystick readings ("J,<us>,<x>,<y>,<button>" lines from joystickSetTrace, or the
+// same without the "J,") through JoystickFilter; each line is one output period
+static bool run_joystick_trace(const char *path) {
+  FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+  if (in == nullptr) {
+    fprintf(stderr, "joystick: cannot open %s\n", path);
+    return false;
+  }
+  JoystickFilter filter;
+  char line[128];
+  unsigned lineNo = 0;
+  bool ok = true;
+  printf("us,raw_x,raw_y,filtered_x,filtered_y,x,y,button,center_x,center_y\n");
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    lineNo++;
+    const char *fields = strncmp(line, "J,", 2) == 0 ? line + 2 : line;
+    unsigned us, x, y, button;
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    if (sscanf(fields, "%u,%u,%u,%u", &us, &x, &y, &button) != 4 || x > JOYSTICK_ADC_MAX ||
+        y > JOYSTICK_ADC_MAX) {
+      fprintf(stderr, "joystick: %s:%u: expected <us>,<x>,<y>,<button>\n", path, lineNo);
+      ok = false;
+      continue;
+    }
+    filter.addX((uint16_t)x);
+    filter.addY((uint16_t)y);
+    const joystick_sample_t sample = filter.commit(us, button != 0);
+    printf("%u,%u,%u,%u,%u,%d,%d,%d,%u,%u\n", us, x, y, sample.rawX, sample.rawY, sample.x, sample.y,
+           sample.button ? 1 : 0, filter.x().center(), filter.y().center());
+  }
+  if (in != stdin) {
+    fclose(in);
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const char *scriptPath = nullptr;
+  const char *csvPath = nullptr;
+  uint32_t benchCount = 0;
+  uint32_t parseBenchCount = 0;
+  uint32_t ringTestCount = 0;
+  bool keyStateTest = false;
+  bool notifyTest = false;
+  bool governorTest = false;
+  uint32_t keyStateBenchCount = 0;
+  uint32_t keymapBenchCount = 0;
+  bool keymapExampleTest = false;
+  uint32_t injectBenchCount = 0;
+  uint32_t displayBenchCount = 0;
+  uint32_t gifBenchCount = 0;
+  const char *assetsPath = nullptr;
+  const char *joystickTrace = nullptr;
+  bool pointerTest = false;
+  uint32_t pointerBenchCount = 0;
+  uint32_t reconnectBenchCount = 0;
+  uint32_t intervalUs = 1000;
+  unsigned txBuffers = 0;
+  bool quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--script") && i + 1 < argc) {
+      scriptPath = argv[++i];
+    } else if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+      benchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--bench-parse") && i + 1 < argc) {
+      parseBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--test-ring") && i + 1 < argc) {
+      ringTestCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--test-notify")) {
+      notifyTest = true;
+    } else if (!strcmp(argv[i], "--test-governor")) {
+      governorTest = true;
+    } else if (!strcmp(argv[i], "--test-keys")) {
+      keyStateTest = true;
+    } else if (!strcmp(argv[i], "--bench-keys") && i + 1 < argc) {
+      keyStateBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--bench-keymap") && i + 1 < argc) {
+      keymapBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--test-keymap-example")) {
+      keymapExampleTest = true;
+    } else if (!strcmp(argv[i], "--bench-inject") && i + 1 < argc) {
+      injectBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--bench-display") && i + 1 < argc) {
+      displayBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--bench-gif") && i + 1 < argc) {
+      gifBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--bench-assets") && i + 1 < argc) {
+      assetsPath = argv[++i];
+    } else if (!strcmp(argv[i], "--joystick-trace") && i + 1 < argc) {
+      joystickTrace = argv[++i];
+    } else if (!strcmp(argv[i], "--test-pointer")) {
+      pointerTest = true;
+    } else if (!strcmp(argv[i], "--bench-pointer") && i + 1 < argc) {
+      pointerBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--bench-reconnect") && i + 1 < argc) {
+      reconnectBenchCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--interval-us") && i + 1 < argc) {
+      intervalUs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--congest") && i + 1 < argc) {
+      txBuffers = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--quiet")) {
+      quiet = true;
+    } else {
+      fprintf(stderr, "usage: %s [--script file|-] [--csv file] [--bench count] [--bench-parse count] "
+                      "[--test-ring count] [--test-notify] [--test-governor] [--test-keys] [--bench-keys count] [--bench-keymap count] [--test-keymap-example] [--bench-inject repeat] [--bench-display keys] "
+                      "[--bench-gif frames] [--bench-assets bundle] [--joystick-trace file] [--test-pointer] "
+                      "[--bench-pointer updates] "
+                      "[--bench-reconnect cycles] "
+                      "[--interval-us us] [--congest buffers] [--quiet]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // A trace replay is pure filter math; the CSV goes to stdout without the bridge around it
+  if (joystickTrace != nullptr) {
+    const bool replayed = run_joystick_trace(joystickTrace);
+    fflush(stdout);
+    return replayed ? 0 : 1;
+  }
+
+  Serial.begin(115200);
+  if (quiet) {
+    SimArduino::setSerialOutput(nullptr);
+  }
+  Bridge::begin();
+  if (quiet) {
+    for (int s = 0; s < BINLOG_SUBSYSTEM_COUNT; s++) {
+      binlogSetLevel((binlog_subsystem_t)s, BINLOG_LEVEL_OFF);
+    }
+  }
+  xTaskCreate(loop_task, "loopTask", 8192, NULL, 1, NULL);
+  SimBle::setTxBuffers(txBuffers);
+
+  bool ok = true;
+  if (scriptPath != nullptr) {
+    FILE *in = strcmp(scriptPath, "-") == 0 ? stdin : fopen(scriptPath, "r");
+    if (in == nullptr) {
+      fprintf(stderr, "cannot open %s\n", scriptPath);
+      return 2;
+    }
+    ok = SimScript::run(in, scriptPath);
+  }
+  if (benchCount > 0) {
+    ok = run_benchmark(benchCount, intervalUs) && ok;
+  }
+  if (parseBenchCount > 0) {
+    ok = run_parse_benchmark(parseBenchCount) && ok;
+  }
+  if (ringTestCount > 0) {
+    ok = run_ring_test(ringTestCount) && ok;
+  }
+  if (notifyTest) {
+    ok = run_notify_test() && ok;
+  }
+  if (governorTest) {
+    ok = run_governor_test() && ok;
+  }
+  if (keyStateTest) {
+    ok = run_key_state_test() && ok;
+  }
+  if (keyStateBenchCount > 0) {
+    ok = run_key_state_benchmark(keyStateBenchCount) && ok;
+  }
+  if (keymapBenchCount > 0) {
+    ok = run_keymap_benchmark(keymapBenchCount) && ok;
+  }
+  if (keymapExampleTest) {
+    ok = run_keymap_example_test() && ok;
+  }
+  if (injectBenchCount > 0) {
+    ok = run_inject_benchmark(injectBenchCount) && ok;
+  }
+  if (displayBenchCount > 0) {
+    ok = run_display_benchmark(displayBenchCount) && ok;
+  }
+  if (gifBenchCount > 0) {
+    ok = run_gif_benchmark(gifBenchCount) && ok;
+  }
+  if (assetsPath != nullptr) {
+    ok = run_assets_benchmark(assetsPath) && ok;
+  }
+  if (pointerTest) {
+    ok = run_pointer_test() && ok;
+  }
+  if (pointerBenchCount > 0) {
+    ok = run_pointer_benchmark(pointerBenchCount) && ok;
+  }
+  if (reconnectBenchCount > 0) {
+    ok = run_reconnect_benchmark(reconnectBenchCount) && ok;
+  }
+
+  if (csvPath != nullptr) {
+    FILE *out = fopen(csvPath, "w");
+    if (out != nullptr) {
+      SimBle::writeReports(out);
+      fclose(out);
+    }
+  }
+
+  // Simulated tasks never return; leave without running static destructors under them
+  Serial.flush();
+  fflush(stdout);
+  fflush(stderr);
+  _Exit(ok ? 0 : 1);
+}
@@ -0,0 +1,94 @@
+#!/bin/sh
+# Runs the native simulation checks: every script in sim/tests and the host
+# tests and benchmarks below that gate on their own results. Prints the output
+# of each failed check and exits non-zero if any failed.
+#
+#   pio run -e native && sim/run_tests.sh [.pio/build/native/program]
+
+SIM=${1:-.pio/build/native/program}
+TESTS=$(dirname "$0")/tests
+failed=0
+
+run() {
+  output=$("$SIM" "$@" --quiet 2>&1)
+  if [ $? -eq 0 ]; then
+    echo "ok    $*"
+  else
+    echo "FAIL  $*"
+    echo "$output" | sed 's/^/      /'
+    failed=$((failed + 1))
+  fi
+}
+
+if [ ! -x "$SIM" ]; then
+  echo "$SIM not found; build it with: pio run -e native" >&2
+  exit 2
+fi
+
+for script in "$TESTS"/*.sim; do
+  run --script "$script"
+done
+
+run --bench-parse 100000
+run --test-ring 1000000
+run --test-notify
+run --test-governor
+run --test-keys
+run --bench-keys 100000
+run --test-keymap-example
+# Overload: past what the link carries the input ring overflows, and every
+# missing edge must be accounted for by a dropped report
+run --bench 2000
+# Fast typing, also on a link taking one notification per event: nothing dropped
+for congest in 0 1; do
+  run --bench 300 --interval-us 12000 --congest $congest
+  echo "$output" | grep -q "overflows 0," || { echo "FAIL  input ring overflowed at typing speed"; failed=$((failed + 1)); }
+done
+# Typed text decodes to the same characters, packed and one key per report
+run --bench-inject 1
+# Keystrokes typed across link drops all reach the host with the replay on
+run --bench-reconnect 5
+# Compositor and key readout: the benches fail if nothing reaches the display
+run --bench-display 20
+# GIF bands must draw exactly the pixels of the per-line renderer
+run --bench-gif 200
+run --bench-keymap 100000
+run --test-pointer
+run --bench-pointer 100000
+
+# Joystick filter: the trace replays to the same filtered, calibrated output
+if "$SIM" --joystick-trace "$TESTS/joystick_trace.csv" 2>&1 | cmp -s - "$TESTS/joystick_trace.expected.csv"; then
+  echo "ok    --joystick-trace $TESTS/joystick_trace.csv"
+else
+  echo "FAIL  --joystick-trace $TESTS/joystick_trace.csv differs from joystick_trace.expected.csv"
+  "$SIM" --joystick-trace "$TESTS/joystick_trace.csv" 2>&1 | diff "$TESTS/joystick_trace.expected.csv" - | head -20 | sed 's/^/      /'
+  failed=$((failed + 1))
+fi
+
+# Asset bundle round trip: tools/pack_assets.py packs sim/tests/assets and
+# AssetBundle must read every file back with the packer's checksums, and
+# reject the bundle once a stored byte is flipped
+if python3 -c "import PIL" 2>/dev/null; then
+  bundle=$(mktemp)
+  python3 "$(dirname "$0")/../tools/pack_assets.py" "$TESTS/assets" -o "$bundle" >/dev/null
+  run --bench-assets "$bundle"
+  for format in raw rgb565 rle565; do
+    echo "$output" | grep -q " $format " || { echo "FAIL  no $format entry in the asset bundle"; failed=$((failed + 1)); }
+  done
+  python3 -c "import sys; f = open(sys.argv[1], 'r+b'); f.seek(-1, 2); b = f.read(1); f.seek(-1, 2); f.write(bytes([b[0] ^ 1]))" "$bundle"
+  if "$SIM" --bench-assets "$bundle" --quiet >/dev/null 2>&1; then
+    echo "FAIL  corrupted asset bundle accepted"
+    failed=$((failed + 1))
+  else
+    echo "ok    corrupted asset bundle rejected"
+  fi
+  rm -f "$bundle"
+else
+  echo "skip  asset bundle round trip (needs python3 with Pillow)"
+fi
+
+if [ $failed -ne 0 ]; then
+  echo "$failed check(s) failed"
+  exit 1
+fi
+echo "all checks passed"
@@ -0,0 +1,2 @@
+// Builds srcs/AssetBundle.cpp into the native simulation
+#include "../../srcs/AssetBundle.cpp"
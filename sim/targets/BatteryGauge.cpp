@@ -0,0 +1,2 @@
+// Builds srcs/BatteryGauge.cpp into the native simulation
+#include "../../srcs/BatteryGauge.cpp"
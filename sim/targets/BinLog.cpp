@@ -0,0 +1,2 @@
+// Builds srcs/BinLog.cpp into the native simulation
+#include "../../srcs/BinLog.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/BleDevice.cppx into the native simulation
+#include "../../srcs/BleDevice.cppx"
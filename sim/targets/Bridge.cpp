@@ -0,0 +1,2 @@
+// Builds srcs/Bridge.cppx into the native simulation
+#include "../../srcs/Bridge.cppx"
@@ -0,0 +1,2 @@
+// Builds srcs/Compositor.cpp into the native simulation
+#include "../../srcs/Compositor.cpp"
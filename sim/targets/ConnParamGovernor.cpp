@@ -0,0 +1,2 @@
+// Builds srcs/ConnParamGovernor.cpp into the native simulation
+#include "../../srcs/ConnParamGovernor.cpp"
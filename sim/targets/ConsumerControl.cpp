@@ -0,0 +1,2 @@
+// Builds srcs/ConsumerControl.cpp into the native simulation
+#include "../../srcs/ConsumerControl.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/GifBandRenderer.cpp into the native simulation
+#include "../../srcs/GifBandRenderer.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/GlyphAtlas.cpp into the native simulation
+#include "../../srcs/GlyphAtlas.cpp"
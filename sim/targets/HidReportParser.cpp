@@ -0,0 +1,2 @@
+// Builds srcs/HidReportParser.cpp into the native simulation
+#include "../../srcs/HidReportParser.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/HostSlots.cpp into the native simulation
+#include "../../srcs/HostSlots.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/JoystickFilter.cpp into the native simulation
+#include "../../srcs/JoystickFilter.cpp"
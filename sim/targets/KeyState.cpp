@@ -0,0 +1,2 @@
+// Builds srcs/KeyState.cpp into the native simulation
+#include "../../srcs/KeyState.cpp"
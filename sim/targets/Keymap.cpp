@@ -0,0 +1,2 @@
+// Builds srcs/Keymap.cpp into the native simulation
+#include "../../srcs/Keymap.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/KeymapDefault.cpp into the native simulation
+#include "../../srcs/KeymapDefault.cpp"
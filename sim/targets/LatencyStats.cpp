@@ -0,0 +1,2 @@
+// Builds srcs/LatencyStats.cpp into the native simulation
+#include "../../srcs/LatencyStats.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/Metrics.cpp into the native simulation
+#include "../../srcs/Metrics.cpp"
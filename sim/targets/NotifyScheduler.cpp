@@ -0,0 +1,2 @@
+// Builds srcs/NotifyScheduler.cpp into the native simulation
+#include "../../srcs/NotifyScheduler.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/PointerIntegrator.cpp into the native simulation
+#include "../../srcs/PointerIntegrator.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/ReplayBuffer.cpp into the native simulation
+#include "../../srcs/ReplayBuffer.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/SerialConsole.cpp into the native simulation
+#include "../../srcs/SerialConsole.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/SpriteCache.cpp into the native simulation
+#include "../../srcs/SpriteCache.cpp"
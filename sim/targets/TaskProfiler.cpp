@@ -0,0 +1,2 @@
+// Builds srcs/TaskProfiler.cpp into the native simulation
+#include "../../srcs/TaskProfiler.cpp"
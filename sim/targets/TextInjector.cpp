@@ -0,0 +1,2 @@
+// Builds srcs/TextInjector.cpp into the native simulation
+#include "../../srcs/TextInjector.cpp"
@@ -0,0 +1,2 @@
+// Builds srcs/TimerWheel.cpp into the native simulation
+#include "../../srcs/TimerWheel.cpp"
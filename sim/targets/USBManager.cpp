@@ -0,0 +1,2 @@
+// Builds srcs/USBManager.cpp into the native simulation
+#include "../../srcs/USBManager.cpp"
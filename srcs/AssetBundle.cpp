@@ -0,0 +1,179 @@
+#include "AssetBundle.h"
+#include <string.h>
+
+struct AssetHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  uint32_t size;
+  uint32_t tableCrc;
+};
+
+uint32_t assetCrc32(uint32_t crc, const void *data, size_t len) {
+  static uint32_t table[256];
+  if (table[1] == 0) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int bit = 0; bit < 8; bit++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      table[i] = c;
+    }
+  }
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+  while (len-- > 0) {
+    crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+AssetPixelReader::AssetPixelReader(const asset_view_t &asset)
+    : _next(asset.data), _end(asset.data + asset.size), _format(asset.format) {}
+
+bool AssetPixelReader::read(uint16_t *out, uint32_t count) {
+  if (_format == ASSET_FORMAT_RGB565) {
+    if ((uint32_t)(_end - _next) < count * 2) {
+      return false;
+    }
+    memcpy(out, _next, count * 2);
+    _next += count * 2;
+    return true;
+  }
+  if (_format != ASSET_FORMAT_RLE565) {
+    return false;
+  }
+
+  while (count > 0) {
+    if (_left == 0) {
+      if (_end - _next < 4) {
+        return false; // Every token carries at least one pixel
+      }
+      const uint16_t token = (uint16_t)(_next[0] | _next[1] << 8);
+      _next += 2;
+      _repeat = (token & ASSET_RLE_REPEAT) != 0;
+      _left = token & ~ASSET_RLE_REPEAT;
+      if (_left == 0) {
+        return false;
+      }
+      if (_repeat) {
+        memcpy(&_pixel, _next, 2);
+        _next += 2;
+      } else if ((uint32_t)(_end - _next) < (uint32_t)_left * 2) {
+        return false;
+      }
+    }
+    const uint16_t n = count < _left ? (uint16_t)count : _left;
+    if (_repeat) {
+      for (uint16_t i = 0; i < n; i++) {
+        out[i] = _pixel;
+      }
+    } else {
+      memcpy(out, _next, n * 2);
+      _next += n * 2;
+    }
+    out += n;
+    count -= n;
+    _left -= n;
+  }
+  return true;
+}
+
+void AssetBundle::detach() {
+  _base = nullptr;
+  _entries = nullptr;
+  _count = 0;
+  _size = 0;
+}
+
+bool AssetBundle::attach(const uint8_t *base, uint32_t size) {
+  detach();
+  if (base == nullptr || size < sizeof(AssetHeader)) {
+    return false;
+  }
+  const AssetHeader *header = (const AssetHeader *)base;
+  if (header->magic != ASSET_BUNDLE_MAGIC || header->version != ASSET_BUNDLE_VERSION || header->size > size) {
+    return false;
+  }
+  const uint32_t tableEnd = sizeof(AssetHeader) + (uint32_t)header->count * sizeof(Entry);
+  if (tableEnd > header->size ||
+      assetCrc32(0, base + sizeof(AssetHeader), tableEnd - sizeof(AssetHeader)) != header->tableCrc) {
+    return false;
+  }
+
+  // An erased or half-written partition must not hand out pointers past the image
+  const Entry *entries = (const Entry *)(base + sizeof(AssetHeader));
+  for (uint16_t i = 0; i < header->count; i++) {
+    const Entry &entry = entries[i];
+    if (memchr(entry.name, '\0', ASSET_NAME_LEN) == nullptr || entry.offset < tableEnd ||
+        entry.offset > header->size || entry.size > header->size - entry.offset || entry.offset % 4 != 0) {
+      return false;
+    }
+    if (entry.format == ASSET_FORMAT_RAW) {
+      continue;
+    }
+    if (entry.format > ASSET_FORMAT_RLE565 || entry.width == 0 || entry.width > ASSET_MAX_WIDTH ||
+        entry.height == 0 ||
+        (entry.format == ASSET_FORMAT_RGB565 && entry.size != (uint32_t)entry.width * entry.height * 2)) {
+      return false;
+    }
+  }
+  _base = base;
+  _entries = entries;
+  _count = header->count;
+  _size = header->size;
+  return true;
+}
+
+bool AssetBundle::verify() {
+  for (uint16_t i = 0; i < _count; i++) {
+    asset_view_t asset;
+    get(i, asset);
+    uint32_t crc = 0;
+    if (asset.format == ASSET_FORMAT_RAW) {
+      crc = assetCrc32(0, asset.data, asset.size);
+    } else {
+      // Decoding RLE here also proves that it yields exactly width x height pixels
+      uint16_t row[ASSET_MAX_WIDTH];
+      AssetPixelReader reader(asset);
+      for (uint16_t y = 0; y < asset.height; y++) {
+        if (!reader.read(row, asset.width)) {
+          detach();
+          return false;
+        }
+        crc = assetCrc32(crc, row, asset.width * sizeof(uint16_t));
+      }
+    }
+    if (crc != _entries[i].crc) {
+      detach();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AssetBundle::get(uint16_t i, asset_view_t &out) const {
+  if (i >= _count) {
+    return false;
+  }
+  const Entry &entry = _entries[i];
+  out.data = _base + entry.offset;
+  out.size = entry.size;
+  out.format = entry.format;
+  out.width = entry.width;
+  out.height = entry.height;
+  return true;
+}
+
+bool AssetBundle::find(const char *name, asset_view_t &out) const {
+  for (uint16_t i = 0; i < _count; i++) {
+    if (strncmp(_entries[i].name, name, ASSET_NAME_LEN) == 0) {
+      return get(i, out);
+    }
+  }
+  return false;
+}
+
+const char *AssetBundle::name(uint16_t i) const {
+  return i < _count ? _entries[i].name : nullptr;
+}
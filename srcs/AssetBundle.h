@@ -0,0 +1,114 @@
+/**
+ * @file AssetBundle.h
+ * @brief Read-only view of the packed asset image (tools/pack_assets.py).
+ *
+ * The image is written to the "assets" flash partition and memory-mapped at
+ * boot. Decoders then read the files straight from flash through the
+ * pointer returned by find(). There is no filesystem, no file handle and
+ * no copy. The packer converts images at build time to RGB565 in SPI byte
+ * order, which pushImage takes as it is. When run-length encoding is
+ * smaller it stores that instead. Layout, little-endian:
+ *
+ *   header   magic "ASET", u16 version, u16 count, u32 image size, u32 CRC-32 of the entries
+ *   entries  count x { char name[32], u32 offset, u32 size, u16 format, u16 width, u16 height,
+ *                      u16 reserved, u32 CRC-32 of the content }
+ *   data     files at 4-byte aligned offsets from the start of the image
+ *
+ * The content CRC covers the raw bytes of ASSET_FORMAT_RAW entries and the
+ * decoded pixels of image entries. RLE data is a sequence of u16 tokens.
+ * A token with bit 15 set repeats the pixel that follows (count in the low
+ * bits). Otherwise the token is a count of literal pixels that follow.
+ *
+ * attach() checks the header, the entry table and every entry's bounds.
+ * verify() decodes every entry once and checks its CRC. After that, showing
+ * an asset needs only a name lookup.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_BUNDLE_MAGIC 0x54455341u // "ASET"
+#define ASSET_BUNDLE_VERSION 2
+#define ASSET_NAME_LEN 32
+#define ASSET_MAX_WIDTH 320
+#define ASSET_RLE_REPEAT 0x8000
+
+enum : uint16_t {
+  ASSET_FORMAT_RAW,    ///< File as it is in data/ (GIF, JPEG, ...)
+  ASSET_FORMAT_RGB565, ///< width x height pixels in SPI byte order
+  ASSET_FORMAT_RLE565  ///< The same pixels, run-length encoded
+};
+
+typedef struct {
+  const uint8_t *data;
+  uint32_t size;
+  uint16_t format;
+  uint16_t width;  ///< Image entries only
+  uint16_t height;
+} asset_view_t;
+
+/// CRC-32 as in zlib; pass 0 to start and the previous result to continue.
+uint32_t assetCrc32(uint32_t crc, const void *data, size_t len);
+
+/// Decodes the pixels of an RGB565 or RLE entry in order, any number at a time.
+class AssetPixelReader {
+public:
+  explicit AssetPixelReader(const asset_view_t &asset);
+
+  /// Writes the next count pixels in SPI byte order; false if the entry ends first or is not an image.
+  bool read(uint16_t *out, uint32_t count);
+
+private:
+  const uint8_t *_next;
+  const uint8_t *_end;
+  uint16_t _format;
+  uint16_t _left = 0; ///< Pixels left in the current RLE token
+  bool _repeat = false;
+  uint16_t _pixel = 0;
+};
+
+class AssetBundle {
+public:
+  /// Validates the image at base (size bytes available); false leaves the bundle empty.
+  bool attach(const uint8_t *base, uint32_t size);
+
+  /// Checks every entry against its CRC; false (and the bundle is dropped) if any differs.
+  bool verify();
+
+  bool attached() const { return _base != nullptr; }
+  uint16_t count() const { return _count; }
+  uint32_t size() const { return _size; }
+
+  /// Looks up a file by its path in data/, e.g. "/bongo/1.jpg".
+  bool find(const char *name, asset_view_t &out) const;
+
+  /// Entry i, or false.
+  bool get(uint16_t i, asset_view_t &out) const;
+  const char *name(uint16_t i) const;
+
+private:
+  struct Entry {
+    char name[ASSET_NAME_LEN];
+    uint32_t offset;
+    uint32_t size;
+    uint16_t format;
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved;
+    uint32_t crc;
+  };
+
+  void detach();
+
+  const uint8_t *_base = nullptr;
+  const Entry *_entries = nullptr;
+  uint16_t _count = 0;
+  uint32_t _size = 0;
+};
+
+#endif // ASSET_BUNDLE_H
@@ -0,0 +1,57 @@
+#include "AssetPartition.h"
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// partitions.csv: "assets, data, 0x40, ..."; written with tools/pack_assets.py and esptool
+static const esp_partition_subtype_t ASSET_PARTITION_SUBTYPE = (esp_partition_subtype_t)0x40;
+static const char* ASSET_PARTITION_LABEL = "assets";
+
+static AssetBundle bundle;
+static spi_flash_mmap_handle_t mapHandle;
+static bool mountTried = false;
+
+bool assetPartitionMount() {
+  if (mountTried) {
+    return bundle.attached();
+  }
+  mountTried = true;
+
+  const esp_partition_t* partition =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ASSET_PARTITION_SUBTYPE, ASSET_PARTITION_LABEL);
+  if (partition == nullptr) {
+    Serial.println("[ASSETS] No asset partition, using SPIFFS");
+    return false;
+  }
+
+  // Map only the packed image, not the whole partition: read its size from the header first
+  const void* mapped = nullptr;
+  uint32_t header[3] = {};
+  if (esp_partition_read(partition, 0, header, sizeof(header)) != ESP_OK || header[0] != ASSET_BUNDLE_MAGIC ||
+      header[2] == 0 || header[2] > partition->size) {
+    Serial.println("[ASSETS] Asset partition is empty, using SPIFFS");
+    return false;
+  }
+  if (esp_partition_mmap(partition, 0, header[2], SPI_FLASH_MMAP_DATA, &mapped, &mapHandle) != ESP_OK) {
+    Serial.println("[ERROR] Cannot map the asset partition, using SPIFFS");
+    return false;
+  }
+  // Checksums are checked once here, so showing an asset later is only a lookup
+  const unsigned long start = millis();
+  if (!bundle.attach((const uint8_t*)mapped, header[2]) || !bundle.verify()) {
+    Serial.println("[ERROR] Asset bundle is invalid or was packed by an older tool, using SPIFFS");
+    spi_flash_munmap(mapHandle);
+    return false;
+  }
+
+  Serial.printf("[ASSETS] Mapped %u files (%u KB) from flash, verified in %u ms\n", bundle.count(),
+                (unsigned)(header[2] / 1024), (unsigned)(millis() - start));
+  return true;
+}
+
+bool assetPartitionMounted() {
+  return bundle.attached();
+}
+
+bool assetOpen(const char* path, asset_view_t &out) {
+  return bundle.find(path, out);
+}
@@ -0,0 +1,25 @@
+#ifndef ASSET_PARTITION_H
+#define ASSET_PARTITION_H
+
+#include "AssetBundle.h"
+
+/**
+ * Memory-map the "assets" flash partition and check its bundle (safe to call again)
+ * @return false if the partition is missing or holds no valid bundle; callers use SPIFFS then
+ */
+bool assetPartitionMount();
+
+/**
+ * Check if the asset partition is mapped
+ */
+bool assetPartitionMounted();
+
+/**
+ * Look up a file by its SPIFFS path in the mapped bundle
+ * @param path Path as in data/, e.g. "/bongo/1.jpg"
+ * @param out Pointer into flash and size; valid until reboot
+ * @return false if the bundle is not mounted or has no such file
+ */
+bool assetOpen(const char* path, asset_view_t &out);
+
+#endif
@@ -0,0 +1,59 @@
+#include "BatteryGauge.h"
+
+// Resting voltage of a typical Li-ion cell against state of charge, ascending
+static const struct {
+  uint16_t milliVolts;
+  uint8_t percent;
+} DISCHARGE_CURVE[] = {
+    {3270, 0},  {3610, 5},  {3690, 10}, {3710, 15}, {3730, 20}, {3750, 25}, {3770, 30},
+    {3790, 35}, {3800, 40}, {3820, 45}, {3840, 50}, {3850, 55}, {3870, 60}, {3910, 65},
+    {3950, 70}, {3980, 75}, {4020, 80}, {4080, 85}, {4110, 90}, {4150, 95}, {4200, 100},
+};
+static const int CURVE_POINTS = sizeof(DISCHARGE_CURVE) / sizeof(DISCHARGE_CURVE[0]);
+
+BatteryGauge::BatteryGauge(const battery_gauge_config_t &config) : _config(config) {}
+
+uint16_t BatteryGauge::chargeTenths(uint32_t milliVolts) {
+  if (milliVolts <= DISCHARGE_CURVE[0].milliVolts) {
+    return 0;
+  }
+  for (int i = 1; i < CURVE_POINTS; i++) {
+    if (milliVolts < DISCHARGE_CURVE[i].milliVolts) {
+      // Linear between the two points around the voltage
+      const uint32_t low = DISCHARGE_CURVE[i - 1].milliVolts;
+      const uint32_t high = DISCHARGE_CURVE[i].milliVolts;
+      const uint32_t from = DISCHARGE_CURVE[i - 1].percent * 10;
+      const uint32_t to = DISCHARGE_CURVE[i].percent * 10;
+      return (uint16_t)(from + (to - from) * (milliVolts - low) / (high - low));
+    }
+  }
+  return 1000;
+}
+
+bool BatteryGauge::add(uint32_t adcMilliVolts) {
+  const uint32_t battery = (uint32_t)((uint64_t)adcMilliVolts * (_config.dividerTop + _config.dividerBottom) /
+                                      _config.dividerBottom);
+  if (_stats.samples == 0) {
+    _state = battery << 4;
+  } else {
+    _state += ((int32_t)(battery << 4) - (int32_t)_state) >> _config.emaShift;
+  }
+  _stats.samples++;
+  _stats.milliVolts = milliVolts();
+
+  // The reported percent p covers tenths [10p - h, 10p + 9 + h]
+  const int32_t tenths = chargeTenths(_stats.milliVolts);
+  const int32_t band = _percent * 10;
+  const bool first = _stats.samples == 1;
+  if (!first && tenths >= band - _config.hysteresisTenths && tenths <= band + 9 + _config.hysteresisTenths) {
+    return false;
+  }
+  const uint8_t percent = (uint8_t)(tenths / 10);
+  if (!first && percent == _percent) {
+    return false;
+  }
+  _percent = percent;
+  _stats.percent = percent;
+  _stats.reports++;
+  return true;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file BatteryGauge.h
+ * @brief Battery voltage filter and Li-ion state of charge.
+ *
+ * The sampler feeds calibrated ADC millivolts (analogReadMilliVolts) to
+ * add(). The gauge scales them by the voltage divider and smooths them with
+ * an exponential moving average. It then looks the charge up on a typical
+ * Li-ion discharge curve: flat around 3.8 V, steep below 3.7 V and above
+ * 4.0 V. The percentage is tracked in tenths. The reported value only moves
+ * once the tenths leave its band by the hysteresis, so a reading sitting on a
+ * boundary does not flip the BLE Battery Service back and forth.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef BATTERY_GAUGE_H
+#define BATTERY_GAUGE_H
+
+#include <stdint.h>
+
+typedef struct {
+  uint32_t dividerTop;      ///< Ohms between the battery and the ADC pin
+  uint32_t dividerBottom;   ///< Ohms between the ADC pin and ground
+  uint8_t emaShift;         ///< Each reading moves the average by 1/2^emaShift of the difference
+  uint8_t hysteresisTenths; ///< Tenths of a percent past a boundary before the report changes
+} battery_gauge_config_t;
+
+#define BATTERY_GAUGE_DEFAULTS {237000, 121000, 3, 5}
+
+typedef struct {
+  uint32_t samples;    ///< Readings added
+  uint32_t reports;    ///< Times the reported percentage changed
+  uint16_t milliVolts; ///< Filtered battery voltage
+  uint8_t percent;     ///< Reported state of charge
+  uint32_t sampleUs;   ///< Duration of the last sampling round (set by the sampler)
+} battery_stats_t;
+
+class BatteryGauge {
+public:
+  explicit BatteryGauge(const battery_gauge_config_t &config = BATTERY_GAUGE_DEFAULTS);
+
+  /// Adds one ADC reading. True if the reported percentage changed (always for the first).
+  bool add(uint32_t adcMilliVolts);
+
+  /// State of charge for a battery voltage in tenths of a percent, 0..1000.
+  static uint16_t chargeTenths(uint32_t milliVolts);
+
+  uint16_t milliVolts() const { return (uint16_t)((_state + 8) >> 4); }
+  uint8_t percent() const { return _percent; }
+  const battery_stats_t &stats() const { return _stats; }
+
+private:
+  battery_gauge_config_t _config;
+  uint32_t _state = 0; ///< Q4 battery millivolts
+  uint8_t _percent = 0;
+  battery_stats_t _stats = {};
+};
+
+#endif // BATTERY_GAUGE_H
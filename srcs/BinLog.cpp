@@ -0,0 +1,175 @@
+#include "BinLog.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#define BINLOG_FRAME_SYNC0 0xA5
+#define BINLOG_FRAME_SYNC1 0x5A
+#define BINLOG_HEADER_SIZE 8
+#define BINLOG_DRAIN_INTERVAL_MS 20
+#define BINLOG_LINE_SIZE 160
+
+static const uint8_t message_subsystem[BINLOG_MESSAGE_COUNT] = {
+#define BINLOG_SUBSYSTEM_ENTRY(name, subsystem, level, format) subsystem,
+    BINLOG_MESSAGES(BINLOG_SUBSYSTEM_ENTRY)
+#undef BINLOG_SUBSYSTEM_ENTRY
+};
+
+static const uint8_t message_level[BINLOG_MESSAGE_COUNT] = {
+#define BINLOG_LEVEL_ENTRY(name, subsystem, level, format) level,
+    BINLOG_MESSAGES(BINLOG_LEVEL_ENTRY)
+#undef BINLOG_LEVEL_ENTRY
+};
+
+static const char *const message_format[BINLOG_MESSAGE_COUNT] = {
+#define BINLOG_FORMAT_ENTRY(name, subsystem, level, format) format,
+    BINLOG_MESSAGES(BINLOG_FORMAT_ENTRY)
+#undef BINLOG_FORMAT_ENTRY
+};
+
+// Several tasks log, so writers serialize on a short critical section
+static binlog_record_t ring[BINLOG_RING_SIZE];
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+static uint32_t dropped = 0;
+static portMUX_TYPE ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static volatile uint8_t subsystem_level[BINLOG_SUBSYSTEM_COUNT] = {
+    BINLOG_LEVEL_DEBUG, BINLOG_LEVEL_DEBUG, BINLOG_LEVEL_DEBUG, BINLOG_LEVEL_DEBUG};
+static volatile binlog_output_t output_mode = BINLOG_OUTPUT_TEXT;
+static TaskHandle_t drain_task_handle = NULL;
+
+bool binlogEnabled(binlog_id_t id) {
+  return message_level[id] <= subsystem_level[message_subsystem[id]];
+}
+
+void binlogWriteRecord(binlog_id_t id, const uint32_t *args, uint8_t argc) {
+  const uint32_t now = (uint32_t)esp_timer_get_time();
+
+  portENTER_CRITICAL(&ring_mux);
+  if (ring_head - ring_tail >= BINLOG_RING_SIZE) {
+    dropped++;
+    portEXIT_CRITICAL(&ring_mux);
+    return;
+  }
+
+  binlog_record_t &record = ring[ring_head % BINLOG_RING_SIZE];
+  record.timestampUs = now;
+  record.id = (uint16_t)id;
+  record.argc = argc;
+  record.reserved = 0;
+  for (uint8_t i = 0; i < BINLOG_MAX_ARGS; i++) {
+    record.args[i] = i < argc ? args[i] : 0;
+  }
+  ring_head++;
+  portEXIT_CRITICAL(&ring_mux);
+}
+
+static bool pop_record(binlog_record_t &record) {
+  bool available = false;
+  portENTER_CRITICAL(&ring_mux);
+  if (ring_tail != ring_head) {
+    record = ring[ring_tail % BINLOG_RING_SIZE];
+    ring_tail++;
+    available = true;
+  }
+  portEXIT_CRITICAL(&ring_mux);
+  return available;
+}
+
+static void emit_text(const binlog_record_t &record) {
+  char line[BINLOG_LINE_SIZE];
+  const uint32_t *a = record.args;
+  snprintf(line, sizeof(line), message_format[record.id],
+           a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+  Serial.println(line);
+}
+
+static void emit_binary(const binlog_record_t &record) {
+  // Frame: sync (2) | timestamp (4) | id (2) | argc (1) | checksum (1) | args (4 * argc)
+  uint8_t frame[2 + BINLOG_HEADER_SIZE + 4 * BINLOG_MAX_ARGS];
+  size_t len = 0;
+
+  frame[len++] = BINLOG_FRAME_SYNC0;
+  frame[len++] = BINLOG_FRAME_SYNC1;
+  for (int i = 0; i < 4; i++) {
+    frame[len++] = (uint8_t)(record.timestampUs >> (8 * i));
+  }
+  frame[len++] = (uint8_t)record.id;
+  frame[len++] = (uint8_t)(record.id >> 8);
+  frame[len++] = record.argc;
+  const size_t checksum_pos = len++;
+  for (uint8_t arg = 0; arg < record.argc; arg++) {
+    for (int i = 0; i < 4; i++) {
+      frame[len++] = (uint8_t)(record.args[arg] >> (8 * i));
+    }
+  }
+
+  // XOR over header and args (sync bytes and the checksum slot excluded)
+  uint8_t checksum = 0;
+  for (size_t i = 2; i < len; i++) {
+    checksum ^= frame[i];
+  }
+  frame[checksum_pos] = checksum;
+
+  Serial.write(frame, len);
+}
+
+static void emit(const binlog_record_t &record) {
+  if (output_mode == BINLOG_OUTPUT_BINARY) {
+    emit_binary(record);
+  } else {
+    emit_text(record);
+  }
+}
+
+static void binlog_drain_task(void *pvParameters) {
+  uint32_t reported_dropped = 0;
+  binlog_record_t record;
+
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(BINLOG_DRAIN_INTERVAL_MS));
+
+    while (pop_record(record)) {
+      emit(record);
+    }
+
+    uint32_t total_dropped = dropped;
+    if (total_dropped != reported_dropped) {
+      record.timestampUs = (uint32_t)esp_timer_get_time();
+      record.id = BINLOG_LOG_DROPPED;
+      record.argc = 1;
+      record.reserved = 0;
+      record.args[0] = total_dropped - reported_dropped;
+      emit(record);
+      reported_dropped = total_dropped;
+    }
+  }
+}
+
+void binlogBegin() {
+  if (drain_task_handle != NULL) {
+    return;
+  }
+  // Lowest application priority: logging only runs when input handling is idle
+  xTaskCreatePinnedToCore(binlog_drain_task, "binlog", 3072, NULL, 1,
+                          &drain_task_handle, 1);
+}
+
+void binlogSetLevel(binlog_subsystem_t subsystem, binlog_level_t level) {
+  if (subsystem < BINLOG_SUBSYSTEM_COUNT) {
+    subsystem_level[subsystem] = level;
+  }
+}
+
+binlog_level_t binlogGetLevel(binlog_subsystem_t subsystem) {
+  return subsystem < BINLOG_SUBSYSTEM_COUNT ? (binlog_level_t)subsystem_level[subsystem]
+                                            : BINLOG_LEVEL_OFF;
+}
+
+void binlogSetOutput(binlog_output_t output) {
+  output_mode = output;
+}
+
+uint32_t binlogDroppedCount() {
+  return dropped;
+}
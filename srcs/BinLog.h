@@ -0,0 +1,125 @@
+/**
+ * @file BinLog.h
+ * @brief Deferred binary logging for the input hot path.
+ *
+ * A log call stores a fixed-size record (timestamp, message ID, raw 32-bit
+ * arguments) in a RAM ring and returns. A low-priority drain task later
+ * either formats the records as text on Serial or streams them as binary
+ * frames, which tools/binlog_decode.py turns back into text using the
+ * format strings from this header.
+ *
+ * Arguments are stored as 32-bit words, so format strings may only use
+ * integer conversions (%d, %u, %X, ...), never %s or floats.
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+
+/** @brief Subsystems with independently selectable verbosity. */
+typedef enum {
+  BINLOG_USB,
+  BINLOG_BRIDGE,
+  BINLOG_BLE,
+  BINLOG_DISPLAY,
+  BINLOG_SUBSYSTEM_COUNT
+} binlog_subsystem_t;
+
+typedef enum {
+  BINLOG_LEVEL_OFF,
+  BINLOG_LEVEL_ERROR,
+  BINLOG_LEVEL_INFO,
+  BINLOG_LEVEL_DEBUG
+} binlog_level_t;
+
+/** @brief How the drain task emits records. */
+typedef enum {
+  BINLOG_OUTPUT_TEXT,   ///< Format on the device (human readable serial monitor)
+  BINLOG_OUTPUT_BINARY, ///< Stream raw frames for tools/binlog_decode.py
+} binlog_output_t;
+
+// Message catalogue: X(name, subsystem, level, format)
+// IDs are assigned in order; append new messages at the end to keep old
+// captures decodable.
+#define BINLOG_MESSAGES(X)                                                                   \
+  X(USB_INPUT_REPORT, BINLOG_USB, BINLOG_LEVEL_DEBUG,                                        \
+    "[USB] Input Report - Interface: %d, Length: %d, Data: %08X %08X")                       \
+  X(KEYBOARD_STATE, BINLOG_BRIDGE, BINLOG_LEVEL_DEBUG,                                       \
+    "[KEYBOARD] Modifier: 0x%02X | Keys (%d): [%02X %02X %02X %02X %02X %02X]")              \
+  X(MOUSE_REPORT, BINLOG_BRIDGE, BINLOG_LEVEL_DEBUG,                                         \
+    "[MOUSE] Buttons: 0x%02X | X: %d | Y: %d | Wheel: %d")                                   \
+  X(CONSUMER_REPORT, BINLOG_BRIDGE, BINLOG_LEVEL_DEBUG,                                      \
+    "[CONSUMER] ReportID: 0x%02X, Usage: 0x%03X, Media: 0x%04X")                             \
+  X(GENERIC_REPORT, BINLOG_BRIDGE, BINLOG_LEVEL_DEBUG,                                       \
+    "[GENERIC] Length: %d, ReportID: 0x%02X, Data: %02X %02X %02X %02X %02X %02X")           \
+  X(DISPLAY_KEY_PRESSED, BINLOG_DISPLAY, BINLOG_LEVEL_DEBUG,                                 \
+    "[DISPLAY] Key pressed (total: %d) - Requested image %d")                                \
+  X(DISPLAY_KEY_RELEASED, BINLOG_DISPLAY, BINLOG_LEVEL_DEBUG,                                \
+    "[DISPLAY] Key released (total: %d)")                                                    \
+  X(LOG_DROPPED, BINLOG_BRIDGE, BINLOG_LEVEL_ERROR,                                          \
+    "[LOG] %u records dropped (ring full)")                                                  \
+  X(CONN_PARAMS_REQUEST, BINLOG_BLE, BINLOG_LEVEL_INFO,                                      \
+    "[BLE] Requesting interval %u-%u x 1.25 ms, latency %u, timeout %u x 10 ms")             \
+  X(CONN_PARAMS_REFUSED, BINLOG_BLE, BINLOG_LEVEL_ERROR,                                     \
+    "[BLE] Connection parameter request %u-%u/%u refused by the stack")                     \
+  X(SLOT_SWITCH, BINLOG_BRIDGE, BINLOG_LEVEL_INFO,                                           \
+    "[BLE] Switching to host slot %u")
+
+typedef enum {
+#define BINLOG_ENUM_ID(name, subsystem, level, format) BINLOG_##name,
+  BINLOG_MESSAGES(BINLOG_ENUM_ID)
+#undef BINLOG_ENUM_ID
+  BINLOG_MESSAGE_COUNT
+} binlog_id_t;
+
+#define BINLOG_MAX_ARGS 8
+#define BINLOG_RING_SIZE 128
+
+/** @brief One deferred log record. Streamed little-endian, args truncated to argc. */
+typedef struct {
+  uint32_t timestampUs;
+  uint16_t id;
+  uint8_t argc;
+  uint8_t reserved;
+  uint32_t args[BINLOG_MAX_ARGS];
+} binlog_record_t;
+
+/** @brief Starts the drain task. Records written before this are kept. */
+void binlogBegin();
+
+/** @brief Sets the verbosity of one subsystem. */
+void binlogSetLevel(binlog_subsystem_t subsystem, binlog_level_t level);
+
+/** @brief Returns the verbosity of one subsystem. */
+binlog_level_t binlogGetLevel(binlog_subsystem_t subsystem);
+
+/** @brief Selects text or binary output. */
+void binlogSetOutput(binlog_output_t output);
+
+/** @brief Number of records dropped because the ring was full. */
+uint32_t binlogDroppedCount();
+
+/** @brief True if a message passes its subsystem's current verbosity. */
+bool binlogEnabled(binlog_id_t id);
+
+/** @brief Stores one record. Use BINLOG() instead of calling this directly. */
+void binlogWriteRecord(binlog_id_t id, const uint32_t *args, uint8_t argc);
+
+template <typename... Args>
+inline void binlogWrite(binlog_id_t id, Args... args) {
+  static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many binlog arguments");
+  if (!binlogEnabled(id)) {
+    return;
+  }
+  const uint32_t packed[] = {0, (uint32_t)args...};
+  binlogWriteRecord(id, packed + 1, sizeof...(Args));
+}
+
+/**
+ * @brief Logs a catalogue message with up to BINLOG_MAX_ARGS integer arguments.
+ * Example: BINLOG(MOUSE_REPORT, buttons, x, y, wheel);
+ */
+#define BINLOG(name, ...) binlogWrite(BINLOG_##name, ##__VA_ARGS__)
+
+#endif // BINLOG_H
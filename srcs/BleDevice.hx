@@ -8,6 +8,24 @@
 #include <NimBLEDevice.h>
 #include <NimBLEServer.h>
 #include <NimBLEHIDDevice.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "ConsumerControl.h"
+#include "ConnParamGovernor.h"
+#include "HostSlots.h"
+#include "KeyState.h"
+#include "NotifyScheduler.h"
+#include "ReplayBuffer.h"
+
+/**
+ * @brief Timing of the last host slot switch, measured from the switch request.
+ */
+typedef struct {
+    uint8_t slot;
+    bool directed;        ///< Reconnected through directed advertising
+    uint32_t connectMs;   ///< Until the host connected, 0 if it has not yet
+    uint32_t firstKeyMs;  ///< Until the first keyboard report reached the host, 0 if none yet
+} slot_switch_stats_t;
 
 /**
  * @class BleDevice
@@ -22,8 +40,10 @@ private:
     NimBLECharacteristic* inputMouse;
     NimBLECharacteristic* inputJoystick;
     NimBLECharacteristic* inputKeyboard;
+    NimBLECharacteristic* inputKeyboardNkro;
     NimBLECharacteristic* outputKeyboard;
     NimBLECharacteristic* inputMediaKeys;
+    NimBLECharacteristic* inputConsumerArray = nullptr;
     NimBLEAdvertising* advertising;
     std::string deviceName;
     std::string deviceManufacturer;
@@ -31,12 +51,52 @@ private:
     bool connected = false;
     uint8_t ledStatus = 0;
 
-    // Mouse movement accumulation for throttling
-    int16_t _accumulatedX = 0;
-    int16_t _accumulatedY = 0;
-    int16_t _accumulatedWheel = 0;
-    unsigned long _lastMouseSendTime = 0;
-    static const uint16_t MOUSE_SEND_INTERVAL_MS = 5;
+    // Host slots: identity, name and bonded peer per slot, active slot persisted
+    HostSlots _slots;
+    bool _directedAdvertising = false;
+    int64_t _switchStartUs = 0;
+    bool _switchTiming = false;
+    slot_switch_stats_t _lastSwitch = {};
+    static const uint8_t SLOT_SWITCH_NONE = 0xFF;
+    uint8_t _pendingSlot = SLOT_SWITCH_NONE; // Guarded by _schedulerLock
+
+    // Keyboard, media and mouse reports are coalesced and sent once per
+    // connection event by the notify task; _schedulerLock guards the scheduler,
+    // the connection parameter governor and the pending keyboard report reset
+    NotifyScheduler _scheduler;
+    ConnParamGovernor _governor;
+    uint16_t _connHandle = 0;
+    portMUX_TYPE _schedulerLock = portMUX_INITIALIZER_UNLOCKED;
+    TaskHandle_t _notifyTask = nullptr;
+    enum KeyboardReset : uint8_t { KEYBOARD_RESET_NONE, KEYBOARD_RESET_CLEAR, KEYBOARD_RESET_FORCE };
+    KeyboardReset _keyboardResetPending = KEYBOARD_RESET_NONE;
+    // Set once the host subscribed to the keyboard report and was synced;
+    // until then keyboard states go to the replay buffer. The latest input
+    // state is kept for the sync whether or not a host is connected. A replay
+    // only goes back to the slot whose link dropped.
+    bool _linkReady = false;
+    uint32_t _connectMs = 0;
+    uint8_t _linkSlot = 0;
+    uint8_t _replaySlot = 0;
+    ReplayBuffer _replay;
+    uint8_t _keyModifiers = 0;
+    KeyBitmap _keyState = {};
+    ConsumerReport _consumerState = {};
+    uint8_t _mouseButtons = 0;
+
+    // Set while the notify task holds reports the stack refused; onStatus()
+    // then flags each finished notification so the task retries at once
+    bool _retryPending = false;
+    bool _txComplete = false;
+
+    // Keyboard reports built from the full key bitmap, owned by the notify task
+    KeyReportBuilder _keyReportBuilder;
+    uint8_t _lastBootReport[KEY_BOOT_REPORT_SIZE] = {0};
+    uint8_t _lastNkroReport[KEY_NKRO_REPORT_SIZE] = {0};
+    bool _nkroEnabled = true;
+
+    // Last consumer report notified, owned by the notify task
+    ConsumerReport _lastConsumer = {};
 
 public:
     /**
@@ -51,6 +111,29 @@ public:
      */
     void begin(void);
 
+    /**
+     * @brief Switch to another host slot.
+     *
+     * Only records the request and wakes the notify task, so it is cheap
+     * enough for the USB input task. The notify task then drops the link, takes on the slot's identity address and name
+     * and advertises directed to the slot's bonded host (undirected if the
+     * slot has none, or once directed advertising times out). The slot is
+     * saved and restored on the next boot.
+     * @param slot Slot index, 0 to HOST_SLOT_COUNT - 1
+     * @return false if the slot is out of range or already active (or pending)
+     */
+    bool switchSlot(uint8_t slot);
+
+    /**
+     * @brief Get the active host slot index.
+     */
+    uint8_t getActiveSlot() { return _slots.active(); }
+
+    /**
+     * @brief Get the timing of the last slot switch.
+     */
+    slot_switch_stats_t getLastSlotSwitch();
+
     /**
      * @brief Check if a BLE host is currently connected.
      * @return true if connected, false otherwise
@@ -64,20 +147,71 @@ public:
      */
     void sendKeyboard(const uint8_t *keys, uint8_t modifiers);
 
+    /**
+     * @brief Send the full keyboard state.
+     *
+     * Queued for the next connection event. The notify task builds the
+     * boot-compatible 6KRO report and the NKRO bitmap report and notifies
+     * only the ones whose content changed. Without a subscribed host the
+     * state is captured and replayed after the next sync (see setReplayWindow).
+     * @param modifiers Modifier byte (shift, ctrl, alt, etc)
+     * @param keys Bitmap of all held keys
+     */
+    void sendKeyboardState(uint8_t modifiers, const KeyBitmap &keys);
+
+    /**
+     * @brief Type text on the host without blocking.
+     *
+     * The text is compiled into keyboard states (see TextInjector.h) and sent
+     * a few per connection event next to live input.
+     * @param text ASCII text; characters without a US layout key are skipped
+     * @param packed false to send one press and one release per character
+     * @return Number of characters accepted; less than strlen(text) if the queue is full
+     */
+    size_t typeText(const char *text, bool packed = true);
+
+    /// True while injected text is still being sent.
+    bool isTyping();
+
+    /**
+     * @brief Set how long keyboard input captured without a host stays replayable.
+     *
+     * When a host subscribes it first gets the full current keyboard, consumer
+     * and mouse button state, then the keyboard states captured within the
+     * window, in order. 0 disables the replay; the sync still happens.
+     * @param windowMs Default REPLAY_DEFAULT_WINDOW_MS
+     */
+    void setReplayWindow(uint32_t windowMs);
+
+    /**
+     * @brief Enable or disable the NKRO report.
+     * When disabled all keys go through the 6KRO report.
+     */
+    void setNkroEnabled(bool enabled);
+
+    /**
+     * @brief Check if the NKRO report is in use.
+     */
+    bool isNkroEnabled() { return _nkroEnabled; }
+
     /**
      * @brief Send a mouse HID report with movement and button data.
+     *
+     * Motion is summed until the next connection event; the remainder is
+     * flushed on the following events even if no more input arrives.
      * @param buttons Mouse button states (bit 0=left, bit 1=right, bit 2=middle)
-     * @param x Relative X movement (-127 to 127)
-     * @param y Relative Y movement (-127 to 127)
+     * @param x Relative X movement; beyond +-127 it is sent over several reports
+     * @param y Relative Y movement, likewise
      * @param wheel Wheel movement (optional)
      */
-    void sendMouse(uint8_t buttons, int8_t x, int8_t y, int8_t wheel = 0);
+    void sendMouse(uint8_t buttons, int16_t x, int16_t y, int16_t wheel = 0);
 
     /**
-     * @brief Send a media control (consumer) HID report.
-     * @param consumerCode USB HID consumer code (0xE2=Mute, 0xE9=Vol+, 0xEA=Vol-, etc)
+     * @brief Send the combined consumer control state.
+     * @param report Media bitmap and array usages from ConsumerStateEngine; an empty
+     *               report releases everything
      */
-    void sendMedia(uint8_t consumerCode);
+    void sendConsumer(const ConsumerReport& report);
 
     /**
      * @brief Send a joystick HID report.
@@ -124,31 +258,140 @@ public:
      */
     std::string getConnectedClientName() { return connectedClientName; }
 
+    /**
+     * @brief Get the notify scheduler counters.
+     * @param intervalUs Receives the connection interval the scheduler runs at
+     */
+    notify_stats_t getNotifyStats(uint32_t *intervalUs = nullptr);
+
+    /**
+     * @brief Configure the activity-driven connection parameter governor.
+     * Takes effect with the next request.
+     */
+    void setConnParamConfig(const conn_governor_config_t &config);
+
+    /**
+     * @brief Get the connection parameter request counters.
+     * @param current Receives the parameters the host currently applies
+     */
+    conn_governor_stats_t getConnParamStats(conn_params_t *current = nullptr);
+
 protected:
     virtual void onConnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo) override;
     virtual void onDisconnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo, int reason) override;
+    virtual void onConnParamsUpdate(NimBLEConnInfo& connInfo) override;
+    virtual void onAuthenticationComplete(NimBLEConnInfo& connInfo) override;
     void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override;
+    void onStatus(NimBLECharacteristic* pCharacteristic, int code) override;
+    void onSubscribe(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo, uint16_t subValue) override;
 
 private:
+    /**
+     * @brief Notify task: sends the scheduled reports once per connection event.
+     *
+     * A report the stack refuses is held, with everything behind it in the
+     * batch, and resent on the next TX-complete event (onStatus) or
+     * connection event before a new batch is collected.
+     */
+    static void notifyTask(void* arg);
+
+    /**
+     * @brief Queue the full state and the captured replay for a newly subscribed host.
+     * Caller holds _schedulerLock.
+     */
+    void syncHost(uint32_t nowMs);
+
+    /**
+     * @brief Check whether input can go to the host, syncing one that never subscribed.
+     * Caller holds _schedulerLock.
+     */
+    bool linkReady(uint32_t nowMs);
+
+    /**
+     * @brief Wake the notify task after queueing a report.
+     */
+    void wakeNotifyTask();
+
+    /**
+     * @brief Wait for the notify task to free room in a full scheduler queue.
+     * Called without _schedulerLock; the caller then pushes the same state again.
+     */
+    void waitForQueueRoom(notify_report_t type);
+
+    /**
+     * @brief Send a connection parameter update requested by the governor.
+     */
+    void requestConnParams(const conn_params_t &params);
+
+    /**
+     * @brief Carry out a switchSlot() request; runs on the notify task.
+     */
+    void applySlotSwitch(uint8_t slot);
+
+    /**
+     * @brief Take on the active slot's identity and start advertising for it.
+     */
+    void applySlot();
+
+    /**
+     * @brief Start advertising for the active slot.
+     * @param directed Try directed advertising to the slot's bonded host first
+     */
+    void startAdvertising(bool directed);
+
+    /**
+     * @brief Restore the slot table from NVS.
+     */
+    void loadSlots();
+
+    /**
+     * @brief Save the slot table to NVS.
+     */
+    void saveSlots();
+
+    /**
+     * @brief Send one scheduled report.
+     * @return false if the stack refused a notification; sending the item
+     *         again only resends what did not go out
+     */
+    bool sendScheduled(const NotifyItem& item);
+
     /**
      * @brief Send raw keyboard report data.
+     * @return false if not connected or the stack refused the notification
+     *         (the same holds for the other raw report senders)
+     */
+    bool sendKeyboardReport(uint8_t* data, uint8_t len);
+
+    /**
+     * @brief Send raw NKRO keyboard report data.
+     */
+    bool sendKeyboardNkroReport(uint8_t* data, uint8_t len);
+
+    /**
+     * @brief Forget the last sent keyboard reports so the next state is sent in full.
      */
-    void sendKeyboardReport(uint8_t* data, uint8_t len);
+    void resetKeyboardReports();
 
     /**
      * @brief Send raw mouse report data.
      */
-    void sendMouseReport(uint8_t* data, uint8_t len);
+    bool sendMouseReport(uint8_t* data, uint8_t len);
 
     /**
      * @brief Send raw joystick report data.
      */
-    void sendJoystickReport(uint8_t* data, uint8_t len);
+    bool sendJoystickReport(uint8_t* data, uint8_t len);
 
     /**
      * @brief Send raw media report data.
      */
-    void sendMediaReport(uint8_t* data, uint8_t len);
+    bool sendMediaReport(uint8_t* data, uint8_t len);
+
+    /**
+     * @brief Send raw consumer array report data (no-op if the report is compiled out).
+     */
+    bool sendConsumerArrayReport(uint8_t* data, uint8_t len);
 
     /**
      * @brief Initialize NeoPixel RGB LED.
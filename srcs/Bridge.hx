@@ -10,8 +10,11 @@
 #define BRIDGE_H
 
 #include <Arduino.h>
-// #include "USBManager.h"
-// #include "BleDevice.h"
+#include "HidReportParser.h"
+#include "USBManager.h"
+#include "BleDevice.h"
+#include "BatteryGauge.h"
+#include "Keymap.h"
 
 /**
  * @class Bridge
@@ -25,29 +28,68 @@ public:
   /// Main loop for periodic status updates
   static void loop();
 
-  /// Callback for USB keyboard reports
-  static void onKeyboardReport(const uint8_t *data, size_t length);
+  /// Callback for decoded USB keyboard reports
+  static void onKeyboardReport(const HidDecodedReport &report);
 
-  /// Callback for USB mouse reports
-  static void onMouseReport(const uint8_t *data, size_t length);
+  /// Callback for decoded USB mouse reports
+  static void onMouseReport(const HidDecodedReport &report);
 
-  /// Callback for generic USB reports (consumer control, media keys, etc)
+  /// Callback for decoded USB consumer control reports (knob, media keys)
+  static void onConsumerReport(const HidDecodedReport &report);
+
+  /// Callback for raw USB reports that have no extraction plan (vendor, system control)
   static void onGenericReport(const uint8_t *data, size_t length);
 
+  /// Callback for an unplugged USB interface; releases whatever it was holding
+  static void onInterfaceReleased(uint8_t source, uint8_t kinds);
+
   /// Send mouse report via BLE
   static void sendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel = 0);
 
   /// Send joystick report via BLE
   static void sendJoystickReport(uint8_t buttons, uint8_t x, uint8_t y, uint8_t z = 127);
 
+  /// Type ASCII text on the BLE host; returns the number of characters queued
+  static size_t typeText(const char *text, bool packed = true);
+
+  /// True while typed text is still being sent
+  static bool isTyping();
+
+  /// Set how long keyboard input typed without a BLE host is replayed on reconnect (0: off)
+  static void setReplayWindow(uint32_t windowMs);
+
   /// Check if BLE device is connected
   static bool isConnected();
 
   /// Get connected client name/address
   static std::string getConnectedClientName();
 
+  /// Get the BLE notify scheduler counters and connection interval
+  static notify_stats_t getNotifyStats(uint32_t *intervalUs = nullptr);
+
+  /// Get the BLE connection parameter request counters and the current parameters
+  static conn_governor_stats_t getConnParamStats(conn_params_t *current = nullptr);
+
+  /// Get the keymap engine counters and the active layer mask
+  static keymap_stats_t getKeymapStats(uint8_t *layerState = nullptr);
+
+  /// Get the filtered battery voltage, the reported level and the sampler counters
+  static battery_stats_t getBatteryStats();
+
 private:
-  // static BleDevice bleDevice;
+  /// Receives the remapped keyboard state from the keymap engine
+  static void onKeymapOutput(uint8_t modifiers, const KeyBitmap &keys);
+
+  /// Types the text of a KM_MACRO key
+  static void onKeymapMacro(uint8_t index);
+
+  /// Fires keymap deadlines (tap-hold, combos) when they are due
+  static void keymapTask(void *arg);
+
+  /// Samples the battery once a second and updates the BLE Battery Service on change
+  static void batteryTask(void *arg);
+
+  static BleDevice bleDevice;
 };
 
 #endif // BRIDGE_H
@@ -0,0 +1,234 @@
+#include "Compositor.h"
+#include <string.h>
+
+static int16_t min16(int16_t a, int16_t b) {
+  return a < b ? a : b;
+}
+
+static int16_t max16(int16_t a, int16_t b) {
+  return a > b ? a : b;
+}
+
+DisplayRect DisplayRect::intersect(const DisplayRect &other) const {
+  const int16_t left = max16(x, other.x);
+  const int16_t top = max16(y, other.y);
+  const int16_t right = min16(x + w, other.x + other.w);
+  const int16_t bottom = min16(y + h, other.y + other.h);
+  return DisplayRect{left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+DisplayRect DisplayRect::unite(const DisplayRect &other) const {
+  if (empty()) {
+    return other;
+  }
+  if (other.empty()) {
+    return *this;
+  }
+  const int16_t left = min16(x, other.x);
+  const int16_t top = min16(y, other.y);
+  const int16_t right = max16(x + w, other.x + other.w);
+  const int16_t bottom = max16(y + h, other.y + other.h);
+  return DisplayRect{left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+void FramebufferSink::write(const DisplayRect &rect, const uint16_t *pixels) {
+  const DisplayRect clipped = rect.intersect(DisplayRect{0, 0, _width, _height});
+  if (clipped.empty()) {
+    return;
+  }
+  for (int16_t row = 0; row < clipped.h; row++) {
+    const uint16_t *src = pixels + (clipped.y - rect.y + row) * rect.w + (clipped.x - rect.x);
+    memcpy(_pixels + (clipped.y + row) * _width + clipped.x, src, clipped.w * sizeof(uint16_t));
+  }
+}
+
+void DamageList::remove(uint8_t i) {
+  _rects[i] = _rects[--_count];
+}
+
+void DamageList::add(const DisplayRect &rect) {
+  if (rect.empty()) {
+    return;
+  }
+
+  // Merging can make the union worth merging with another rectangle, so start over
+  DisplayRect merged = rect;
+  bool again = true;
+  while (again) {
+    again = false;
+    for (uint8_t i = 0; i < _count; i++) {
+      const DisplayRect bounds = merged.unite(_rects[i]);
+      if (bounds.area() <= merged.area() + _rects[i].area()) {
+        merged = bounds;
+        remove(i);
+        _merges++;
+        again = true;
+        break;
+      }
+    }
+  }
+
+  if (_count == COMPOSITOR_MAX_DAMAGE) {
+    // Full: merge with the rectangle whose bounding box grows least
+    uint8_t best = 0;
+    int32_t bestGrowth = INT32_MAX;
+    for (uint8_t i = 0; i < _count; i++) {
+      const int32_t growth = merged.unite(_rects[i]).area() - _rects[i].area();
+      if (growth < bestGrowth) {
+        bestGrowth = growth;
+        best = i;
+      }
+    }
+    _rects[best] = merged.unite(_rects[best]);
+    _merges++;
+    return;
+  }
+  _rects[_count++] = merged;
+}
+
+Compositor::Compositor(int16_t width, int16_t height, DisplaySink &sink)
+    : _width(width < COMPOSITOR_MAX_WIDTH ? width : COMPOSITOR_MAX_WIDTH), _height(height), _sink(sink) {
+  memset(_layers, 0, sizeof(_layers));
+  resetStats();
+}
+
+void Compositor::damage(const DisplayRect &rect) {
+  _damage.add(rect.intersect(DisplayRect{0, 0, _width, _height}));
+}
+
+void Compositor::setBackground(uint16_t color) {
+  _background = color;
+  invalidateAll();
+}
+
+void Compositor::setLayer(uint8_t id, const uint16_t *pixels, const DisplayRect &rect) {
+  if (id >= COMPOSITOR_MAX_LAYERS) {
+    return;
+  }
+  Layer &layer = _layers[id];
+  if (layer.visible && layer.pixels != nullptr) {
+    damage(layer.rect);
+  }
+  layer.pixels = pixels;
+  layer.rect = rect;
+  if (layer.visible && pixels != nullptr) {
+    damage(rect);
+  }
+}
+
+void Compositor::setPixels(uint8_t id, const uint16_t *pixels) {
+  if (id < COMPOSITOR_MAX_LAYERS) {
+    _layers[id].pixels = pixels;
+  }
+}
+
+void Compositor::setVisible(uint8_t id, bool visible) {
+  if (id >= COMPOSITOR_MAX_LAYERS || _layers[id].visible == visible) {
+    return;
+  }
+  _layers[id].visible = visible;
+  if (_layers[id].pixels != nullptr) {
+    damage(_layers[id].rect);
+  }
+}
+
+void Compositor::invalidate(uint8_t id) {
+  if (id < COMPOSITOR_MAX_LAYERS && _layers[id].visible && _layers[id].pixels != nullptr) {
+    damage(_layers[id].rect);
+  }
+}
+
+void Compositor::invalidate(uint8_t id, const DisplayRect &area) {
+  if (id < COMPOSITOR_MAX_LAYERS && _layers[id].visible && _layers[id].pixels != nullptr) {
+    const DisplayRect &rect = _layers[id].rect;
+    const DisplayRect local = area.intersect(DisplayRect{0, 0, rect.w, rect.h});
+    damage(DisplayRect{(int16_t)(rect.x + local.x), (int16_t)(rect.y + local.y), local.w, local.h});
+  }
+}
+
+void Compositor::invalidateAll() {
+  damage(DisplayRect{0, 0, _width, _height});
+}
+
+void Compositor::setMaxFps(uint8_t fps) {
+  _frameIntervalMs = fps > 0 ? 1000 / fps : 0;
+}
+
+uint32_t Compositor::msUntilFrame(uint32_t nowMs) const {
+  if (!dirty()) {
+    return UINT32_MAX;
+  }
+  const uint32_t elapsed = nowMs - _lastFrameMs;
+  if (!_framed || elapsed >= _frameIntervalMs) {
+    return 0;
+  }
+  return _frameIntervalMs - elapsed;
+}
+
+bool Compositor::frame(uint32_t nowMs) {
+  if (msUntilFrame(nowMs) != 0) {
+    return false;
+  }
+  if (!_sink.begin()) {
+    _stats.busy++;
+    return false; // Damage stays for the next attempt
+  }
+
+  uint8_t buffer = 0;
+  for (uint8_t i = 0; i < _damage.count(); i++) {
+    flushRect(_damage[i], buffer);
+  }
+  _sink.end();
+
+  _stats.frames++;
+  _stats.rects += _damage.count();
+  _damage.clear();
+  _lastFrameMs = nowMs;
+  _framed = true;
+  return true;
+}
+
+void Compositor::flushRect(const DisplayRect &rect, uint8_t &buffer) {
+  for (int16_t top = rect.y; top < rect.y + rect.h; top += COMPOSITOR_BAND_LINES) {
+    const DisplayRect band = {rect.x, top, rect.w, min16(COMPOSITOR_BAND_LINES, (int16_t)(rect.y + rect.h - top))};
+    uint16_t *out = _bands[buffer];
+
+    // Background, then every layer on top in id order
+    for (int32_t i = 0; i < band.area(); i++) {
+      out[i] = _background;
+    }
+    for (uint8_t id = 0; id < COMPOSITOR_MAX_LAYERS; id++) {
+      const Layer &layer = _layers[id];
+      if (!layer.visible || layer.pixels == nullptr) {
+        continue;
+      }
+      const DisplayRect overlap = band.intersect(layer.rect);
+      if (overlap.empty()) {
+        continue;
+      }
+      for (int16_t row = 0; row < overlap.h; row++) {
+        const uint16_t *src = layer.pixels + (overlap.y - layer.rect.y + row) * layer.rect.w +
+                              (overlap.x - layer.rect.x);
+        memcpy(out + (overlap.y - band.y + row) * band.w + (overlap.x - band.x), src,
+               overlap.w * sizeof(uint16_t));
+      }
+    }
+
+    // The sink may still be sending the other buffer; it finishes that before taking this one
+    _sink.write(band, out);
+    buffer ^= 1;
+    _stats.bands++;
+    _stats.pixels += band.area();
+  }
+}
+
+compositor_stats_t Compositor::stats() const {
+  compositor_stats_t stats = _stats;
+  stats.merges = _damage.merges() - _mergeBase;
+  return stats;
+}
+
+void Compositor::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+  _mergeBase = _damage.merges();
+}
@@ -0,0 +1,190 @@
+/**
+ * @file Compositor.h
+ * @brief Dirty-rectangle compositor that owns the screen.
+ *
+ * Widgets render into their own RGB565 sprites (in PSRAM on the device) and
+ * are registered as opaque layers. Changing a layer only marks the screen
+ * area it covers as damaged; damaged rectangles are merged when their
+ * bounding box is not larger than the two apart, so repeated updates of a
+ * widget within one frame are sent once.
+ *
+ * A frame composes each damaged rectangle band by band (background colour,
+ * then the layers in id order) into two alternating line buffers and hands
+ * every band to a DisplaySink. The sink may still be sending one band while
+ * the next one is composed into the other buffer, which is what lets the
+ * device sink use SPI DMA. Frames are capped to a configurable rate; damage
+ * that arrives in between waits for the next frame.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define COMPOSITOR_MAX_LAYERS 8
+#define COMPOSITOR_MAX_DAMAGE 8
+#define COMPOSITOR_MAX_WIDTH 240
+#define COMPOSITOR_BAND_LINES 16
+#define COMPOSITOR_DEFAULT_FPS 30
+
+/** @brief Screen rectangle; empty if w or h is not positive. */
+struct DisplayRect {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+
+  bool empty() const { return w <= 0 || h <= 0; }
+  int32_t area() const { return empty() ? 0 : (int32_t)w * h; }
+  DisplayRect intersect(const DisplayRect &other) const;
+  DisplayRect unite(const DisplayRect &other) const;
+};
+
+/**
+ * @brief Destination of composed pixels.
+ *
+ * write() may return before the transfer is done; the compositor leaves the
+ * buffer alone until the following write() or end() returned.
+ */
+class DisplaySink {
+public:
+  virtual ~DisplaySink() {}
+
+  /// Takes the display for one frame; false if it is busy, the frame is retried later.
+  virtual bool begin() = 0;
+
+  /// Sends rect.w x rect.h pixels, row by row.
+  virtual void write(const DisplayRect &rect, const uint16_t *pixels) = 0;
+
+  /// Waits for the last write and releases the display.
+  virtual void end() = 0;
+};
+
+/** @brief Sink that copies into a width x height framebuffer in memory. */
+class FramebufferSink : public DisplaySink {
+public:
+  FramebufferSink(uint16_t *pixels, int16_t width, int16_t height)
+      : _pixels(pixels), _width(width), _height(height) {}
+
+  bool begin() override { return true; }
+  void write(const DisplayRect &rect, const uint16_t *pixels) override;
+  void end() override {}
+
+  const uint16_t *pixels() const { return _pixels; }
+
+private:
+  uint16_t *_pixels;
+  int16_t _width;
+  int16_t _height;
+};
+
+/** @brief Pending damage, at most COMPOSITOR_MAX_DAMAGE rectangles. */
+class DamageList {
+public:
+  void clear() { _count = 0; }
+  uint8_t count() const { return _count; }
+  const DisplayRect &operator[](uint8_t i) const { return _rects[i]; }
+
+  /**
+   * @brief Adds rect. Two rectangles are merged when their bounding box has no more
+   * pixels than both apart; when the list is full, with the one that grows least.
+   */
+  void add(const DisplayRect &rect);
+
+  /// Rectangles merged into another since construction.
+  uint32_t merges() const { return _merges; }
+
+private:
+  void remove(uint8_t i);
+
+  DisplayRect _rects[COMPOSITOR_MAX_DAMAGE];
+  uint8_t _count = 0;
+  uint32_t _merges = 0;
+};
+
+typedef struct {
+  uint32_t frames;   ///< Frames flushed
+  uint32_t rects;    ///< Damaged rectangles flushed
+  uint32_t bands;    ///< Sink writes
+  uint32_t pixels;   ///< Pixels written to the sink
+  uint32_t merges;   ///< Damage rectangles merged into another
+  uint32_t busy;     ///< Frames postponed because the sink was busy
+} compositor_stats_t;
+
+class Compositor {
+public:
+  Compositor(int16_t width, int16_t height, DisplaySink &sink);
+
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  /// Colour of the area no layer covers.
+  void setBackground(uint16_t color);
+
+  /**
+   * @brief Places layer id (pixels: rect.w x rect.h, row by row) or moves it.
+   * The sprite must stay valid while the layer is set; nullptr removes the layer.
+   */
+  void setLayer(uint8_t id, const uint16_t *pixels, const DisplayRect &rect);
+
+  /**
+   * @brief Points layer id at another sprite of the same size without marking anything.
+   * The caller invalidates the area that actually changed.
+   */
+  void setPixels(uint8_t id, const uint16_t *pixels);
+
+  void setVisible(uint8_t id, bool visible);
+  bool visible(uint8_t id) const { return id < COMPOSITOR_MAX_LAYERS && _layers[id].visible; }
+
+  /// Marks the whole layer as changed, e.g. after its sprite was redrawn.
+  void invalidate(uint8_t id);
+
+  /// Marks part of a layer, in sprite coordinates, as changed.
+  void invalidate(uint8_t id, const DisplayRect &area);
+
+  void invalidateAll();
+
+  /// Caps the frame rate; 0 flushes on every frame() call.
+  void setMaxFps(uint8_t fps);
+
+  bool dirty() const { return _damage.count() > 0; }
+
+  /// Milliseconds until frame() would flush, UINT32_MAX if nothing is damaged.
+  uint32_t msUntilFrame(uint32_t nowMs) const;
+
+  /// Flushes the damage if a frame is due. Returns true if a frame was sent.
+  bool frame(uint32_t nowMs);
+
+  compositor_stats_t stats() const;
+  void resetStats();
+
+private:
+  struct Layer {
+    const uint16_t *pixels;
+    DisplayRect rect;
+    bool visible;
+  };
+
+  void damage(const DisplayRect &rect);
+  void flushRect(const DisplayRect &rect, uint8_t &buffer);
+
+  int16_t _width;
+  int16_t _height;
+  DisplaySink &_sink;
+  uint16_t _background = 0;
+  Layer _layers[COMPOSITOR_MAX_LAYERS];
+  DamageList _damage;
+  uint32_t _frameIntervalMs = 1000 / COMPOSITOR_DEFAULT_FPS;
+  uint32_t _lastFrameMs = 0;
+  bool _framed = false;
+  compositor_stats_t _stats;
+  uint32_t _mergeBase = 0;
+
+  // Two band buffers: one is composed while the sink sends the other
+  uint16_t _bands[2][COMPOSITOR_MAX_WIDTH * COMPOSITOR_BAND_LINES];
+};
+
+#endif // COMPOSITOR_H
@@ -0,0 +1,182 @@
+#include "ConnParamGovernor.h"
+
+conn_governor_config_t connGovernorDefaultConfig() {
+  conn_governor_config_t config = {};
+  config.active = {6, 6, 0, 400};      // 7.5 ms, no latency, 4 s timeout
+  config.idle[0] = {12, 24, 4, 400};   // 15-30 ms, skip up to 4 events
+  config.idle[1] = {36, 48, 8, 600};   // 45-60 ms, skip up to 8 events, 6 s timeout
+  config.idleAfterMs[0] = 2000;
+  config.idleAfterMs[1] = 30000;
+  // Hosts run service discovery right after connecting and tend to refuse updates meanwhile
+  config.connectSettleMs = 1000;
+  config.responseTimeoutMs = 3000;
+  config.retryDelayMs = 5000;
+  config.maxRetries = 2;
+  return config;
+}
+
+ConnParamGovernor::ConnParamGovernor(const conn_governor_config_t &config) : _config(config) {}
+
+void ConnParamGovernor::resetStats() {
+  _stats = {};
+}
+
+const conn_params_t &ConnParamGovernor::paramsFor(uint8_t level) const {
+  return level == LEVEL_ACTIVE ? _config.active : _config.idle[level - 1];
+}
+
+bool ConnParamGovernor::matches(const conn_params_t &applied, uint8_t level) const {
+  const conn_params_t &wanted = paramsFor(level);
+  return applied.minInterval >= wanted.minInterval && applied.maxInterval <= wanted.maxInterval &&
+         applied.latency == wanted.latency;
+}
+
+uint8_t ConnParamGovernor::idleLevel(uint32_t idleMs) const {
+  uint8_t level = LEVEL_ACTIVE;
+  for (uint8_t i = 0; i < CONN_GOVERNOR_IDLE_LEVELS; i++) {
+    if (idleMs >= _config.idleAfterMs[i]) {
+      level = i + 1;
+    }
+  }
+  return level;
+}
+
+void ConnParamGovernor::onConnect(uint32_t nowMs, const conn_params_t &current) {
+  _connected = true;
+  _current = current;
+  _target = LEVEL_ACTIVE;
+  _applied = matches(current, LEVEL_ACTIVE) ? LEVEL_ACTIVE : 0xFF;
+  _retries = 0;
+  _settled = false;
+  _awaitingUpdate = false;
+  _notBeforeMs = nowMs + _config.connectSettleMs;
+  _lastActivityMs = nowMs;
+}
+
+void ConnParamGovernor::onDisconnect() {
+  _connected = false;
+  _awaitingUpdate = false;
+}
+
+void ConnParamGovernor::onActivity(uint32_t nowMs) {
+  _lastActivityMs = nowMs;
+  if (!_connected || _target == LEVEL_ACTIVE) {
+    return;
+  }
+
+  // Re-tighten right away, skipping any retry delay left from the relaxed level
+  _target = LEVEL_ACTIVE;
+  _retries = 0;
+  _settled = false;
+  if ((int32_t)(_notBeforeMs - nowMs) > 0) {
+    _notBeforeMs = nowMs;
+  }
+  _stats.tightened++;
+}
+
+bool ConnParamGovernor::poll(uint32_t nowMs, conn_params_t &request) {
+  if (!_connected) {
+    return false;
+  }
+
+  if (_awaitingUpdate) {
+    if (nowMs - _requestMs < _config.responseTimeoutMs) {
+      return false;
+    }
+    failRequest(nowMs);
+  }
+
+  const uint8_t level = idleLevel(nowMs - _lastActivityMs);
+  if (level > _target) {
+    _target = level;
+    _retries = 0;
+    _settled = false;
+    _stats.relaxed++;
+  }
+
+  if (_applied == _target || _settled || (int32_t)(nowMs - _notBeforeMs) < 0) {
+    return false;
+  }
+
+  request = paramsFor(_target);
+  _requestLevel = _target;
+  _awaitingUpdate = true;
+  _requestMs = nowMs;
+  _stats.requests++;
+  if (_retries > 0) {
+    _stats.retries++;
+  }
+  return true;
+}
+
+void ConnParamGovernor::failRequest(uint32_t nowMs) {
+  _awaitingUpdate = false;
+  _stats.rejected++;
+  if (++_retries > _config.maxRetries) {
+    _settled = true; // Keep whatever the host runs until the target changes
+  }
+  _notBeforeMs = nowMs + _config.retryDelayMs;
+}
+
+void ConnParamGovernor::onRequestResult(uint32_t nowMs, bool ok) {
+  // On success wait for onParamsUpdated(), which may already have arrived
+  if (!ok && _awaitingUpdate) {
+    failRequest(nowMs);
+  }
+}
+
+void ConnParamGovernor::onParamsUpdated(uint32_t nowMs, const conn_params_t &applied) {
+  _current = applied;
+  const bool matched = matches(applied, _target);
+  _applied = matched ? _target : 0xFF;
+
+  if (!_awaitingUpdate) {
+    return; // Host-initiated change; poll() asks again if it moved us off target
+  }
+  _awaitingUpdate = false;
+
+  if (matches(applied, _requestLevel)) {
+    _stats.accepted++;
+    if (matched) {
+      _retries = 0;
+    } else {
+      _notBeforeMs = nowMs; // Target changed while the request was in flight
+    }
+    return;
+  }
+
+  // The host picked something else, e.g. a 15 ms floor; retry a few times, then live with it
+  _stats.adjusted++;
+  if (++_retries > _config.maxRetries) {
+    _settled = true;
+  }
+  _notBeforeMs = nowMs + _config.retryDelayMs;
+}
+
+uint32_t ConnParamGovernor::msUntilDue(uint32_t nowMs) const {
+  if (!_connected) {
+    return UINT32_MAX;
+  }
+
+  // Nothing else happens until the pending request is answered or times out
+  if (_awaitingUpdate) {
+    const uint32_t waited = nowMs - _requestMs;
+    return waited >= _config.responseTimeoutMs ? 0 : _config.responseTimeoutMs - waited;
+  }
+
+  uint32_t due = UINT32_MAX;
+  if (_applied != _target && !_settled) {
+    due = (int32_t)(_notBeforeMs - nowMs) > 0 ? _notBeforeMs - nowMs : 0;
+  }
+
+  // Next idle step-down
+  if (_target < CONN_GOVERNOR_IDLE_LEVELS) {
+    const uint32_t idleMs = nowMs - _lastActivityMs;
+    const uint32_t stepAt = _config.idleAfterMs[_target];
+    const uint32_t untilStep = idleMs >= stepAt ? 0 : stepAt - idleMs;
+    if (untilStep < due) {
+      due = untilStep;
+    }
+  }
+  return due;
+}
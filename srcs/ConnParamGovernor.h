@@ -0,0 +1,124 @@
+/**
+ * @file ConnParamGovernor.h
+ * @brief Activity-driven BLE connection parameter negotiation.
+ *
+ * Hosts usually pick a 15-30 ms connection interval, which adds up to a full
+ * interval of latency to every report. The governor asks for the fastest
+ * interval with no slave latency while input is flowing and steps down to
+ * relaxed intervals with slave latency after configurable idle periods, so
+ * the radio can sleep. The first report after a step-down re-tightens the
+ * link right away.
+ *
+ * The governor is a pure state machine: it only decides which parameters to
+ * request and when. The caller sends the request (NimBLEServer::updateConnParams),
+ * reports whether the stack accepted it and forwards the parameters the host
+ * applied (onConnParamsUpdate). A request that gets no update within the
+ * response timeout counts as rejected and is retried a limited number of
+ * times. Times are in milliseconds, BLE parameters in their native units
+ * (interval 1.25 ms, timeout 10 ms).
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef CONN_PARAM_GOVERNOR_H
+#define CONN_PARAM_GOVERNOR_H
+
+#include <stdint.h>
+
+/** @brief Number of relaxed levels below the active one. */
+#define CONN_GOVERNOR_IDLE_LEVELS 2
+
+/** @brief One set of connection parameters in BLE units. */
+typedef struct {
+  uint16_t minInterval; ///< 1.25 ms units
+  uint16_t maxInterval; ///< 1.25 ms units
+  uint16_t latency;     ///< Connection events the peripheral may skip
+  uint16_t timeout;     ///< Supervision timeout, 10 ms units
+} conn_params_t;
+
+typedef struct {
+  conn_params_t active;                            ///< Requested while input is flowing
+  conn_params_t idle[CONN_GOVERNOR_IDLE_LEVELS];   ///< Relaxed levels, slowest last
+  uint32_t idleAfterMs[CONN_GOVERNOR_IDLE_LEVELS]; ///< Idle time before each level, ascending
+  uint32_t connectSettleMs;   ///< Delay after connecting before the first request
+  uint32_t responseTimeoutMs; ///< No update within this time counts as a rejection
+  uint32_t retryDelayMs;      ///< Delay before retrying a rejected request
+  uint8_t maxRetries;         ///< Retries per target level before accepting the host's choice
+} conn_governor_config_t;
+
+typedef struct {
+  uint32_t requests;  ///< Requests handed to the stack
+  uint32_t accepted;  ///< Updates that matched the requested parameters
+  uint32_t adjusted;  ///< Updates the host applied with other parameters
+  uint32_t rejected;  ///< Requests refused by the stack or never answered
+  uint32_t retries;   ///< Requests repeated after a rejection
+  uint32_t tightened; ///< Activity-triggered returns to the active level
+  uint32_t relaxed;   ///< Idle step-downs
+} conn_governor_stats_t;
+
+/** @brief Defaults: 7.5 ms active, 30 ms/latency 4 after 2 s, 60 ms/latency 8 after 30 s. */
+conn_governor_config_t connGovernorDefaultConfig();
+
+class ConnParamGovernor {
+public:
+  static const uint8_t LEVEL_ACTIVE = 0;
+
+  ConnParamGovernor() : ConnParamGovernor(connGovernorDefaultConfig()) {}
+  explicit ConnParamGovernor(const conn_governor_config_t &config);
+
+  void setConfig(const conn_governor_config_t &config) { _config = config; }
+  const conn_governor_config_t &config() const { return _config; }
+
+  /// A host connected with the given parameters; starts out at the active level.
+  void onConnect(uint32_t nowMs, const conn_params_t &current);
+
+  void onDisconnect();
+
+  /// An input report is about to be sent.
+  void onActivity(uint32_t nowMs);
+
+  /**
+   * @brief Advances the state machine.
+   * @param request Receives the parameters to request when true is returned
+   * @return true if the caller should send a connection parameter update now
+   */
+  bool poll(uint32_t nowMs, conn_params_t &request);
+
+  /// Result of the updateConnParams() call for the last request from poll().
+  void onRequestResult(uint32_t nowMs, bool ok);
+
+  /// The host applied new parameters (requested or not).
+  void onParamsUpdated(uint32_t nowMs, const conn_params_t &applied);
+
+  /// Milliseconds until poll() has something to do, UINT32_MAX if only activity can change that.
+  uint32_t msUntilDue(uint32_t nowMs) const;
+
+  bool isConnected() const { return _connected; }
+  uint8_t targetLevel() const { return _target; }
+  const conn_params_t &currentParams() const { return _current; }
+  const conn_governor_stats_t &stats() const { return _stats; }
+  void resetStats();
+
+private:
+  const conn_params_t &paramsFor(uint8_t level) const;
+  bool matches(const conn_params_t &applied, uint8_t level) const;
+  uint8_t idleLevel(uint32_t idleMs) const;
+  void failRequest(uint32_t nowMs);
+
+  conn_governor_config_t _config;
+  conn_governor_stats_t _stats = {};
+  conn_params_t _current = {};
+
+  bool _connected = false;
+  uint8_t _target = LEVEL_ACTIVE;  ///< Level we want
+  uint8_t _applied = 0xFF;         ///< Level the host is known to run at, 0xFF if none
+  uint8_t _retries = 0;            ///< Rejections of the current target
+  bool _settled = false;           ///< Retries exhausted; keep what the host chose
+  bool _awaitingUpdate = false;
+  uint8_t _requestLevel = LEVEL_ACTIVE; ///< Level of the pending request
+  uint32_t _requestMs = 0;         ///< When the pending request was sent
+  uint32_t _notBeforeMs = 0;       ///< Earliest time for the next request
+  uint32_t _lastActivityMs = 0;
+};
+
+#endif // CONN_PARAM_GOVERNOR_H
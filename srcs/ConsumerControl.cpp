@@ -0,0 +1,99 @@
+#include "ConsumerControl.h"
+#include <string.h>
+
+void ConsumerStateEngine::clear() {
+  memset(_sourceUsages, 0, sizeof(_sourceUsages));
+  memset(&_report, 0, sizeof(_report));
+  _pressedMedia = 0;
+  _releasedMedia = 0;
+  _dropped = 0;
+}
+
+bool ConsumerStateEngine::update(uint8_t source, const uint16_t *usages, uint8_t count) {
+  if (source >= CONSUMER_MAX_SOURCES) {
+    source = CONSUMER_MAX_SOURCES - 1;
+  }
+
+  uint16_t *held = _sourceUsages[source];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (usages[i] == 0) {
+      continue;
+    }
+    if (usages[i] >= CONSUMER_USAGE_LIMIT || n == CONSUMER_SOURCE_USAGES) {
+      _dropped++;
+      continue;
+    }
+    held[n++] = usages[i];
+  }
+  for (; n < CONSUMER_SOURCE_USAGES; n++) {
+    held[n] = 0;
+  }
+  return recompute();
+}
+
+bool ConsumerStateEngine::releaseSource(uint8_t source) {
+  if (source >= CONSUMER_MAX_SOURCES) {
+    return false;
+  }
+  memset(_sourceUsages[source], 0, sizeof(_sourceUsages[source]));
+  return recompute();
+}
+
+bool ConsumerStateEngine::recompute() {
+  ConsumerReport next = {};
+
+  // Usages that stay held keep their array slot
+  for (int slot = 0; slot < CONSUMER_ARRAY_SLOTS; slot++) {
+    const uint16_t usage = _report.array[slot];
+    for (int s = 0; s < CONSUMER_MAX_SOURCES && usage != 0 && next.array[slot] == 0; s++) {
+      for (int i = 0; i < CONSUMER_SOURCE_USAGES; i++) {
+        if (_sourceUsages[s][i] == usage) {
+          next.array[slot] = usage;
+          break;
+        }
+      }
+    }
+  }
+
+  for (int s = 0; s < CONSUMER_MAX_SOURCES; s++) {
+    for (int i = 0; i < CONSUMER_SOURCE_USAGES; i++) {
+      const uint16_t usage = _sourceUsages[s][i];
+      if (usage == 0) {
+        continue;
+      }
+      const int bit = consumerMediaBit(usage);
+      if (bit >= 0) {
+        next.media |= (uint16_t)(1u << bit);
+        continue;
+      }
+
+      int free = -1;
+      bool present = false;
+      for (int slot = 0; slot < CONSUMER_ARRAY_SLOTS; slot++) {
+        if (next.array[slot] == usage) {
+          present = true;
+          break;
+        }
+        if (next.array[slot] == 0 && free < 0) {
+          free = slot;
+        }
+      }
+      if (!present) {
+        if (free >= 0) {
+          next.array[free] = usage;
+        } else {
+          _dropped++;
+        }
+      }
+    }
+  }
+
+  if (next == _report) {
+    return false;
+  }
+  _pressedMedia = next.media & ~_report.media;
+  _releasedMedia = _report.media & ~next.media;
+  _report = next;
+  return true;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file ConsumerControl.h
+ * @brief Consumer page (media key) state: 16-bit usages to BLE reports.
+ *
+ * The BLE media report is a 16-bit bitmap with one fixed usage per bit (see
+ * CONSUMER_MEDIA_USAGES). Usages map to bits through a lookup table generated
+ * at compile time from that list, so adding a bit to the descriptor and to
+ * the list is all it takes. Usages without a bit go to a small array report
+ * that can carry any consumer usage below CONSUMER_USAGE_LIMIT.
+ *
+ * Like KeyStateEngine, the engine keeps the full state of every source and
+ * reports the union. Output only changes when a usage is pressed or
+ * released, so each press is followed by exactly one release, also when two
+ * sources hold the same usage or a device reports a release as an empty
+ * report.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef CONSUMER_CONTROL_H
+#define CONSUMER_CONTROL_H
+
+#include <stdint.h>
+#include <array>
+
+#define CONSUMER_MEDIA_BITS 16
+/** @brief Slots of the array report; also the usages held per source. */
+#define CONSUMER_ARRAY_SLOTS 2
+#define CONSUMER_SOURCE_USAGES 4
+#define CONSUMER_MAX_SOURCES 4
+/** @brief Usages at or above this are dropped (array report logical maximum + 1). */
+#define CONSUMER_USAGE_LIMIT 0x400
+
+/** @brief Usage of each media bitmap bit, in the order of the report descriptor. */
+constexpr uint16_t CONSUMER_MEDIA_USAGES[CONSUMER_MEDIA_BITS] = {
+    0x0B5, // Scan Next Track
+    0x0B6, // Scan Previous Track
+    0x0B7, // Stop
+    0x0CD, // Play/Pause
+    0x0E2, // Mute
+    0x0E9, // Volume Increment
+    0x0EA, // Volume Decrement
+    0x223, // WWW Home
+    0x194, // My Computer
+    0x192, // Calculator
+    0x22A, // WWW Favorites
+    0x221, // WWW Search
+    0x226, // WWW Stop
+    0x224, // WWW Back
+    0x183, // Media Select
+    0x18A, // Mail
+};
+
+constexpr std::array<int8_t, CONSUMER_USAGE_LIMIT> consumerMediaTable() {
+  std::array<int8_t, CONSUMER_USAGE_LIMIT> table{};
+  for (int i = 0; i < CONSUMER_USAGE_LIMIT; i++) {
+    table[i] = -1;
+  }
+  for (int bit = 0; bit < CONSUMER_MEDIA_BITS; bit++) {
+    table[CONSUMER_MEDIA_USAGES[bit]] = (int8_t)bit;
+  }
+  return table;
+}
+
+/** @brief Usage to media bit, -1 for usages without a bit. */
+constexpr std::array<int8_t, CONSUMER_USAGE_LIMIT> CONSUMER_MEDIA_TABLE = consumerMediaTable();
+
+static_assert(CONSUMER_MEDIA_TABLE[0x0E9] == 5, "Volume Increment must be media bit 5");
+static_assert(CONSUMER_MEDIA_TABLE[0x18A] == 15, "Mail must be media bit 15");
+
+/// Media bit of a usage, -1 if it has none.
+inline int consumerMediaBit(uint16_t usage) {
+  return usage < CONSUMER_USAGE_LIMIT ? CONSUMER_MEDIA_TABLE[usage] : -1;
+}
+
+/** @brief Combined consumer state as sent to the host. */
+struct ConsumerReport {
+  uint16_t media;                        ///< Media bitmap, bit n = CONSUMER_MEDIA_USAGES[n]
+  uint16_t array[CONSUMER_ARRAY_SLOTS];  ///< Other held usages, 0 = empty slot
+
+  bool operator==(const ConsumerReport &other) const {
+    for (int i = 0; i < CONSUMER_ARRAY_SLOTS; i++) {
+      if (array[i] != other.array[i]) {
+        return false;
+      }
+    }
+    return media == other.media;
+  }
+  bool operator!=(const ConsumerReport &other) const { return !(*this == other); }
+};
+
+/**
+ * @class ConsumerStateEngine
+ * @brief Tracks the held consumer usages of up to CONSUMER_MAX_SOURCES interfaces.
+ */
+class ConsumerStateEngine {
+public:
+  ConsumerStateEngine() { clear(); }
+
+  void clear();
+
+  /**
+   * @brief Replaces the held usages of one source (0 entries are ignored).
+   * @return true if the combined report changed and should be sent
+   */
+  bool update(uint8_t source, const uint16_t *usages, uint8_t count);
+
+  /// Drops the state of one source, e.g. on disconnect.
+  bool releaseSource(uint8_t source);
+
+  const ConsumerReport &report() const { return _report; }
+
+  /// Media bits that went down / up in the last change.
+  uint16_t pressedMedia() const { return _pressedMedia; }
+  uint16_t releasedMedia() const { return _releasedMedia; }
+
+  /// Usages dropped because they were out of range or the array report was full.
+  uint32_t dropped() const { return _dropped; }
+
+private:
+  bool recompute();
+
+  uint16_t _sourceUsages[CONSUMER_MAX_SOURCES][CONSUMER_SOURCE_USAGES];
+  ConsumerReport _report;
+  uint16_t _pressedMedia;
+  uint16_t _releasedMedia;
+  uint32_t _dropped;
+};
+
+#endif // CONSUMER_CONTROL_H
@@ -2,6 +2,52 @@
 #define DISPLAY_H
 
 #include "TFT_eSPI.h"
+#include "Compositor.h"
+#include "SpriteCache.h"
+#include "GlyphAtlas.h"
+
+// Screen layout (rotation 2, portrait). Widgets are compositor layers in this order.
+#define DISPLAY_WIDTH 240
+#define DISPLAY_HEIGHT 320
+#define DISPLAY_MAX_FPS 30
+#define DISPLAY_BONGO_X 0 // Cached frames are cropped to the screen width
+#define DISPLAY_BONGO_Y 0
+#define DISPLAY_KEY_TEXT_SIZE 10
+#define DISPLAY_KEY_W (6 * DISPLAY_KEY_TEXT_SIZE) // One built-in font cell
+#define DISPLAY_KEY_H (8 * DISPLAY_KEY_TEXT_SIZE)
+#define DISPLAY_KEY_X (DISPLAY_WIDTH / 2 - 30)
+#define DISPLAY_KEY_Y (DISPLAY_HEIGHT / 2 - 40)
+#define DISPLAY_WAITING_W 120 // "Waiting..." at text size 2
+#define DISPLAY_WAITING_H 16
+#define DISPLAY_WAITING_X (DISPLAY_WIDTH / 2 - 50)
+#define DISPLAY_WAITING_Y (DISPLAY_HEIGHT / 2)
+#define DISPLAY_STATUS_W 220
+#define DISPLAY_STATUS_H 8
+#define DISPLAY_STATUS_X 10
+#define DISPLAY_STATUS_Y 300
+
+enum : uint8_t { DISPLAY_LAYER_BONGO, DISPLAY_LAYER_KEY, DISPLAY_LAYER_WAITING, DISPLAY_LAYER_STATUS };
+
+// Bongo frame cache and swap timing
+typedef struct {
+  sprite_cache_stats_t cache; ///< Frames and PSRAM bytes held
+  uint32_t decodeMs;          ///< Time spent decoding the cache at boot
+  uint32_t mapped;            ///< Cached images read from the asset partition instead of SPIFFS
+  uint32_t swaps;             ///< Frame swaps flushed
+  uint32_t dropped;           ///< Requests replaced by a newer one before they were shown
+  uint32_t swapPixels;        ///< Pixels that differed in the last swap
+  uint32_t lastSwapUs;        ///< Flush time of the frame that carried the last swap
+  uint32_t maxSwapUs;
+} display_image_stats_t;
+
+// Key readout: time to draw a key into its sprite (the flush is counted by the compositor)
+typedef struct {
+  uint32_t renders;
+  uint32_t atlasRenders; ///< Expanded from the glyph atlas; the rest went through the scaled font
+  uint32_t lastRenderUs;
+  uint32_t maxRenderUs;
+  uint32_t atlasBytes;   ///< PSRAM held by the key and status line atlases
+} display_key_stats_t;
 
 // External TFT instance
 extern TFT_eSPI tft;
@@ -14,5 +60,18 @@ void displayKeyReleased();
 void displayJPEG(const char* filename, int x, int y);
 void displayClearScreen();
 void displayListSPIFFSFiles();
- 
+
+// Status line at the bottom of the screen; only redrawn when the text changes
+void displaySetStatus(const char* text);
+
+// Compositor counters: frames, pixels pushed, merged damage
+compositor_stats_t displayGetStats();
+
+// Decodes the bongo frames and the logo into the PSRAM cache (displayInit does this)
+void displayCacheImages();
+
+display_image_stats_t displayGetImageStats();
+
+display_key_stats_t displayGetKeyStats();
+
 #endif // DISPLAY_H
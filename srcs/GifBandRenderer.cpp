@@ -0,0 +1,127 @@
+#include "GifBandRenderer.h"
+#include <string.h>
+
+static int16_t min16(int16_t a, int16_t b) {
+  return a < b ? a : b;
+}
+
+static int16_t max16(int16_t a, int16_t b) {
+  return a > b ? a : b;
+}
+
+GifBandRenderer::GifBandRenderer(uint16_t *canvas, int16_t width, int16_t height, int16_t x, int16_t y,
+                                 DisplaySink &sink)
+    : _canvas(canvas), _width(width < GIF_MAX_WIDTH ? width : GIF_MAX_WIDTH), _height(height), _x(x), _y(y),
+      _sink(sink) {}
+
+void GifBandRenderer::clear(uint16_t color) {
+  for (int32_t i = 0; i < (int32_t)_width * _height; i++) {
+    _canvas[i] = color;
+  }
+  _postponed = DisplayRect{0, 0, _width, _height};
+}
+
+void GifBandRenderer::drawLine(int16_t y, int16_t x, int16_t w, const uint8_t *indices, const uint16_t *palette,
+                               int16_t transparent) {
+  if (y < 0 || y >= _height || x >= _width) {
+    return;
+  }
+  if (x < 0) {
+    indices -= x;
+    w += x;
+    x = 0;
+  }
+  w = min16(w, (int16_t)(_width - x));
+  _stats.lines++;
+
+  // Only the visible pixels change the canvas; the span runs from the first to the last of them
+  uint16_t *row = _canvas + (int32_t)y * _width + x;
+  int16_t left = -1;
+  int16_t right = -1;
+  for (int16_t i = 0; i < w; i++) {
+    if (indices[i] == transparent) {
+      continue;
+    }
+    row[i] = palette[indices[i]];
+    if (left < 0) {
+      left = i;
+    }
+    right = i;
+  }
+  if (left < 0) {
+    _stats.skippedLines++;
+    return;
+  }
+  markBand(y / GIF_BAND_LINES, y, y, x + left, x + right);
+}
+
+void GifBandRenderer::markBand(int16_t band, int16_t top, int16_t bottom, int16_t left, int16_t right) {
+  if (band != _band) {
+    flushBand();
+    _band = band;
+    _top = top;
+    _bottom = bottom;
+    _left = left;
+    _right = right;
+    return;
+  }
+  _top = min16(_top, top);
+  _bottom = max16(_bottom, bottom);
+  _left = min16(_left, left);
+  _right = max16(_right, right);
+}
+
+void GifBandRenderer::flushBand() {
+  if (_band < 0) {
+    return;
+  }
+  _band = -1;
+  const DisplayRect rect = {_left, _top, (int16_t)(_right - _left + 1), (int16_t)(_bottom - _top + 1)};
+
+  if (!_sinkOpen) {
+    if (!_postponed.empty() || !_sink.begin()) {
+      // Busy earlier in this frame or now: send it once the sink is free again
+      if (_postponed.empty()) {
+        _stats.busy++;
+      }
+      _postponed = _postponed.unite(rect);
+      return;
+    }
+    _sinkOpen = true;
+  }
+
+  uint16_t *out = _bands[_buffer];
+  for (int16_t row = 0; row < rect.h; row++) {
+    memcpy(out + row * rect.w, _canvas + (int32_t)(rect.y + row) * _width + rect.x, rect.w * sizeof(uint16_t));
+  }
+  // The sink may still be sending the other buffer; it finishes that before taking this one
+  _sink.write(DisplayRect{(int16_t)(_x + rect.x), (int16_t)(_y + rect.y), rect.w, rect.h}, out);
+  _buffer ^= 1;
+  _stats.bands++;
+  _stats.pixels += rect.area();
+}
+
+void GifBandRenderer::endFrame() {
+  flushBand();
+
+  if (!_postponed.empty() && (_sinkOpen || _sink.begin())) {
+    _sinkOpen = true;
+    // The canvas holds the newest pixels, so the whole postponed area goes out band by band
+    const DisplayRect area = _postponed;
+    _postponed = DisplayRect{0, 0, 0, 0};
+    for (int16_t top = area.y; top < area.y + area.h; top += GIF_BAND_LINES) {
+      _band = top / GIF_BAND_LINES;
+      _top = top;
+      _bottom = min16((int16_t)(top + GIF_BAND_LINES), (int16_t)(area.y + area.h)) - 1;
+      _left = area.x;
+      _right = area.x + area.w - 1;
+      flushBand();
+    }
+  }
+
+  if (_sinkOpen) {
+    _sink.end();
+    _sinkOpen = false;
+  }
+  _stats.frames++;
+}
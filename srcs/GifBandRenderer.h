@@ -0,0 +1,93 @@
+/**
+ * @file GifBandRenderer.h
+ * @brief Collects decoded GIF lines and pushes them to the display in bands.
+ *
+ * The GIF decoder hands over one line of palette indices at a time. Sending
+ * each line on its own costs an address window, a bus transaction and a
+ * display lock per line. The renderer writes the visible pixels of each
+ * line into a canvas (in PSRAM on the device) instead, and remembers which
+ * columns changed. Fully transparent lines and the transparent runs at the
+ * ends of a line change nothing. When the decoder moves past a band of
+ * GIF_BAND_LINES lines, the changed rectangle of that band is copied from
+ * the canvas into one of two band buffers and written to the DisplaySink
+ * as a single transfer. The sink is taken once per frame.
+ *
+ * Transparent pixels inside a changed span keep the previous frame's
+ * colour, which the canvas still holds. If the sink is busy, the frame's
+ * changes are kept and sent with the next frame.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef GIF_BAND_RENDERER_H
+#define GIF_BAND_RENDERER_H
+
+#include <stdint.h>
+#include "Compositor.h"
+
+#define GIF_BAND_LINES 16
+#define GIF_MAX_WIDTH 320
+#define GIF_NO_TRANSPARENCY -1
+
+typedef struct {
+  uint32_t frames;       ///< Frames ended
+  uint32_t lines;        ///< Lines drawn
+  uint32_t skippedLines; ///< Lines without a visible pixel
+  uint32_t bands;        ///< Sink writes
+  uint32_t pixels;       ///< Pixels written to the sink
+  uint32_t busy;         ///< Frames whose changes were postponed because the sink was busy
+} gif_band_stats_t;
+
+class GifBandRenderer {
+public:
+  /**
+   * @param canvas width x height pixels in the byte order the sink expects
+   * @param x Screen position of the canvas
+   */
+  GifBandRenderer(uint16_t *canvas, int16_t width, int16_t height, int16_t x, int16_t y, DisplaySink &sink);
+
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  /// Fills the canvas and marks all of it for the next frame.
+  void clear(uint16_t color);
+
+  /**
+   * @brief Draws one decoded line at canvas row y, starting at column x.
+   * @param transparent Palette index that keeps the pixel below, or GIF_NO_TRANSPARENCY
+   */
+  void drawLine(int16_t y, int16_t x, int16_t w, const uint8_t *indices, const uint16_t *palette,
+                int16_t transparent);
+
+  /// Sends the changes still pending and releases the sink.
+  void endFrame();
+
+  const gif_band_stats_t &stats() const { return _stats; }
+
+private:
+  void markBand(int16_t band, int16_t top, int16_t bottom, int16_t left, int16_t right);
+  void flushBand();
+
+  uint16_t *_canvas;
+  int16_t _width;
+  int16_t _height;
+  int16_t _x;
+  int16_t _y;
+  DisplaySink &_sink;
+  bool _sinkOpen = false;
+
+  // Changed rectangle of the band being collected, in canvas coordinates
+  int16_t _band = -1;
+  int16_t _top;
+  int16_t _bottom;
+  int16_t _left;
+  int16_t _right;
+
+  DisplayRect _postponed = {0, 0, 0, 0}; ///< Changes of frames the sink was busy for
+
+  uint8_t _buffer = 0;
+  uint16_t _bands[2][GIF_MAX_WIDTH * GIF_BAND_LINES];
+  gif_band_stats_t _stats = {};
+};
+
+#endif // GIF_BAND_RENDERER_H
@@ -1,9 +1,14 @@
 #include "GifPlayer.h"
 #include "Display.h"
+#include "AssetPartition.h"
 #include "DisplayMutex.h"
+#include "GifBandRenderer.h"
 #include <AnimatedGIF.h>
 #include <SPIFFS.h>
 #include <FS.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <new>
 
 // Global GIF decoder and file handle
 static AnimatedGIF gif;
@@ -34,7 +39,7 @@ int32_t GIFReadFile(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen) {
   fs::File *f = static_cast<fs::File *>(pFile->fHandle);
   
   if ((pFile->iSize - pFile->iPos) < iLen) {
-    iBytesRead = pFile->iSize - pFile->iPos - 1;
+    iBytesRead = pFile->iSize - pFile->iPos;
   }
   
   if (iBytesRead <= 0) {
@@ -53,60 +58,96 @@ int32_t GIFSeekFile(GIFFILE *pFile, int32_t iPosition) {
   return pFile->iPos;
 }
 
-// ============ GIF Draw Callback ============
+// ============ Band Rendering ============
 
-void GIFDraw(GIFDRAW *pDraw) {
-  uint8_t *s;
-  uint16_t *usPalette;
-  uint16_t usLine[320];  // For 320 pixel width displays
-  int x, iWidth;
-
-  iWidth = pDraw->iWidth;
-  if (iWidth + pDraw->iX > 320) {  // Adjust based on your display width
-    iWidth = 320 - pDraw->iX;
+// Decoded lines land in a PSRAM canvas; changed bands go out with one SPI DMA transfer each
+class GifTftSink : public DisplaySink {
+public:
+  bool begin() override {
+    // Taken once per frame; a busy display postpones the frame's changes to the next one
+    if (!lockDisplay(50)) {
+      return false;
+    }
+    _swapBytes = tft.getSwapBytes();
+    tft.setSwapBytes(false); // BIG_ENDIAN_PIXELS already gives SPI byte order
+    tft.startWrite();
+    return true;
   }
-  
-  if (iWidth < 1 || pDraw->iY >= 240) {  // Adjust based on your display height
-    return;
+
+  void write(const DisplayRect &rect, const uint16_t *pixels) override {
+    // Waits for the previous band before starting this one
+    tft.pushImageDMA(rect.x, rect.y, rect.w, rect.h, (uint16_t *)pixels);
   }
 
-  usPalette = pDraw->pPalette;
-  s = pDraw->pPixels;
+  void end() override {
+    tft.dmaWait();
+    tft.endWrite();
+    tft.setSwapBytes(_swapBytes);
+    unlockDisplay();
+  }
+
+private:
+  bool _swapBytes = false;
+};
+
+static GifTftSink gifSink;
+static GifBandRenderer *gifRenderer = nullptr;
+static uint16_t *gifCanvas = nullptr;
+
+// Frame timing, written by the playback task
+static portMUX_TYPE gifStatsMutex = portMUX_INITIALIZER_UNLOCKED;
+static gif_player_stats_t gifStats = {};
+
+// ============ GIF Draw Callback ============
+
+void GIFDraw(GIFDRAW *pDraw) {
+  uint8_t *s = pDraw->pPixels;
+  int16_t transparent = pDraw->ucHasTransparency ? pDraw->ucTransparent : GIF_NO_TRANSPARENCY;
 
   // Handle disposal method
-  if (pDraw->ucDisposalMethod == 2) {
-    for (x = 0; x < iWidth; x++) {
-      if (s[x] == pDraw->ucTransparent) {
+  if (pDraw->ucDisposalMethod == 2 && transparent != GIF_NO_TRANSPARENCY) {
+    for (int x = 0; x < pDraw->iWidth; x++) {
+      if (s[x] == transparent) {
         s[x] = pDraw->ucBackground;
       }
     }
-    pDraw->ucHasTransparency = 0;
+    transparent = GIF_NO_TRANSPARENCY;
   }
 
-  // Convert 8-bit palette pixels to 16-bit RGB565
-  if (pDraw->ucHasTransparency) {
-    uint8_t c, ucTransparent = pDraw->ucTransparent;
-    for (x = 0; x < iWidth; x++) {
-      c = *s++;
-      if (c != ucTransparent) {
-        usLine[x] = usPalette[c];
-      }
-    }
-  } else {
-    for (x = 0; x < iWidth; x++) {
-      usLine[x] = usPalette[s[x]];
-    }
-  }
+  // The renderer clips to the canvas and keeps the previous pixel under transparent ones
+  gifRenderer->drawLine(pDraw->iY + pDraw->y, pDraw->iX, pDraw->iWidth, s, pDraw->pPalette, transparent);
+}
 
-  // Lock display mutex before writing
-  if (lockDisplay(50)) {  // 50ms timeout
-    tft.setAddrWindow(pDraw->iX, pDraw->iY + pDraw->y, iWidth, 1);
-    tft.pushColors(usLine, iWidth, false);
-    unlockDisplay();
+// ============ GIF Playback Task ============
+
+static bool gifCreateRenderer(int16_t width, int16_t height) {
+  width = min((int)width, min((int)tft.width(), GIF_MAX_WIDTH));
+  height = min((int)height, (int)tft.height());
+  gifCanvas = (uint16_t *)heap_caps_malloc((size_t)width * height * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+  if (gifCanvas == nullptr) {
+    return false;
+  }
+  // The band buffers inside the renderer are read by SPI DMA, so it lives in internal RAM
+  void *memory = heap_caps_malloc(sizeof(GifBandRenderer), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  if (memory == nullptr) {
+    heap_caps_free(gifCanvas);
+    gifCanvas = nullptr;
+    return false;
   }
+  gifRenderer = new (memory) GifBandRenderer(gifCanvas, width, height, 0, 0, gifSink);
+  gifRenderer->clear(TFT_BLACK);
+  return true;
 }
 
-// ============ GIF Playback Task ============
+static void gifDestroyRenderer() {
+  if (gifRenderer != nullptr) {
+    gifRenderer->~GifBandRenderer();
+    heap_caps_free(gifRenderer);
+    gifRenderer = nullptr;
+  }
+  heap_caps_free(gifCanvas);
+  gifCanvas = nullptr;
+}
 
 void gifPlaybackTask(void *pvParameters) {
   const char* gifPath = (const char*)pvParameters;
@@ -114,20 +155,74 @@ void gifPlaybackTask(void *pvParameters) {
   // Initialize AnimatedGIF
   gif.begin(BIG_ENDIAN_PIXELS);
   
-  // Open GIF with all required callbacks
-  if (gif.open(gifPath, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile, GIFDraw)) {
-    Serial.printf("GIF opened successfully, canvas: %d x %d\n", gif.getCanvasWidth(), gif.getCanvasHeight());
-    
-    // Play frames while running
+  // Read straight from the mapped asset partition if the GIF is there, otherwise from SPIFFS
+  asset_view_t asset;
+  const bool mapped = assetOpen(gifPath, asset);
+  const bool opened = mapped ? gif.open((uint8_t *)asset.data, (int)asset.size, GIFDraw)
+                             : gif.open(gifPath, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile, GIFDraw);
+  if (opened) {
+    Serial.printf("GIF opened successfully from %s, canvas: %d x %d\n", mapped ? "flash map" : "SPIFFS",
+                  gif.getCanvasWidth(), gif.getCanvasHeight());
+    portENTER_CRITICAL(&gifStatsMutex);
+    gifStats = {};
+    gifStats.mapped = mapped;
+    portEXIT_CRITICAL(&gifStatsMutex);
+
+    if (!gifCreateRenderer(gif.getCanvasWidth(), gif.getCanvasHeight())) {
+      Serial.println("ERROR: Could not allocate the GIF canvas");
+      gifRunning = false;
+    }
+
+    // Play frames while running; the frame delay is waited here so it does not include the flush
+    TickType_t frameStart = xTaskGetTickCount();
+    TickType_t lastReport = frameStart;
+    gif_player_stats_t reported = {};
     while (gifRunning) {
-      if (!gif.playFrame(true, nullptr)) {
+      int delayMs = 0;
+      const int64_t startUs = esp_timer_get_time();
+      if (!gif.playFrame(false, &delayMs)) {
         // Frame play finished, restart
         gif.reset();
       }
-      yield();
+      gifRenderer->endFrame();
+      const uint32_t frameUs = (uint32_t)(esp_timer_get_time() - startUs);
+
+      const TickType_t now = xTaskGetTickCount();
+      portENTER_CRITICAL(&gifStatsMutex);
+      gifStats.render = gifRenderer->stats();
+      gifStats.lastFrameUs = frameUs;
+      gifStats.maxFrameUs = max(gifStats.maxFrameUs, frameUs);
+      gifStats.frameUs += frameUs;
+      const gif_player_stats_t stats = gifStats;
+      portEXIT_CRITICAL(&gifStatsMutex);
+
+      if (now - lastReport >= pdMS_TO_TICKS(10000)) {
+        const uint32_t frames = stats.render.frames - reported.render.frames;
+        const float seconds = (now - lastReport) * portTICK_PERIOD_MS / 1000.0f;
+        Serial.printf("[System] GIF (%s): %.1f fps, %u us CPU/frame (max %u), %.1f bands/frame, %u lines skipped, "
+                      "%u frames postponed\n",
+                      mapped ? "flash map" : "SPIFFS", frames / seconds,
+                      frames > 0 ? (unsigned)((stats.frameUs - reported.frameUs) / frames) : 0,
+                      (unsigned)stats.maxFrameUs,
+                      frames > 0 ? (float)(stats.render.bands - reported.render.bands) / frames : 0.0f,
+                      (unsigned)(stats.render.skippedLines - reported.render.skippedLines),
+                      (unsigned)(stats.render.busy - reported.render.busy));
+        reported = stats;
+        lastReport = now;
+      }
+
+      // Keep the GIF's timing; a frame that took longer than its delay starts the next one at once
+      const TickType_t wait = pdMS_TO_TICKS(delayMs);
+      if (now - frameStart < wait) {
+        vTaskDelayUntil(&frameStart, wait);
+      } else {
+        frameStart = now;
+        yield();
+      }
     }
     
     gif.close();
+    gifDestroyRenderer();
   } else {
     Serial.printf("ERROR: Could not open GIF: %s\n", gifPath);
   }
@@ -144,7 +239,8 @@ void gifPlayerInit(const char* gifPath) {
   }
 
   // Check if file exists
-  if (!SPIFFS.exists(gifPath)) {
+  asset_view_t asset;
+  if (!assetOpen(gifPath, asset) && !SPIFFS.exists(gifPath)) {
     Serial.printf("ERROR: GIF file not found: %s\n", gifPath);
     return;
   }
@@ -180,3 +276,10 @@ void gifPlayerStop() {
 bool gifPlayerIsRunning() {
   return gifRunning;
 }
+
+gif_player_stats_t gifPlayerGetStats() {
+  portENTER_CRITICAL(&gifStatsMutex);
+  const gif_player_stats_t stats = gifStats;
+  portEXIT_CRITICAL(&gifStatsMutex);
+  return stats;
+}
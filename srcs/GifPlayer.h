@@ -2,6 +2,16 @@
 #define GIF_PLAYER_H
 
 #include <Arduino.h>
+#include "GifBandRenderer.h"
+
+// Playback counters; CPU time covers decoding a frame and flushing its bands
+typedef struct {
+  gif_band_stats_t render; ///< Frames, bands and pixels sent, transparent lines skipped
+  uint64_t frameUs;        ///< Sum of the frame times
+  uint32_t lastFrameUs;
+  uint32_t maxFrameUs;
+  bool mapped;             ///< Read from the asset partition rather than SPIFFS
+} gif_player_stats_t;
 
 /**
  * Initialize GIF player on core 2
@@ -19,4 +29,9 @@ void gifPlayerStop();
  */
 bool gifPlayerIsRunning();
 
+/**
+ * Frame timing since playback started (the playback task also logs it every 10 s)
+ */
+gif_player_stats_t gifPlayerGetStats();
+
 #endif
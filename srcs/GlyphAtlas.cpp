@@ -0,0 +1,57 @@
+#include "GlyphAtlas.h"
+#include <string.h>
+
+bool GlyphAtlas::build(uint8_t scale, glyph_raster_cb_t raster) {
+  if (_bits != nullptr || scale == 0) {
+    return ready();
+  }
+  _scale = scale;
+  _rowBytes = (uint16_t)((width() + 7) / 8);
+  _glyphBytes = (uint16_t)(_rowBytes * height());
+  _bits = (uint8_t *)_alloc((size_t)GLYPH_COUNT * _glyphBytes);
+  if (_bits == nullptr) {
+    return false;
+  }
+  memset(_bits, 0, (size_t)GLYPH_COUNT * _glyphBytes);
+
+  for (int c = GLYPH_FIRST; c <= GLYPH_LAST; c++) {
+    uint8_t cell[GLYPH_CELL_H] = {};
+    raster((char)c, cell);
+    uint8_t *glyph = _bits + (c - GLYPH_FIRST) * _glyphBytes;
+    for (int16_t y = 0; y < height(); y++) {
+      const uint8_t source = cell[y / _scale];
+      uint8_t *row = glyph + y * _rowBytes;
+      for (int16_t x = 0; x < width(); x++) {
+        if (source & (0x80 >> (x / _scale))) {
+          row[x / 8] |= 0x80 >> (x % 8);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool GlyphAtlas::draw(char c, uint16_t *out, int16_t stride, uint16_t fg, uint16_t bg) const {
+  if (!ready() || !has(c)) {
+    return false;
+  }
+  const uint8_t *glyph = _bits + (c - GLYPH_FIRST) * _glyphBytes;
+  const int16_t w = width();
+  for (int16_t y = 0; y < height(); y++) {
+    uint16_t *dst = out + y * stride;
+    if (y % _scale != 0) {
+      // Each font row is scale pixel rows high; only the first one is expanded
+      memcpy(dst, dst - stride, w * sizeof(uint16_t));
+      continue;
+    }
+    const uint8_t *row = glyph + y * _rowBytes;
+    for (int16_t x = 0; x < w; x += 8) {
+      const uint8_t bits = row[x / 8];
+      const int16_t n = w - x < 8 ? w - x : 8;
+      for (int16_t i = 0; i < n; i++) {
+        dst[x + i] = (bits & (0x80 >> i)) ? fg : bg;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file GlyphAtlas.h
+ * @brief Printable ASCII pre-rasterised at one text size, drawn by colour expansion.
+ *
+ * The scaled built-in font draws every font pixel as a size x size
+ * rectangle, so a 60x80 key glyph costs dozens of separate fills. The atlas
+ * rasterises the 6x8 font cells once, through a callback supplied by the
+ * display code, scales them and keeps them as 1 bit per pixel (57 KB at
+ * size 10). draw() expands one glyph into a sprite or band in a single pass
+ * over its rectangle. The character from HID_TO_ASCII is the index.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST '~'
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+#define GLYPH_CELL_W 6 // Built-in font cell, one column of spacing included
+#define GLYPH_CELL_H 8
+
+typedef void *(*glyph_alloc_cb_t)(size_t bytes);
+
+/// Fills rows[0..GLYPH_CELL_H-1] for c; bit 0x80 >> x is the pixel at column x.
+typedef void (*glyph_raster_cb_t)(char c, uint8_t rows[GLYPH_CELL_H]);
+
+class GlyphAtlas {
+public:
+  explicit GlyphAtlas(glyph_alloc_cb_t alloc) : _alloc(alloc) {}
+
+  /// Rasterises every printable character at the given scale; false if out of memory.
+  bool build(uint8_t scale, glyph_raster_cb_t raster);
+
+  bool ready() const { return _bits != nullptr; }
+  int16_t width() const { return GLYPH_CELL_W * _scale; }
+  int16_t height() const { return GLYPH_CELL_H * _scale; }
+  size_t bytes() const { return ready() ? (size_t)GLYPH_COUNT * _glyphBytes : 0; }
+
+  static bool has(char c) { return c >= GLYPH_FIRST && c <= GLYPH_LAST; }
+
+  /**
+   * @brief Writes glyph c as fg on bg into a width() x height() rectangle.
+   * @param stride Pixels per row of out
+   * @return false if c is not printable or the atlas is not built; out is untouched then
+   */
+  bool draw(char c, uint16_t *out, int16_t stride, uint16_t fg, uint16_t bg) const;
+
+private:
+  glyph_alloc_cb_t _alloc;
+  uint8_t *_bits = nullptr;
+  uint8_t _scale = 1;
+  uint16_t _rowBytes = 0;
+  uint16_t _glyphBytes = 0;
+};
+
+#endif // GLYPH_ATLAS_H
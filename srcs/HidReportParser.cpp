@@ -0,0 +1,569 @@
+#include "HidReportParser.h"
+#include <string.h>
+
+// HID item types and tags (HID 1.11, section 6.2.2)
+#define HID_ITEM_TYPE_MAIN 0
+#define HID_ITEM_TYPE_GLOBAL 1
+#define HID_ITEM_TYPE_LOCAL 2
+
+#define HID_MAIN_INPUT 0x8
+#define HID_MAIN_COLLECTION 0xA
+#define HID_MAIN_END_COLLECTION 0xC
+
+#define HID_GLOBAL_USAGE_PAGE 0x0
+#define HID_GLOBAL_LOGICAL_MIN 0x1
+#define HID_GLOBAL_LOGICAL_MAX 0x2
+#define HID_GLOBAL_REPORT_SIZE 0x7
+#define HID_GLOBAL_REPORT_ID 0x8
+#define HID_GLOBAL_REPORT_COUNT 0x9
+#define HID_GLOBAL_PUSH 0xA
+#define HID_GLOBAL_POP 0xB
+
+#define HID_LOCAL_USAGE 0x0
+#define HID_LOCAL_USAGE_MIN 0x1
+#define HID_LOCAL_USAGE_MAX 0x2
+
+// Input item flags
+#define HID_INPUT_CONSTANT 0x01
+#define HID_INPUT_VARIABLE 0x02
+
+// Usage pages and application usages we route on
+#define PAGE_GENERIC_DESKTOP 0x01
+#define PAGE_KEYBOARD 0x07
+#define PAGE_BUTTON 0x09
+#define PAGE_CONSUMER 0x0C
+
+#define APP_POINTER 0x00010001
+#define APP_MOUSE 0x00010002
+#define APP_KEYBOARD 0x00010006
+#define APP_KEYPAD 0x00010007
+#define APP_CONSUMER 0x000C0001
+
+#define MAX_LOCAL_USAGES 16
+#define MAX_GLOBAL_STACK 4
+
+// Boot protocol descriptors (HID 1.11, Appendix B). The key array accepts the
+// full 0x00-0xFF range because real keyboards report beyond the spec's 0x65.
+static const uint8_t BOOT_KEYBOARD_DESCRIPTOR[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,             // Generic Desktop / Keyboard / Application
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7,             //   Keyboard page, 0xE0-0xE7
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, //   8 x 1 bit
+    0x81, 0x02,                                     //   Input (Data,Var,Abs) ; modifiers
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x01,             //   Input (Const) ; reserved byte
+    0x95, 0x06, 0x75, 0x08,                         //   6 x 8 bit
+    0x15, 0x00, 0x26, 0xFF, 0x00,                   //   Logical 0-255
+    0x05, 0x07, 0x19, 0x00, 0x29, 0xFF,             //   Keyboard page, 0x00-0xFF
+    0x81, 0x00,                                     //   Input (Data,Array,Abs) ; keys
+    0xC0};
+
+static const uint8_t BOOT_MOUSE_DESCRIPTOR[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01,             // Generic Desktop / Mouse / Application
+    0x09, 0x01, 0xA1, 0x00,                         //   Pointer / Physical
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03,             //     Buttons 1-3
+    0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, //     3 x 1 bit
+    0x81, 0x02,                                     //     Input (Data,Var,Abs)
+    0x95, 0x01, 0x75, 0x05, 0x81, 0x01,             //     Input (Const) ; padding
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38, //     X, Y, Wheel (wheel is optional)
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03, //     3 x 8 bit, -127..127
+    0x81, 0x06,                                     //     Input (Data,Var,Rel)
+    0xC0, 0xC0};
+
+namespace {
+
+struct GlobalState {
+  uint16_t usagePage;
+  int32_t logicalMin;
+  int32_t logicalMax;
+  uint32_t logicalMaxUnsigned;
+  uint32_t reportSize;
+  uint32_t reportCount;
+  uint8_t reportId;
+};
+
+struct LocalState {
+  uint32_t usages[MAX_LOCAL_USAGES];
+  uint8_t usageCount;
+  uint32_t usageMin;
+  uint32_t usageMax;
+  bool hasUsageMin;
+  bool hasUsageMax;
+};
+
+struct ParseContext {
+  HidInterfacePlan &plan;
+  uint8_t fieldReport[HID_PLAN_MAX_FIELDS]; // Report index of every field
+  uint16_t inputBits[HID_PLAN_MAX_REPORTS]; // Input bit cursor per report
+  uint32_t application;
+  GlobalState global;
+  LocalState local;
+
+  explicit ParseContext(HidInterfacePlan &p) : plan(p) {}
+};
+
+inline uint32_t itemUnsigned(const uint8_t *data, uint8_t size) {
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < size; i++) {
+    value |= (uint32_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+inline int32_t itemSigned(const uint8_t *data, uint8_t size) {
+  uint32_t value = itemUnsigned(data, size);
+  if (size > 0 && size < 4 && (value & (1u << (8 * size - 1)))) {
+    value |= ~0u << (8 * size);
+  }
+  return (int32_t)value;
+}
+
+/// Resolves a local usage to its extended 32-bit form (page << 16 | id).
+inline uint32_t extendUsage(uint32_t usage, uint16_t usagePage) {
+  return usage > 0xFFFF ? usage : ((uint32_t)usagePage << 16) | usage;
+}
+
+/// Usage of the i-th element of the current main item.
+uint32_t usageAt(const ParseContext &ctx, uint32_t index) {
+  const LocalState &local = ctx.local;
+  if (local.usageCount > 0) {
+    uint32_t u = local.usages[index < local.usageCount ? index : local.usageCount - 1];
+    return extendUsage(u, ctx.global.usagePage);
+  }
+  uint32_t base = extendUsage(local.usageMin, ctx.global.usagePage);
+  uint32_t last = extendUsage(local.hasUsageMax ? local.usageMax : local.usageMin, ctx.global.usagePage);
+  uint32_t usage = base + index;
+  return usage > last ? last : usage;
+}
+
+int findOrAddReport(ParseContext &ctx, uint8_t reportId) {
+  HidInterfacePlan &plan = ctx.plan;
+  for (uint8_t i = 0; i < plan.reportCount; i++) {
+    if (plan.reports[i].reportId == reportId) {
+      return i;
+    }
+  }
+  if (plan.reportCount >= HID_PLAN_MAX_REPORTS) {
+    return -1;
+  }
+  uint8_t index = plan.reportCount++;
+  plan.reports[index] = {reportId, 0, 0, 0};
+  ctx.inputBits[index] = reportId != 0 ? 8 : 0; // Report ID byte precedes the data
+  return index;
+}
+
+void addField(ParseContext &ctx, int reportIndex, HidFieldOp op, uint16_t bitOffset,
+              uint8_t bitSize, uint16_t count, uint16_t usageMin) {
+  HidInterfacePlan &plan = ctx.plan;
+  if (plan.fieldCount >= HID_PLAN_MAX_FIELDS) {
+    return;
+  }
+
+  HidFieldPlan &field = plan.fields[plan.fieldCount];
+  field.bitOffset = bitOffset;
+  field.bitSize = bitSize;
+  field.count = count;
+  field.op = op;
+  field.usageMin = usageMin;
+  field.logicalMin = ctx.global.logicalMin;
+  field.logicalMax = ctx.global.logicalMax;
+  // A one-byte LOGICAL_MAXIMUM of 0xFF is -1 when read signed; descriptors that
+  // mean 255 have a non-negative minimum, so fall back to the unsigned value.
+  if (field.logicalMax < field.logicalMin) {
+    field.logicalMax = (int32_t)ctx.global.logicalMaxUnsigned;
+  }
+  field.isSigned = field.logicalMin < 0;
+  ctx.fieldReport[plan.fieldCount] = (uint8_t)reportIndex;
+  plan.fieldCount++;
+
+  switch (op) {
+  case HID_OP_MODIFIERS:
+  case HID_OP_KEY_BITMAP:
+  case HID_OP_KEY_ARRAY:
+    plan.reports[reportIndex].kinds |= HID_REPORT_KIND_KEYBOARD;
+    break;
+  case HID_OP_BUTTONS:
+  case HID_OP_AXIS_X:
+  case HID_OP_AXIS_Y:
+  case HID_OP_WHEEL:
+  case HID_OP_PAN:
+    plan.reports[reportIndex].kinds |= HID_REPORT_KIND_MOUSE;
+    break;
+  default:
+    plan.reports[reportIndex].kinds |= HID_REPORT_KIND_CONSUMER;
+    break;
+  }
+}
+
+/// Turns one Input main item into plan fields.
+void handleInput(ParseContext &ctx, uint32_t flags) {
+  const GlobalState &g = ctx.global;
+  int reportIndex = findOrAddReport(ctx, g.reportId);
+  if (reportIndex < 0) {
+    return;
+  }
+
+  uint16_t bitOffset = ctx.inputBits[reportIndex];
+  uint32_t totalBits = g.reportSize * g.reportCount;
+  ctx.inputBits[reportIndex] = (uint16_t)(bitOffset + totalBits);
+
+  if ((flags & HID_INPUT_CONSTANT) || g.reportSize == 0 || g.reportSize > 32 ||
+      g.reportCount == 0 || g.reportCount > 256) {
+    return; // Padding or something we cannot extract
+  }
+
+  const uint8_t size = (uint8_t)g.reportSize;
+  const uint16_t count = (uint16_t)g.reportCount;
+  const uint32_t firstUsage = usageAt(ctx, 0);
+  const uint16_t page = firstUsage >> 16;
+  const uint16_t id = firstUsage & 0xFFFF;
+  const bool keyboardApp = ctx.application == APP_KEYBOARD || ctx.application == APP_KEYPAD;
+  const bool mouseApp = ctx.application == APP_MOUSE || ctx.application == APP_POINTER;
+  const bool consumerApp = ctx.application == APP_CONSUMER;
+
+  if (!(flags & HID_INPUT_VARIABLE)) {
+    // Array: element values select usages starting at the usage minimum
+    if (keyboardApp && page == PAGE_KEYBOARD) {
+      addField(ctx, reportIndex, HID_OP_KEY_ARRAY, bitOffset, size, count, id);
+    } else if (consumerApp && page == PAGE_CONSUMER) {
+      addField(ctx, reportIndex, HID_OP_CONSUMER_ARRAY, bitOffset, size, count, id);
+    }
+    return;
+  }
+
+  // Variable bit blocks are kept as a single field
+  if (keyboardApp && page == PAGE_KEYBOARD && size == 1) {
+    HidFieldOp op = (id >= 0xE0 && id + count - 1 <= 0xE7) ? HID_OP_MODIFIERS : HID_OP_KEY_BITMAP;
+    addField(ctx, reportIndex, op, bitOffset, size, count, id);
+    return;
+  }
+  if (mouseApp && page == PAGE_BUTTON && size == 1) {
+    addField(ctx, reportIndex, HID_OP_BUTTONS, bitOffset, size, count, id);
+    return;
+  }
+
+  // Everything else is resolved element by element
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t usage = usageAt(ctx, i);
+    uint16_t elementPage = usage >> 16;
+    uint16_t elementId = usage & 0xFFFF;
+    uint16_t elementOffset = (uint16_t)(bitOffset + i * size);
+
+    if (mouseApp && elementPage == PAGE_GENERIC_DESKTOP) {
+      if (elementId == 0x30) {
+        addField(ctx, reportIndex, HID_OP_AXIS_X, elementOffset, size, 1, elementId);
+      } else if (elementId == 0x31) {
+        addField(ctx, reportIndex, HID_OP_AXIS_Y, elementOffset, size, 1, elementId);
+      } else if (elementId == 0x38) {
+        addField(ctx, reportIndex, HID_OP_WHEEL, elementOffset, size, 1, elementId);
+      }
+    } else if (mouseApp && elementPage == PAGE_CONSUMER && elementId == 0x238) {
+      addField(ctx, reportIndex, HID_OP_PAN, elementOffset, size, 1, elementId);
+    } else if (consumerApp && elementPage == PAGE_CONSUMER) {
+      addField(ctx, reportIndex, HID_OP_CONSUMER_BIT, elementOffset, size, 1, elementId);
+    }
+  }
+}
+
+/// Groups fields by report so every report owns a contiguous range,
+/// and drops reports that carry nothing we decode.
+void finalizePlan(ParseContext &ctx) {
+  HidInterfacePlan &plan = ctx.plan;
+  HidFieldPlan sorted[HID_PLAN_MAX_FIELDS];
+  uint8_t sortedCount = 0;
+  uint8_t reportCount = 0;
+
+  for (uint8_t r = 0; r < plan.reportCount; r++) {
+    HidReportPlan report = plan.reports[r];
+    report.firstField = sortedCount;
+    report.fieldCount = 0;
+    for (uint8_t f = 0; f < plan.fieldCount; f++) {
+      if (ctx.fieldReport[f] == r) {
+        sorted[sortedCount++] = plan.fields[f];
+        report.fieldCount++;
+      }
+    }
+    if (report.fieldCount > 0) {
+      plan.reports[reportCount++] = report;
+    }
+  }
+
+  memcpy(plan.fields, sorted, sortedCount * sizeof(HidFieldPlan));
+  plan.fieldCount = sortedCount;
+  plan.reportCount = reportCount;
+}
+
+/// Reads an element of up to 32 bits, little-endian, at an arbitrary bit offset.
+inline uint32_t extractBits(const uint8_t *data, uint32_t bitOffset, uint8_t bitSize) {
+  const uint8_t *p = data + (bitOffset >> 3);
+  const uint32_t shift = bitOffset & 7;
+  const uint32_t bytes = (shift + bitSize + 7) >> 3;
+  uint64_t raw = 0;
+  for (uint32_t i = 0; i < bytes; i++) {
+    raw |= (uint64_t)p[i] << (8 * i);
+  }
+  raw >>= shift;
+  return bitSize >= 32 ? (uint32_t)raw : (uint32_t)raw & ((1u << bitSize) - 1);
+}
+
+inline int32_t signExtend(uint32_t value, uint8_t bitSize) {
+  if (bitSize < 32 && (value & (1u << (bitSize - 1)))) {
+    value |= ~0u << bitSize;
+  }
+  return (int32_t)value;
+}
+
+inline int16_t clampAxis(int32_t value) {
+  return value > 32767 ? 32767 : (value < -32768 ? -32768 : (int16_t)value);
+}
+
+inline void addKey(HidDecodedReport &out, uint32_t usage) {
+  if (usage >= 0xE0 && usage <= 0xE7) {
+    out.modifiers |= 1u << (usage - 0xE0);
+  } else if (usage > 0x03 && usage <= 0xFF) {
+    out.keys.set((uint8_t)usage); // 0x01-0x03 are rollover/error codes
+  }
+}
+
+} // namespace
+
+bool hidParseReportDescriptor(const uint8_t *desc, size_t length, HidInterfacePlan &plan) {
+  memset(&plan, 0, sizeof(plan));
+  ParseContext ctx(plan);
+  memset(ctx.inputBits, 0, sizeof(ctx.inputBits));
+  memset(&ctx.global, 0, sizeof(ctx.global));
+  memset(&ctx.local, 0, sizeof(ctx.local));
+  ctx.application = 0;
+
+  GlobalState globalStack[MAX_GLOBAL_STACK];
+  uint8_t globalDepth = 0;
+  uint8_t collectionDepth = 0;
+
+  size_t pos = 0;
+  while (pos < length) {
+    const uint8_t prefix = desc[pos++];
+
+    if (prefix == 0xFE) {
+      // Long item: skip payload
+      if (pos + 1 >= length) {
+        break;
+      }
+      pos += 2 + desc[pos];
+      continue;
+    }
+
+    const uint8_t size = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+    const uint8_t type = (prefix >> 2) & 0x03;
+    const uint8_t tag = prefix >> 4;
+    if (pos + size > length) {
+      break;
+    }
+    const uint8_t *data = &desc[pos];
+    pos += size;
+
+    const uint32_t value = itemUnsigned(data, size);
+
+    if (type == HID_ITEM_TYPE_MAIN) {
+      if (tag == HID_MAIN_INPUT) {
+        handleInput(ctx, value);
+      } else if (tag == HID_MAIN_COLLECTION) {
+        if (value == 0x01) {
+          ctx.application = usageAt(ctx, 0); // Application collection
+        }
+        collectionDepth++;
+      } else if (tag == HID_MAIN_END_COLLECTION && collectionDepth > 0) {
+        if (--collectionDepth == 0) {
+          ctx.application = 0;
+        }
+      }
+      memset(&ctx.local, 0, sizeof(ctx.local));
+    } else if (type == HID_ITEM_TYPE_GLOBAL) {
+      switch (tag) {
+      case HID_GLOBAL_USAGE_PAGE:
+        ctx.global.usagePage = (uint16_t)value;
+        break;
+      case HID_GLOBAL_LOGICAL_MIN:
+        ctx.global.logicalMin = itemSigned(data, size);
+        break;
+      case HID_GLOBAL_LOGICAL_MAX:
+        ctx.global.logicalMax = itemSigned(data, size);
+        ctx.global.logicalMaxUnsigned = value;
+        break;
+      case HID_GLOBAL_REPORT_SIZE:
+        ctx.global.reportSize = value;
+        break;
+      case HID_GLOBAL_REPORT_ID:
+        ctx.global.reportId = (uint8_t)value;
+        plan.usesReportIds = true;
+        break;
+      case HID_GLOBAL_REPORT_COUNT:
+        ctx.global.reportCount = value;
+        break;
+      case HID_GLOBAL_PUSH:
+        if (globalDepth < MAX_GLOBAL_STACK) {
+          globalStack[globalDepth++] = ctx.global;
+        }
+        break;
+      case HID_GLOBAL_POP:
+        if (globalDepth > 0) {
+          ctx.global = globalStack[--globalDepth];
+        }
+        break;
+      default:
+        break;
+      }
+    } else if (type == HID_ITEM_TYPE_LOCAL) {
+      switch (tag) {
+      case HID_LOCAL_USAGE:
+        if (ctx.local.usageCount < MAX_LOCAL_USAGES) {
+          ctx.local.usages[ctx.local.usageCount++] = value;
+        }
+        break;
+      case HID_LOCAL_USAGE_MIN:
+        ctx.local.usageMin = value;
+        ctx.local.hasUsageMin = true;
+        break;
+      case HID_LOCAL_USAGE_MAX:
+        ctx.local.usageMax = value;
+        ctx.local.hasUsageMax = true;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  finalizePlan(ctx);
+  return plan.reportCount > 0;
+}
+
+void hidBuildBootKeyboardPlan(HidInterfacePlan &plan) {
+  hidParseReportDescriptor(BOOT_KEYBOARD_DESCRIPTOR, sizeof(BOOT_KEYBOARD_DESCRIPTOR), plan);
+}
+
+void hidBuildBootMousePlan(HidInterfacePlan &plan) {
+  hidParseReportDescriptor(BOOT_MOUSE_DESCRIPTOR, sizeof(BOOT_MOUSE_DESCRIPTOR), plan);
+}
+
+bool hidDecodeReport(const HidInterfacePlan &plan, const uint8_t *data, size_t length,
+                     HidDecodedReport &out) {
+  uint8_t reportId = 0;
+  if (plan.usesReportIds) {
+    if (length == 0) {
+      return false;
+    }
+    reportId = data[0];
+  }
+
+  const HidReportPlan *report = nullptr;
+  for (uint8_t i = 0; i < plan.reportCount; i++) {
+    if (plan.reports[i].reportId == reportId) {
+      report = &plan.reports[i];
+      break;
+    }
+  }
+  if (report == nullptr) {
+    return false;
+  }
+
+  out.kinds = report->kinds;
+  out.reportId = reportId;
+  out.modifiers = 0;
+  out.keys.clear();
+  out.buttons = 0;
+  out.x = out.y = out.wheel = out.pan = 0;
+  out.consumerCount = 0;
+
+  const uint32_t lengthBits = (uint32_t)length * 8;
+  const HidFieldPlan *field = &plan.fields[report->firstField];
+  const HidFieldPlan *end = field + report->fieldCount;
+
+  for (; field != end; field++) {
+    if (field->bitOffset + (uint32_t)field->bitSize * field->count > lengthBits) {
+      continue; // Short report: optional trailing field not present
+    }
+
+    switch (field->op) {
+    case HID_OP_MODIFIERS:
+      out.modifiers |= (uint8_t)(extractBits(data, field->bitOffset, field->count)
+                                 << (field->usageMin - 0xE0));
+      break;
+
+    case HID_OP_KEY_BITMAP: {
+      // Walk whole bytes and skip empty ones; NKRO bitmaps are mostly zero
+      for (uint16_t i = 0; i < field->count; i += 8) {
+        uint8_t bits = field->count - i < 8 ? field->count - i : 8;
+        uint32_t byte = extractBits(data, field->bitOffset + i, bits);
+        while (byte) {
+          uint8_t bit = __builtin_ctz(byte);
+          addKey(out, field->usageMin + i + bit);
+          byte &= byte - 1;
+        }
+      }
+      break;
+    }
+
+    case HID_OP_KEY_ARRAY:
+      for (uint16_t i = 0; i < field->count; i++) {
+        int32_t v = (int32_t)extractBits(data, field->bitOffset + i * field->bitSize, field->bitSize);
+        if (v >= field->logicalMin && v <= field->logicalMax) {
+          addKey(out, field->usageMin + (uint32_t)(v - field->logicalMin));
+        }
+      }
+      break;
+
+    case HID_OP_BUTTONS: {
+      // Button 1 is bit 0; a block starting at usage 0 ("no button") carries
+      // it one bit up, and blocks starting past button 8 have nothing to report
+      uint32_t bits = extractBits(data, field->bitOffset, field->count > 9 ? 9 : field->count);
+      if (field->usageMin == 0) {
+        out.buttons |= (uint8_t)(bits >> 1);
+      } else if (field->usageMin <= 8) {
+        out.buttons |= (uint8_t)(bits << (field->usageMin - 1));
+      }
+      break;
+    }
+
+    case HID_OP_AXIS_X:
+    case HID_OP_AXIS_Y:
+    case HID_OP_WHEEL:
+    case HID_OP_PAN: {
+      uint32_t raw = extractBits(data, field->bitOffset, field->bitSize);
+      int16_t v = clampAxis(field->isSigned ? signExtend(raw, field->bitSize) : (int32_t)raw);
+      if (field->op == HID_OP_AXIS_X) {
+        out.x = v;
+      } else if (field->op == HID_OP_AXIS_Y) {
+        out.y = v;
+      } else if (field->op == HID_OP_WHEEL) {
+        out.wheel = v;
+      } else {
+        out.pan = v;
+      }
+      break;
+    }
+
+    case HID_OP_CONSUMER_ARRAY:
+      for (uint16_t i = 0; i < field->count; i++) {
+        int32_t v = (int32_t)extractBits(data, field->bitOffset + i * field->bitSize, field->bitSize);
+        if (v < field->logicalMin || v > field->logicalMax) {
+          continue;
+        }
+        uint16_t usage = (uint16_t)(field->usageMin + (v - field->logicalMin));
+        if (usage != 0 && out.consumerCount < HID_DECODED_MAX_CONSUMER) {
+          out.consumer[out.consumerCount++] = usage;
+        }
+      }
+      break;
+
+    case HID_OP_CONSUMER_BIT:
+      if (extractBits(data, field->bitOffset, field->bitSize) != 0 &&
+          out.consumerCount < HID_DECODED_MAX_CONSUMER) {
+        out.consumer[out.consumerCount++] = field->usageMin;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file HidReportParser.h
+ * @brief HID report descriptor parser producing flat field-extraction plans.
+ *
+ * The descriptor of each USB HID interface is parsed once when the interface
+ * connects. The result is a compact plan (report ID -> bit offset/size/usage
+ * table) that the input path walks to decode reports without re-parsing the
+ * descriptor or looking at the interface protocol.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef HID_REPORT_PARSER_H
+#define HID_REPORT_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "KeyState.h"
+
+#define HID_PLAN_MAX_REPORTS 8
+#define HID_PLAN_MAX_FIELDS 40
+#define HID_DECODED_MAX_CONSUMER 4
+
+/** @brief Report kinds, used as a bit mask (a report may carry several). */
+enum HidReportKind : uint8_t {
+  HID_REPORT_KIND_KEYBOARD = 0x01,
+  HID_REPORT_KIND_MOUSE = 0x02,
+  HID_REPORT_KIND_CONSUMER = 0x04,
+};
+
+/** @brief What the decoder does with a field. Resolved at parse time. */
+enum HidFieldOp : uint8_t {
+  HID_OP_MODIFIERS,      ///< Keyboard page, variable bits 0xE0..0xE7
+  HID_OP_KEY_BITMAP,     ///< Keyboard page, variable bits (NKRO)
+  HID_OP_KEY_ARRAY,      ///< Keyboard page, array of key codes (6KRO)
+  HID_OP_BUTTONS,        ///< Button page, variable bits
+  HID_OP_AXIS_X,         ///< Generic Desktop X (relative)
+  HID_OP_AXIS_Y,         ///< Generic Desktop Y (relative)
+  HID_OP_WHEEL,          ///< Generic Desktop Wheel
+  HID_OP_PAN,            ///< Consumer AC Pan (horizontal wheel)
+  HID_OP_CONSUMER_ARRAY, ///< Consumer page, array of usages
+  HID_OP_CONSUMER_BIT,   ///< Consumer page, single variable bit
+};
+
+/** @brief One field of an input report. */
+struct HidFieldPlan {
+  uint16_t bitOffset; ///< Offset from the start of the report (including report ID byte)
+  uint16_t count;     ///< Number of elements (1..256)
+  uint8_t bitSize;    ///< Size of one element in bits (1..32)
+  uint8_t op;         ///< HidFieldOp
+  uint8_t isSigned;   ///< Sign-extend values (logical minimum < 0)
+  uint16_t usageMin;  ///< Usage of the first element / array base usage
+  int32_t logicalMin;
+  int32_t logicalMax;
+};
+
+/** @brief One input report: a contiguous range of fields. */
+struct HidReportPlan {
+  uint8_t reportId;   ///< 0 when the interface does not use report IDs
+  uint8_t kinds;      ///< HidReportKind mask
+  uint8_t firstField; ///< Index into HidInterfacePlan::fields
+  uint8_t fieldCount;
+};
+
+/** @brief Extraction plan for one HID interface. */
+struct HidInterfacePlan {
+  bool usesReportIds;
+  uint8_t reportCount;
+  uint8_t fieldCount;
+  HidReportPlan reports[HID_PLAN_MAX_REPORTS];
+  HidFieldPlan fields[HID_PLAN_MAX_FIELDS];
+};
+
+/** @brief Normalized content of one decoded input report. */
+struct HidDecodedReport {
+  uint8_t kinds;    ///< HidReportKind mask of the source report
+  uint8_t reportId;
+  uint8_t source;   ///< Interface index, set by the USB layer
+
+  // Keyboard
+  uint8_t modifiers;
+  KeyBitmap keys;
+
+  // Mouse
+  uint8_t buttons;
+  int16_t x;
+  int16_t y;
+  int16_t wheel;
+  int16_t pan;
+
+  // Consumer control
+  uint8_t consumerCount;
+  uint16_t consumer[HID_DECODED_MAX_CONSUMER];
+};
+
+/**
+ * @brief Parses a report descriptor into an extraction plan.
+ * @return true if at least one keyboard, mouse or consumer report was found
+ */
+bool hidParseReportDescriptor(const uint8_t *desc, size_t length, HidInterfacePlan &plan);
+
+/** @brief Builds the plan for a keyboard running the boot protocol. */
+void hidBuildBootKeyboardPlan(HidInterfacePlan &plan);
+
+/** @brief Builds the plan for a mouse running the boot protocol. */
+void hidBuildBootMousePlan(HidInterfacePlan &plan);
+
+/**
+ * @brief Decodes one input report by walking the plan.
+ *
+ * Fields that lie beyond the end of a short report are left at zero, which
+ * covers boot mice that omit the optional wheel byte.
+ * @return false if the report ID is not part of the plan
+ */
+bool hidDecodeReport(const HidInterfacePlan &plan, const uint8_t *data, size_t length,
+                     HidDecodedReport &out);
+
+#endif // HID_REPORT_PARSER_H
@@ -0,0 +1,85 @@
+#include "HostSlots.h"
+#include <string.h>
+
+void HostSlots::begin(const std::string &baseName, const uint8_t mac[6]) {
+  // Leave room for the " n" suffix within the advertised name limit, cutting at a word
+  std::string base = baseName;
+  if (base.size() > HOST_SLOT_NAME_MAX - 2) {
+    base.resize(HOST_SLOT_NAME_MAX - 2);
+    const size_t space = base.find_last_of(' ');
+    if (space != std::string::npos && space > 0) {
+      base.resize(space);
+    }
+  }
+
+  for (uint8_t slot = 0; slot < HOST_SLOT_COUNT; slot++) {
+    // Little-endian copy of the MAC with the slot mixed into the low byte; the
+    // two top bits of the most significant byte mark a random static address
+    for (int i = 0; i < 6; i++) {
+      _identity[slot][i] = mac[5 - i];
+    }
+    _identity[slot][0] ^= (uint8_t)(slot + 1);
+    _identity[slot][5] |= 0xC0;
+
+    _names[slot] = base + " " + (char)('1' + slot);
+  }
+}
+
+bool HostSlots::load(const host_slots_record_t &record) {
+  if (record.version != HOST_SLOTS_RECORD_VERSION || record.active >= HOST_SLOT_COUNT) {
+    return false;
+  }
+  _record = record;
+  return true;
+}
+
+bool HostSlots::setActive(uint8_t slot) {
+  if (slot >= HOST_SLOT_COUNT) {
+    return false;
+  }
+  _record.active = slot;
+  return true;
+}
+
+int HostSlots::findPeer(const uint8_t peer[6]) const {
+  for (uint8_t slot = 0; slot < HOST_SLOT_COUNT; slot++) {
+    if (_record.peers[slot].bonded && memcmp(_record.peers[slot].peer, peer, 6) == 0) {
+      return slot;
+    }
+  }
+  return -1;
+}
+
+bool HostSlots::bindPeer(uint8_t slot, const uint8_t peer[6], uint8_t peerType,
+                         host_slot_peer_t *replaced) {
+  if (slot >= HOST_SLOT_COUNT) {
+    return false;
+  }
+
+  host_slot_peer_t &current = _record.peers[slot];
+  if (current.bonded && current.peerType == peerType && memcmp(current.peer, peer, 6) == 0) {
+    return false;
+  }
+
+  const host_slot_peer_t previous = current;
+  current.bonded = 1;
+  current.peerType = peerType;
+  memcpy(current.peer, peer, 6);
+
+  if (replaced != nullptr) {
+    // The old host's bond can go unless another slot still points at it
+    *replaced = previous;
+    if (previous.bonded && findPeer(previous.peer) >= 0) {
+      replaced->bonded = 0;
+    }
+  }
+  return true;
+}
+
+bool HostSlots::clearPeer(uint8_t slot) {
+  if (slot >= HOST_SLOT_COUNT || !_record.peers[slot].bonded) {
+    return false;
+  }
+  memset(&_record.peers[slot], 0, sizeof(_record.peers[slot]));
+  return true;
+}
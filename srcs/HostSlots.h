@@ -0,0 +1,89 @@
+/**
+ * @file HostSlots.h
+ * @brief Host slot table for switching between up to three paired BLE hosts.
+ *
+ * Every slot appears to its host as a separate device: it has its own random
+ * static identity address and its own name, both derived from the chip's
+ * Bluetooth MAC, so a host only ever reconnects to the slot it paired with.
+ * The slot also remembers the identity address of the host it bonded with,
+ * which is the target of directed advertising when switching back to it.
+ *
+ * Only the active slot and the bonded peers are persisted (see
+ * host_slots_record_t); addresses and names are derived on every boot.
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef HOST_SLOTS_H
+#define HOST_SLOTS_H
+
+#include <stdint.h>
+#include <string>
+
+#define HOST_SLOT_COUNT 3
+
+/** @brief Bonded peer of one slot. Addresses are little-endian as in NimBLE. */
+typedef struct {
+  uint8_t bonded;
+  uint8_t peerType; ///< BLE address type of the peer identity address
+  uint8_t peer[6];
+} host_slot_peer_t;
+
+/** @brief Persisted part of the table, stored as one blob. */
+typedef struct {
+  uint8_t version;
+  uint8_t active;
+  host_slot_peer_t peers[HOST_SLOT_COUNT];
+} host_slots_record_t;
+
+#define HOST_SLOTS_RECORD_VERSION 1
+
+class HostSlots {
+public:
+  /**
+   * @brief Derives the slot identities.
+   * @param baseName Device name; slots are advertised as "<baseName> <n>"
+   * @param mac Bluetooth MAC of the chip, most significant byte first (esp_read_mac order)
+   */
+  void begin(const std::string &baseName, const uint8_t mac[6]);
+
+  /// Restores the active slot and peers. Returns false (and keeps defaults) for a bad record.
+  bool load(const host_slots_record_t &record);
+
+  const host_slots_record_t &record() const { return _record; }
+
+  uint8_t active() const { return _record.active; }
+
+  /// Returns false if slot is out of range.
+  bool setActive(uint8_t slot);
+
+  /// Random static identity address of a slot, little-endian.
+  const uint8_t *identity(uint8_t slot) const { return _identity[slot]; }
+
+  /// Advertised name of a slot, at most HOST_SLOT_NAME_MAX characters.
+  const std::string &name(uint8_t slot) const { return _names[slot]; }
+
+  const host_slot_peer_t &peer(uint8_t slot) const { return _record.peers[slot]; }
+
+  /**
+   * @brief Records the host a slot bonded with.
+   * @param replaced Receives the previous peer if it is no longer used by any slot
+   * @return true if the table changed and should be saved
+   */
+  bool bindPeer(uint8_t slot, const uint8_t peer[6], uint8_t peerType, host_slot_peer_t *replaced);
+
+  /// Forgets the peer of a slot. Returns true if the table changed.
+  bool clearPeer(uint8_t slot);
+
+  /// Slot whose bonded peer has this address, or -1.
+  int findPeer(const uint8_t peer[6]) const;
+
+  /// Longest name that still fits into the advertising packet.
+  static const size_t HOST_SLOT_NAME_MAX = 20;
+
+private:
+  host_slots_record_t _record = {HOST_SLOTS_RECORD_VERSION, 0, {}};
+  uint8_t _identity[HOST_SLOT_COUNT][6] = {};
+  std::string _names[HOST_SLOT_COUNT];
+};
+
+#endif // HOST_SLOTS_H
@@ -1,7 +1,11 @@
 #include "Joystick.h"
 #include "Display.h"
 #include "Bridge.h"
+#include "PointerIntegrator.h"
+#include "Seqlock.h"
 #include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_timer.h>
 
 extern TFT_eSPI tft;
 
@@ -11,17 +15,183 @@ int lastY = 0;
 bool lastButton = true;
 bool lastMouseButton = false;
 
-// Deadzone threshold to filter ADC noise
+// Change in filtered counts that redraws the values (noise is handled by JoystickFilter)
 #define DEADZONE 30
 
-// Mouse control settings
-#define MOUSE_CENTER 2048          // Center point of analog range (0-4095)
-#define MOUSE_SENSITIVITY 0.01     // Adjust this to change mouse speed (0.01-0.1)
-#define MOUSE_MAX_SPEED 10         // Maximum pixels per update
+// Sampler task state; consumers only see the snapshot
+static JoystickFilter filter;
+static Seqlock<joystick_sample_t> snapshot;
+static joystick_stats_t stats = {};
+static portMUX_TYPE statsMutex = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool traceEnabled = false;
+static int8_t channelX = -1; // ADC1 channels when sampled by DMA
+static int8_t channelY = -1;
+static uint16_t traceEvery = JOYSTICK_OUTPUT_HZ / 100; // Readings per trace line
+
+// Mouse mode: the pointer task owns the integrator; speed comes from POINTER_CURVE_DEFAULT
+static PointerIntegrator pointer;
+
+// Conversions for one output period, and a few periods of DMA pool behind it
+#define JOYSTICK_FRAME_CONVERSIONS (JOYSTICK_SAMPLE_HZ / JOYSTICK_OUTPUT_HZ)
+#define JOYSTICK_FRAME_BYTES (JOYSTICK_FRAME_CONVERSIONS * SOC_ADC_DIGI_RESULT_BYTES)
 
 // Joystick mode flag
 // Set to true for joystick mode, false for mouse mode
-bool joystickMode = true;
+volatile bool joystickMode = true;
+
+// Hands one output period to the consumers
+static void publish(uint16_t conversions, uint16_t dropped)
+{
+  // Button is active low with pull-up
+  const joystick_sample_t sample = filter.commit((uint32_t)esp_timer_get_time(), !digitalRead(JOYSTICK_BTN_PIN));
+  snapshot.write(sample);
+
+  portENTER_CRITICAL(&statsMutex);
+  stats.readings++;
+  stats.conversions += conversions;
+  stats.dropped += dropped;
+  portEXIT_CRITICAL(&statsMutex);
+
+  if (traceEnabled && sample.sequence % traceEvery == 0)
+  {
+    Serial.printf("J,%u,%u,%u,%u\n", (unsigned)sample.timeUs, sample.rawX, sample.rawY, sample.button ? 1 : 0);
+  }
+}
+
+// Continuous mode: the ADC converts both axes in turn at JOYSTICK_SAMPLE_HZ into a DMA pool;
+// every frame read back is one output period
+static bool startContinuousAdc()
+{
+  const int8_t x = digitalPinToAnalogChannel(JOYSTICK_VRX_PIN);
+  const int8_t y = digitalPinToAnalogChannel(JOYSTICK_VRY_PIN);
+  if (x < 0 || y < 0 || x >= SOC_ADC_MAX_CHANNEL_NUM || y >= SOC_ADC_MAX_CHANNEL_NUM)
+  {
+    Serial.println("[JOYSTICK] An axis is not on ADC1, sampling with analogRead");
+    return false;
+  }
+  channelX = x;
+  channelY = y;
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = JOYSTICK_FRAME_BYTES * 4;
+  init.conv_num_each_intr = JOYSTICK_FRAME_BYTES;
+  init.adc1_chan_mask = BIT(channelX) | BIT(channelY);
+  if (adc_digi_initialize(&init) != ESP_OK)
+  {
+    return false;
+  }
+
+  adc_digi_pattern_config_t pattern[2] = {};
+  const int8_t channels[2] = {channelX, channelY};
+  for (int i = 0; i < 2; i++)
+  {
+    pattern[i].atten = ADC_ATTEN_DB_11;
+    pattern[i].channel = channels[i];
+    pattern[i].unit = 0; // ADC1
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+  adc_digi_configuration_t config = {};
+  config.pattern_num = 2;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = JOYSTICK_SAMPLE_HZ;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK)
+  {
+    adc_digi_deinitialize();
+    return false;
+  }
+  return true;
+}
+
+static void continuousSamplerTask(void *parameter)
+{
+  uint8_t frame[JOYSTICK_FRAME_BYTES];
+  while (true)
+  {
+    uint32_t length = 0;
+    const esp_err_t result = adc_digi_read_bytes(frame, sizeof(frame), &length, 10);
+    if (result != ESP_OK && result != ESP_ERR_INVALID_STATE)
+    {
+      continue; // Timeout
+    }
+    // ESP_ERR_INVALID_STATE: the pool overflowed; the frame is still valid, older ones were lost
+    uint16_t conversions = 0;
+    uint16_t dropped = result == ESP_ERR_INVALID_STATE ? JOYSTICK_FRAME_CONVERSIONS : 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES)
+    {
+      const adc_digi_output_data_t *data = (const adc_digi_output_data_t *)&frame[i];
+      if (data->type2.channel == channelX)
+      {
+        filter.addX(data->type2.data);
+      }
+      else if (data->type2.channel == channelY)
+      {
+        filter.addY(data->type2.data);
+      }
+      else
+      {
+        dropped++;
+        continue;
+      }
+      conversions++;
+    }
+    publish(conversions, dropped);
+  }
+}
+
+// Fallback at the mouse report rate: a few analogRead conversions per axis and period
+static void timedSamplerTask(void *parameter)
+{
+  TickType_t wake = xTaskGetTickCount();
+  const TickType_t period = max(pdMS_TO_TICKS(1000 / JOYSTICK_FALLBACK_HZ), (TickType_t)1);
+  while (true)
+  {
+    for (int i = 0; i < JOYSTICK_OVERSAMPLE; i++)
+    {
+      filter.addX(analogRead(JOYSTICK_VRX_PIN));
+      filter.addY(analogRead(JOYSTICK_VRY_PIN));
+    }
+    publish(2 * JOYSTICK_OVERSAMPLE, 0);
+    vTaskDelayUntil(&wake, period);
+  }
+}
+
+// Mouse mode at a fixed report rate. Motion comes from the time that really passed since
+// the previous report, so a late wake-up moves the pointer further instead of dropping motion.
+static void pointerTask(void *parameter)
+{
+  TickType_t wake = xTaskGetTickCount();
+  const TickType_t period = max(pdMS_TO_TICKS(1000 / JOYSTICK_MOUSE_REPORT_HZ), (TickType_t)1);
+  int64_t lastUs = esp_timer_get_time();
+  while (true)
+  {
+    vTaskDelayUntil(&wake, period);
+    const int64_t nowUs = esp_timer_get_time();
+    const uint32_t elapsedUs = (uint32_t)(nowUs - lastUs);
+    lastUs = nowUs;
+
+    joystick_sample_t sample;
+    if (joystickMode || !joystickRead(sample))
+    {
+      pointer.reset();
+      continue;
+    }
+
+    int8_t mouseX, mouseY;
+    pointer.update(-sample.x, sample.y, elapsedUs, mouseX, mouseY); // Inverted X axis
+
+    // Send mouse report if movement or button state changed
+    if (mouseX != 0 || mouseY != 0 || sample.button != lastMouseButton)
+    {
+      Bridge::sendMouseReport(sample.button ? 0x01 : 0x00, mouseX, mouseY, 0);
+      lastMouseButton = sample.button;
+      portENTER_CRITICAL(&statsMutex);
+      stats.mouseReports++;
+      portEXIT_CRITICAL(&statsMutex);
+    }
+  }
+}
 
 void joystickInit()
 {
@@ -31,34 +201,76 @@ void joystickInit()
   
   // Configure button pin with pull-up (button is active low)
   pinMode(JOYSTICK_BTN_PIN, INPUT_PULLUP);
+
+  // Sampling and filtering run in their own task; loop() only reads the snapshot
+  stats.dma = startContinuousAdc();
+  const int outputHz = stats.dma ? JOYSTICK_OUTPUT_HZ : JOYSTICK_FALLBACK_HZ;
+  traceEvery = max(outputHz / 100, 1);
+  if (stats.dma)
+  {
+    xTaskCreatePinnedToCore(continuousSamplerTask, "JoystickSampler", 3072, nullptr, 2, nullptr, 1);
+  }
+  else
+  {
+    // Same priority as loop(), so the blocking conversions never preempt it
+    xTaskCreatePinnedToCore(timedSamplerTask, "JoystickSampler", 3072, nullptr, 1, nullptr, 1);
+  }
+  xTaskCreatePinnedToCore(pointerTask, "JoystickPointer", 3072, nullptr, 2, nullptr, 1);
   
   Serial.println("Joystick initialized");
   Serial.printf("  VRx: GPIO%d\n", JOYSTICK_VRX_PIN);
   Serial.printf("  VRy: GPIO%d\n", JOYSTICK_VRY_PIN);
   Serial.printf("  Button: GPIO%d\n", JOYSTICK_BTN_PIN);
+  Serial.printf("  Sampling: %s, %d readings/s\n", stats.dma ? "continuous ADC (DMA)" : "analogRead",
+                outputHz);
+  Serial.printf("  Mouse mode: %d reports/s\n", JOYSTICK_MOUSE_REPORT_HZ);
+}
+
+bool joystickRead(joystick_sample_t &sample)
+{
+  if (snapshot.version() == 0)
+  {
+    return false;
+  }
+  sample = snapshot.read();
+  return true;
+}
+
+joystick_stats_t joystickGetStats()
+{
+  portENTER_CRITICAL(&statsMutex);
+  const joystick_stats_t copy = stats;
+  portEXIT_CRITICAL(&statsMutex);
+  return copy;
+}
+
+void joystickSetTrace(bool enabled)
+{
+  traceEnabled = enabled;
 }
 
 int joystickReadX()
 {
-  return analogRead(JOYSTICK_VRX_PIN);
+  return snapshot.read().rawX;
 }
 
 int joystickReadY()
 {
-  return analogRead(JOYSTICK_VRY_PIN);
+  return snapshot.read().rawY;
 }
 
 bool joystickReadButton()
 {
-  // Button is active low with pull-up
-  return !digitalRead(JOYSTICK_BTN_PIN);
+  return snapshot.read().button;
 }
 
 void displayJoystickValues()
 {
-  int x = joystickReadX();
-  int y = joystickReadY();
-  bool button = joystickReadButton();
+  // One consistent reading for all three values
+  const joystick_sample_t sample = snapshot.read();
+  int x = sample.rawX;
+  int y = sample.rawY;
+  bool button = sample.button;
   
   // Only update display if values changed significantly (beyond deadzone)
   bool xChanged = abs(x - lastX) > DEADZONE;
@@ -100,47 +312,22 @@ void displayJoystickValues()
 
 void joystickControlMouse()
 {
-  int x = joystickReadX();
-  int y = joystickReadY();
-  bool button = joystickReadButton();
-  
-  if (joystickMode)
+  // Mouse mode reports from pointerTask at JOYSTICK_MOUSE_REPORT_HZ
+  if (!joystickMode)
   {
-    // JOYSTICK MODE
-    // Map 0-4095 to 0-255 for joystick axes (127 is center)
-    uint8_t joyX = 255 - ((x >> 4) & 0xFF);  // Convert 0-4095 to 0-255, inverted
-    uint8_t joyY = (y >> 4) & 0xFF;  // Convert 0-4095 to 0-255
-    uint8_t joyButtons = button ? 0x01 : 0x00;  // Button 1
-    
-    // Send joystick report
-    Bridge::sendJoystickReport(joyButtons, joyX, joyY, 127);
-  }
-  else
-  {
-    // MOUSE MODE (original implementation)
-    // Convert analog readings to mouse movement
-    // Map from 0-4095 to -1024 to +1024 (centered at 2048)
-    int xDelta = MOUSE_CENTER - x;  // Inverted X axis
-    int yDelta = y - MOUSE_CENTER;
-    
-    // Apply deadzone to prevent drift
-    if (abs(xDelta) < 100) xDelta = 0;
-    if (abs(yDelta) < 100) yDelta = 0;
-    
-    // Scale movement with sensitivity and limit to max speed
-    int8_t mouseX = constrain((int8_t)(xDelta * MOUSE_SENSITIVITY), -MOUSE_MAX_SPEED, MOUSE_MAX_SPEED);
-    int8_t mouseY = constrain((int8_t)(yDelta * MOUSE_SENSITIVITY), -MOUSE_MAX_SPEED, MOUSE_MAX_SPEED);
-    
-    // Convert button press to mouse button byte (bit 0 = left click)
-    uint8_t mouseButtons = button ? 0x01 : 0x00;
-    
-    // Send mouse report if movement or button state changed
-    if (mouseX != 0 || mouseY != 0 || button != lastMouseButton)
-    {
-      Bridge::sendMouseReport(mouseButtons, mouseX, mouseY, 0);
-      lastMouseButton = button;
-    }
+    return;
   }
+
+  const joystick_sample_t sample = snapshot.read();
+
+  // JOYSTICK MODE
+  // Calibrated -32767..32767 to 0-255 (127 is center, deadzone already applied)
+  uint8_t joyX = (uint8_t)(127 - sample.x / 258);  // Inverted
+  uint8_t joyY = (uint8_t)(127 + sample.y / 258);
+  uint8_t joyButtons = sample.button ? 0x01 : 0x00;  // Button 1
+
+  // Send joystick report
+  Bridge::sendJoystickReport(joyButtons, joyX, joyY, 127);
 }
 
 void joystickToggleMode()
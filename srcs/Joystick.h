@@ -2,16 +2,47 @@
 #define JOYSTICK_H
 
 #include <Arduino.h>
+#include "JoystickFilter.h"
 
-// Joystick pin definitions
+// Joystick pin definitions. GPIO15 is on ADC2, so with this wiring the
+// joystick runs on the analogRead fallback below; move VRX to a free ADC1
+// pin (GPIO1-10) to get continuous DMA sampling.
 #define JOYSTICK_VRY_PIN 4   // Analog X axis
 #define JOYSTICK_VRX_PIN 15   // Analog Y axis
 #define JOYSTICK_BTN_PIN 5  // Digital button
 
+// Mouse mode: reports per second, matching the 7.5 ms BLE connection interval at most
+#define JOYSTICK_MOUSE_REPORT_HZ 125
+
+// Sampling: conversions per second over both axes, and filtered readings per second.
+// Continuous (DMA) mode needs both axes on ADC1 (GPIO1-10); otherwise a timed task
+// oversamples with analogRead. analogRead blocks, so the fallback only produces
+// readings as fast as mouse mode consumes them, at loop()'s priority.
+#define JOYSTICK_SAMPLE_HZ 20000
+#define JOYSTICK_OUTPUT_HZ 1000
+#define JOYSTICK_FALLBACK_HZ JOYSTICK_MOUSE_REPORT_HZ
+#define JOYSTICK_OVERSAMPLE 4 // analogRead fallback: conversions per axis and reading
+
+typedef struct {
+  uint32_t readings;     ///< Filtered readings published
+  uint32_t conversions;  ///< ADC conversions averaged into them
+  uint32_t dropped;      ///< Conversions for other channels or lost to a full DMA pool
+  uint32_t mouseReports; ///< Mouse mode reports sent
+  bool dma;              ///< Continuous ADC driver in use (false: analogRead fallback)
+} joystick_stats_t;
+
 // Joystick initialization
 void joystickInit();
 
-// Read joystick values
+// Latest filtered reading; never blocks the sampler. False until the first one arrives.
+bool joystickRead(joystick_sample_t &sample);
+
+joystick_stats_t joystickGetStats();
+
+// Prints the filtered readings as "J,<us>,<x>,<y>,<button>" lines at up to 100 Hz for sim --joystick-trace
+void joystickSetTrace(bool enabled);
+
+// Read joystick values (filtered ADC counts)
 int joystickReadX();
 int joystickReadY();
 bool joystickReadButton();
@@ -19,7 +50,8 @@ bool joystickReadButton();
 // Display joystick values
 void displayJoystickValues();
 
-// Control mouse with joystick
+// Joystick mode: sends the joystick report. Mouse mode runs in its own task
+// (srcs/PointerIntegrator.h), so this returns without sending.
 void joystickControlMouse();
 
 // Toggle between joystick and mouse mode
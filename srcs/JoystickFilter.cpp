@@ -0,0 +1,99 @@
+#include "JoystickFilter.h"
+
+static int32_t clamp32(int32_t value, int32_t low, int32_t high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+bool AxisFilter::commit(uint32_t nowMs) {
+  if (_count == 0) {
+    return false;
+  }
+  // Oversampling: the period's mean in Q8 keeps the fraction the single conversions lack
+  const int32_t average = (int32_t)(((uint64_t)_sum * 256 + _count / 2) / _count);
+  _sum = 0;
+  _count = 0;
+
+  if (!_primed) {
+    // The stick rests at boot: the first reading is the centre
+    _primed = true;
+    _state = average;
+    _center = filtered();
+    _low = (uint16_t)clamp32(_center - _config.minSpan, 0, JOYSTICK_ADC_MAX);
+    _high = (uint16_t)clamp32(_center + _config.minSpan, 0, JOYSTICK_ADC_MAX);
+    _resting = true;
+    _restSince = nowMs;
+  } else {
+    _state += (average - _state) >> _config.iirShift;
+  }
+
+  const uint16_t value = filtered();
+  if (value < _low) {
+    _low = value;
+  }
+  if (value > _high) {
+    _high = value;
+  }
+
+  // Drift correction: after resting long enough the centre walks one count per period
+  const int32_t offset = (int32_t)value - _center;
+  if (offset >= -(int32_t)_config.restBand && offset <= (int32_t)_config.restBand) {
+    if (!_resting) {
+      _resting = true;
+      _restSince = nowMs;
+    } else if (nowMs - _restSince >= _config.recenterMs && offset != 0) {
+      _center += offset > 0 ? 1 : -1;
+    }
+  } else {
+    _resting = false;
+  }
+
+  _value = normalize(value);
+  return true;
+}
+
+int16_t AxisFilter::normalize(uint16_t value) const {
+  const int32_t offset = (int32_t)value - _center;
+  const int32_t magnitude = offset < 0 ? -offset : offset;
+  if (magnitude <= _config.deadzone) {
+    return 0;
+  }
+  // Each side scales on its own span, so an off-centre stick still reaches full scale both ways
+  int32_t span = offset < 0 ? _center - _low : _high - _center;
+  if (span <= _config.deadzone) {
+    span = _config.deadzone + 1;
+  }
+  const int32_t scaled = clamp32((magnitude - _config.deadzone) * JOYSTICK_AXIS_MAX / (span - _config.deadzone), 0,
+                                 JOYSTICK_AXIS_MAX);
+  return (int16_t)(offset < 0 ? -scaled : scaled);
+}
+
+JoystickFilter::JoystickFilter(const joystick_filter_config_t &config) : _config(config) {
+  _x.configure(config);
+  _y.configure(config);
+}
+
+joystick_sample_t JoystickFilter::commit(uint32_t nowUs, bool buttonPressed) {
+  const uint32_t nowMs = nowUs / 1000;
+  _last.samples = _x.pending() + _y.pending();
+  _x.commit(nowMs);
+  _y.commit(nowMs);
+
+  // Debounce: the button changes after buttonCommits equal reads in a row
+  if (buttonPressed != _buttonRaw) {
+    _buttonRaw = buttonPressed;
+    _buttonCount = 1;
+  } else if (_buttonCount < _config.buttonCommits) {
+    _buttonCount++;
+  }
+  if (_buttonCount >= _config.buttonCommits) {
+    _last.button = _buttonRaw;
+  }
+
+  _last.timeUs = nowUs;
+  _last.sequence++;
+  _last.x = _x.value();
+  _last.y = _y.value();
+  _last.rawX = _x.filtered();
+  _last.rawY = _y.filtered();
+  return _last;
+}
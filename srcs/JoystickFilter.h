@@ -0,0 +1,111 @@
+/**
+ * @file JoystickFilter.h
+ * @brief Oversampling, IIR smoothing and self-calibration for the analog joystick.
+ *
+ * The ADC sampler adds every conversion of an axis with add(). Once per
+ * output period, commit() averages them (oversampling) and runs an
+ * exponential IIR over the averages. It then maps the result onto
+ * -32767..32767 around a calibrated centre. Calibration runs continuously:
+ * - The first committed value is taken as the centre, since the stick
+ *   rests at boot.
+ * - While the stick stays within restBand for recenterMs, the centre
+ *   follows slowly, so thermal drift does not show up as motion.
+ * - The range starts at centre +/- minSpan and grows whenever the stick
+ *   is pushed further, so full deflection reaches full scale.
+ * The button is debounced over consecutive commits.
+ *
+ * All arithmetic is integer, so a recorded trace gives the same output on
+ * the host (sim --joystick-trace) as on the device.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef JOYSTICK_FILTER_H
+#define JOYSTICK_FILTER_H
+
+#include <stdint.h>
+
+#define JOYSTICK_ADC_MAX 4095
+#define JOYSTICK_AXIS_MAX 32767
+
+typedef struct {
+  uint8_t iirShift;      ///< Each average moves the output by 1/2^iirShift of the difference
+  uint16_t deadzone;     ///< Counts around the centre reported as 0
+  uint16_t restBand;     ///< Counts around the centre that count as resting
+  uint32_t recenterMs;   ///< Rest time before the centre starts following
+  uint16_t minSpan;      ///< Half-range assumed until the stick has been pushed further
+  uint8_t buttonCommits; ///< Consecutive equal reads before the button changes
+} joystick_filter_config_t;
+
+#define JOYSTICK_FILTER_DEFAULTS {2, 60, 40, 500, 1500, 3}
+
+/// One filtered reading, as published to consumers.
+typedef struct {
+  uint32_t timeUs;   ///< When the output period closed
+  uint32_t sequence; ///< Output periods since start
+  int16_t x;         ///< -32767..32767, 0 at the calibrated centre
+  int16_t y;
+  uint16_t rawX;     ///< Filtered ADC counts
+  uint16_t rawY;
+  uint16_t samples;  ///< Conversions averaged into this reading (both axes)
+  bool button;
+} joystick_sample_t;
+
+class AxisFilter {
+public:
+  void configure(const joystick_filter_config_t &config) { _config = config; }
+
+  void add(uint16_t raw) {
+    _sum += raw;
+    _count++;
+  }
+
+  /// Closes the period; false (and nothing changes) if no conversion arrived.
+  bool commit(uint32_t nowMs);
+
+  uint16_t filtered() const { return (uint16_t)((_state + 128) >> 8); }
+  int16_t value() const { return _value; }
+  uint16_t center() const { return _center; }
+  uint16_t low() const { return _low; }
+  uint16_t high() const { return _high; }
+  uint16_t pending() const { return _count; }
+
+private:
+  int16_t normalize(uint16_t filtered) const;
+
+  joystick_filter_config_t _config = JOYSTICK_FILTER_DEFAULTS;
+  uint32_t _sum = 0;
+  uint16_t _count = 0;
+  int32_t _state = 0; ///< Q8 ADC counts
+  bool _primed = false;
+  uint16_t _center = JOYSTICK_ADC_MAX / 2;
+  uint16_t _low = 0;
+  uint16_t _high = JOYSTICK_ADC_MAX;
+  uint32_t _restSince = 0;
+  bool _resting = false;
+  int16_t _value = 0;
+};
+
+class JoystickFilter {
+public:
+  explicit JoystickFilter(const joystick_filter_config_t &config = JOYSTICK_FILTER_DEFAULTS);
+
+  void addX(uint16_t raw) { _x.add(raw); }
+  void addY(uint16_t raw) { _y.add(raw); }
+
+  /// Closes one output period and returns the reading for it.
+  joystick_sample_t commit(uint32_t nowUs, bool buttonPressed);
+
+  const AxisFilter &x() const { return _x; }
+  const AxisFilter &y() const { return _y; }
+
+private:
+  joystick_filter_config_t _config;
+  AxisFilter _x;
+  AxisFilter _y;
+  joystick_sample_t _last = {};
+  bool _buttonRaw = false;
+  uint8_t _buttonCount = 0;
+};
+
+#endif // JOYSTICK_FILTER_H
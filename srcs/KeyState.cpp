@@ -0,0 +1,135 @@
+#include "KeyState.h"
+#include <string.h>
+
+uint8_t KeyBitmap::toArray(uint8_t *out, uint8_t max) const {
+  uint8_t n = 0;
+  for (int w = 0; w < KEY_BITMAP_WORDS && n < max; w++) {
+    uint32_t bits = words[w];
+    while (bits && n < max) {
+      out[n++] = (uint8_t)((w << 5) + __builtin_ctz(bits));
+      bits &= bits - 1;
+    }
+  }
+  return n;
+}
+
+void KeyStateEngine::clear() {
+  for (int s = 0; s < KEY_STATE_MAX_SOURCES; s++) {
+    _sourceKeys[s].clear();
+    _sourceModifiers[s] = 0;
+  }
+  _keys.clear();
+  _modifiers = 0;
+}
+
+bool KeyStateEngine::update(uint8_t source, uint8_t modifiers, const KeyBitmap &keys,
+                            KeyStateDiff &diff) {
+  if (source >= KEY_STATE_MAX_SOURCES) {
+    source = KEY_STATE_MAX_SOURCES - 1;
+  }
+  _sourceKeys[source] = keys;
+  _sourceModifiers[source] = modifiers;
+  return recompute(diff);
+}
+
+bool KeyStateEngine::releaseSource(uint8_t source, KeyStateDiff &diff) {
+  if (source >= KEY_STATE_MAX_SOURCES) {
+    return false;
+  }
+  _sourceKeys[source].clear();
+  _sourceModifiers[source] = 0;
+  return recompute(diff);
+}
+
+bool KeyStateEngine::recompute(KeyStateDiff &diff) {
+  uint32_t changedAny = 0;
+  uint32_t pressedCount = 0;
+  uint32_t releasedCount = 0;
+
+  for (int w = 0; w < KEY_BITMAP_WORDS; w++) {
+    uint32_t next = 0;
+    for (int s = 0; s < KEY_STATE_MAX_SOURCES; s++) {
+      next |= _sourceKeys[s].words[w];
+    }
+    const uint32_t changed = next ^ _keys.words[w];
+    diff.pressed.words[w] = changed & next;
+    diff.released.words[w] = changed & _keys.words[w];
+    pressedCount += __builtin_popcount(diff.pressed.words[w]);
+    releasedCount += __builtin_popcount(diff.released.words[w]);
+    changedAny |= changed;
+    _keys.words[w] = next;
+  }
+
+  uint8_t modifiers = 0;
+  for (int s = 0; s < KEY_STATE_MAX_SOURCES; s++) {
+    modifiers |= _sourceModifiers[s];
+  }
+  const uint8_t modifiersChanged = modifiers ^ _modifiers;
+  diff.modifiersPressed = modifiersChanged & modifiers;
+  diff.modifiersReleased = modifiersChanged & _modifiers;
+  _modifiers = modifiers;
+
+  diff.pressedCount = (uint8_t)pressedCount;
+  diff.releasedCount = (uint8_t)releasedCount;
+  return changedAny != 0 || modifiersChanged != 0;
+}
+
+void KeyReportBuilder::reset() {
+  memset(_slots, 0, sizeof(_slots));
+}
+
+void KeyReportBuilder::build(uint8_t modifiers, const KeyBitmap &keys, bool nkroEnabled,
+                             uint8_t boot[KEY_BOOT_REPORT_SIZE],
+                             uint8_t nkro[KEY_NKRO_REPORT_SIZE]) {
+  if (!nkroEnabled) {
+    buildBoot(modifiers, keys, boot);
+    memset(nkro, 0, KEY_NKRO_REPORT_SIZE);
+    return;
+  }
+
+  // Bitmap words 0-2 cover 0x00-0x5F, word 3 covers 0x60-0x7F; 0x78+ overflow to boot
+  nkro[0] = modifiers;
+  for (int i = 0; i < KEY_NKRO_REPORT_SIZE - 1; i++) {
+    nkro[1 + i] = (uint8_t)(keys.words[i >> 2] >> ((i & 3) * 8));
+  }
+
+  KeyBitmap overflow = keys;
+  for (int w = 0; w < 3; w++) {
+    overflow.words[w] = 0;
+  }
+  overflow.words[3] &= ~((1u << ((KEY_NKRO_MAX_USAGE + 1) - 96)) - 1);
+  buildBoot(0, overflow, boot);
+}
+
+void KeyReportBuilder::buildBoot(uint8_t modifiers, const KeyBitmap &keys,
+                                 uint8_t boot[KEY_BOOT_REPORT_SIZE]) {
+  boot[0] = modifiers;
+  boot[1] = 0;
+
+  if (keys.count() > KEY_BOOT_REPORT_KEYS) {
+    // Phantom state per HID 1.11: report ErrorRollOver, host keeps its previous keys
+    memset(&boot[2], KEY_ERROR_ROLLOVER, KEY_BOOT_REPORT_KEYS);
+    return;
+  }
+
+  // Keep held keys in their slot, drop released ones
+  KeyBitmap unplaced = keys;
+  for (int i = 0; i < KEY_BOOT_REPORT_KEYS; i++) {
+    if (_slots[i] > KEY_ERROR_ROLLOVER && unplaced.test(_slots[i])) {
+      unplaced.reset(_slots[i]);
+    } else {
+      _slots[i] = 0;
+    }
+  }
+
+  // New presses fill the free slots
+  int slot = 0;
+  unplaced.forEach([&](uint8_t key) {
+    while (_slots[slot] != 0) {
+      slot++;
+    }
+    _slots[slot] = key;
+  });
+
+  memcpy(&boot[2], _slots, KEY_BOOT_REPORT_KEYS);
+}
@@ -0,0 +1,153 @@
+/**
+ * @file KeyState.h
+ * @brief Full-rollover keyboard state held as a 256-bit bitmap.
+ *
+ * Press and release sets are computed with word-wide XOR and popcount instead
+ * of comparing 6-slot arrays position by position, so keys that move between
+ * slots are not mistaken for releases and there is no 6-key limit.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef KEY_STATE_H
+#define KEY_STATE_H
+
+#include <stdint.h>
+
+#define KEY_BITMAP_WORDS 8
+#define KEY_STATE_MAX_SOURCES 4
+
+#define KEY_BOOT_REPORT_SIZE 8
+#define KEY_BOOT_REPORT_KEYS 6
+#define KEY_ERROR_ROLLOVER 0x01
+
+/** @brief Highest usage carried by the BLE NKRO report (bitmap of 0x00..0x77). */
+#define KEY_NKRO_MAX_USAGE 0x77
+/** @brief Modifier byte + 120-bit bitmap; fits a default 20-byte ATT notification. */
+#define KEY_NKRO_REPORT_SIZE (1 + (KEY_NKRO_MAX_USAGE + 1) / 8)
+
+/** @brief One bit per keyboard usage 0x00-0xFF. */
+struct KeyBitmap {
+  uint32_t words[KEY_BITMAP_WORDS];
+
+  void clear() {
+    for (int i = 0; i < KEY_BITMAP_WORDS; i++) {
+      words[i] = 0;
+    }
+  }
+
+  void set(uint8_t key) { words[key >> 5] |= 1u << (key & 31); }
+
+  void reset(uint8_t key) { words[key >> 5] &= ~(1u << (key & 31)); }
+
+  bool test(uint8_t key) const { return (words[key >> 5] >> (key & 31)) & 1u; }
+
+  bool empty() const {
+    uint32_t any = 0;
+    for (int i = 0; i < KEY_BITMAP_WORDS; i++) {
+      any |= words[i];
+    }
+    return any == 0;
+  }
+
+  uint8_t count() const {
+    uint32_t n = 0;
+    for (int i = 0; i < KEY_BITMAP_WORDS; i++) {
+      n += __builtin_popcount(words[i]);
+    }
+    return (uint8_t)n;
+  }
+
+  /// Copies up to max set keys, lowest usage first. Returns the number copied.
+  uint8_t toArray(uint8_t *out, uint8_t max) const;
+
+  /// Calls fn(key) for every set key, lowest usage first.
+  template <typename Fn>
+  void forEach(Fn fn) const {
+    for (int w = 0; w < KEY_BITMAP_WORDS; w++) {
+      uint32_t bits = words[w];
+      while (bits) {
+        fn((uint8_t)((w << 5) + __builtin_ctz(bits)));
+        bits &= bits - 1;
+      }
+    }
+  }
+};
+
+/** @brief Keys and modifier bits that changed between two states. */
+struct KeyStateDiff {
+  KeyBitmap pressed;
+  KeyBitmap released;
+  uint8_t pressedCount;
+  uint8_t releasedCount;
+  uint8_t modifiersPressed;
+  uint8_t modifiersReleased;
+};
+
+/**
+ * @class KeyStateEngine
+ * @brief Tracks the combined key state of up to KEY_STATE_MAX_SOURCES keyboard interfaces.
+ *
+ * Each source (USB interface) reports its own full state; the engine keeps the
+ * union, so a boot interface and an NKRO interface of the same keyboard do not
+ * release each other's keys.
+ */
+class KeyStateEngine {
+public:
+  KeyStateEngine() { clear(); }
+
+  /// Forgets all held keys (e.g. when every keyboard is unplugged).
+  void clear();
+
+  /**
+   * @brief Replaces the state of one source and computes the edges of the union.
+   * @return true if the combined state changed
+   */
+  bool update(uint8_t source, uint8_t modifiers, const KeyBitmap &keys, KeyStateDiff &diff);
+
+  /// Drops the state of one source, e.g. on disconnect.
+  bool releaseSource(uint8_t source, KeyStateDiff &diff);
+
+  const KeyBitmap &keys() const { return _keys; }
+  uint8_t modifiers() const { return _modifiers; }
+
+private:
+  bool recompute(KeyStateDiff &diff);
+
+  KeyBitmap _sourceKeys[KEY_STATE_MAX_SOURCES];
+  uint8_t _sourceModifiers[KEY_STATE_MAX_SOURCES];
+  KeyBitmap _keys;
+  uint8_t _modifiers;
+};
+
+/**
+ * @class KeyReportBuilder
+ * @brief Produces the BLE keyboard reports from a key bitmap.
+ *
+ * With NKRO enabled, usages up to KEY_NKRO_MAX_USAGE and the modifiers go in
+ * the NKRO bitmap report and only keys above that range use the boot report.
+ * Otherwise everything goes in the boot report. Keys that stay held keep
+ * their boot report slot across reports.
+ */
+class KeyReportBuilder {
+public:
+  KeyReportBuilder() { reset(); }
+
+  /// Clears slot assignment (e.g. on a new BLE connection).
+  void reset();
+
+  /**
+   * @brief Builds both reports for the given state.
+   * @param boot Receives the 8-byte boot-compatible report
+   * @param nkro Receives the KEY_NKRO_REPORT_SIZE-byte bitmap report
+   */
+  void build(uint8_t modifiers, const KeyBitmap &keys, bool nkroEnabled,
+             uint8_t boot[KEY_BOOT_REPORT_SIZE], uint8_t nkro[KEY_NKRO_REPORT_SIZE]);
+
+private:
+  void buildBoot(uint8_t modifiers, const KeyBitmap &keys, uint8_t boot[KEY_BOOT_REPORT_SIZE]);
+
+  uint8_t _slots[KEY_BOOT_REPORT_KEYS];
+};
+
+#endif // KEY_STATE_H
@@ -0,0 +1,310 @@
+#include "Keymap.h"
+#include <string.h>
+
+// Action kinds, see the KM_* macros
+#define KIND_KEY 0x02
+#define KIND_MO 0x03
+#define KIND_TG 0x04
+#define KIND_MACRO 0x05
+#define KIND_TAP_HOLD 0x10 // 0x10-0x17 mod-tap, 0x20-0x2F layer-tap
+
+static uint8_t kind_of(uint16_t action) {
+  return (uint8_t)(action >> 8);
+}
+
+static bool is_tap_hold(uint16_t action) {
+  return kind_of(action) >= KIND_TAP_HOLD;
+}
+
+/// What a tap-hold key does once it is held: its modifier key or its layer
+static uint16_t hold_action(uint16_t action) {
+  const uint8_t kind = kind_of(action);
+  return kind < 0x20 ? KM_KEY(KEYMAP_MODIFIER_KEY + (kind & 0x07)) : KM_MO(kind & 0x0F);
+}
+
+KeymapEngine::KeymapEngine(const KeymapDefinition &keymap) : _keymap(keymap), _timers(4) {
+  resetStats();
+  reset(0);
+}
+
+void KeymapEngine::setTiming(uint32_t tappingTermMs, uint32_t comboTermMs) {
+  _tappingTermMs = tappingTermMs;
+  _comboTermMs = comboTermMs;
+}
+
+void KeymapEngine::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void KeymapEngine::reset(uint32_t nowMs) {
+  _timers.reset(nowMs);
+  _physical.clear();
+  _out.clear();
+  _emittedKeys.clear();
+  _emittedModifiers = 0;
+  memset(_pressedAction, 0, sizeof(_pressedAction));
+  memset(_outCount, 0, sizeof(_outCount));
+  memset(_comboOf, NO_COMBO, sizeof(_comboOf));
+  _comboHeld = 0;
+  _tapHoldKey = NO_KEY;
+  _comboKey = NO_KEY;
+  _comboKeyMs = 0;
+
+  _layerToggled = 0;
+  memset(_layerMomentary, 0, sizeof(_layerMomentary));
+  _layerState = 0; // Forces the fold below
+  updateLayers();
+}
+
+void KeymapEngine::updateLayers() {
+  uint8_t state = 1 | _layerToggled;
+  for (uint8_t layer = 1; layer < KEYMAP_LAYERS; layer++) {
+    if (_layerMomentary[layer] > 0) {
+      state |= (uint8_t)(1u << layer);
+    }
+  }
+  if (state == _layerState) {
+    return;
+  }
+  _layerState = state;
+  _stats.layerChanges++;
+
+  // Fold the active layers, topmost first; the base layer has no transparent entries
+  for (int key = 0; key < 256; key++) {
+    uint16_t action = KM_TRNS;
+    for (int layer = KEYMAP_LAYERS - 1; layer >= 0 && action == KM_TRNS; layer--) {
+      if (state & (1u << layer)) {
+        action = _keymap.layers[layer][key];
+      }
+    }
+    _active[key] = action;
+  }
+}
+
+void KeymapEngine::update(uint32_t nowMs, uint8_t modifiers, const KeyBitmap &keys) {
+  _stats.updates++;
+
+  // Deadlines that passed since the last call are decided before the new events
+  tick(nowMs);
+
+  KeyBitmap next = keys;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    if (modifiers & (1u << bit)) {
+      next.set(KEYMAP_MODIFIER_KEY + bit);
+    }
+  }
+
+  KeyBitmap released;
+  KeyBitmap pressed;
+  for (int w = 0; w < KEY_BITMAP_WORDS; w++) {
+    released.words[w] = _physical.words[w] & ~next.words[w];
+    pressed.words[w] = next.words[w] & ~_physical.words[w];
+  }
+  _physical = next;
+
+  // One output per report: intermediate states (e.g. Shift before A) are not emitted
+  _deferEmit = true;
+  released.forEach([this, nowMs](uint8_t key) { handleEvent(key, false, nowMs); });
+
+  // Modifiers go down before the keys of the same report, so Shift+A stays a capital A
+  const int modifierWord = KEYMAP_MODIFIER_KEY >> 5;
+  KeyBitmap modifiersPressed;
+  modifiersPressed.clear();
+  modifiersPressed.words[modifierWord] = pressed.words[modifierWord] & 0xFFu;
+  pressed.words[modifierWord] &= ~0xFFu;
+  modifiersPressed.forEach([this, nowMs](uint8_t key) { handleEvent(key, true, nowMs); });
+  pressed.forEach([this, nowMs](uint8_t key) { handleEvent(key, true, nowMs); });
+  _deferEmit = false;
+  emit();
+}
+
+void KeymapEngine::tick(uint32_t nowMs) {
+  _timers.advance(nowMs, [this](uint8_t id) { onTimer(id); });
+}
+
+void KeymapEngine::onTimer(uint8_t id) {
+  if (id == TIMER_TAP_HOLD && _tapHoldKey != NO_KEY) {
+    resolveHold();
+    emit();
+  } else if (id == TIMER_COMBO && _comboKey != NO_KEY) {
+    flushComboKey();
+  }
+}
+
+void KeymapEngine::handleEvent(uint8_t key, bool pressed, uint32_t nowMs) {
+  _stats.events++;
+
+  if (pressed) {
+    if (_comboKey != NO_KEY) {
+      const uint8_t shared = _keymap.comboKeys[_comboKey] & _keymap.comboKeys[key];
+      if (shared != 0) {
+        const uint8_t combo = (uint8_t)__builtin_ctz(shared);
+        _timers.cancel(TIMER_COMBO);
+        _comboOf[_comboKey] = combo;
+        _comboOf[key] = combo;
+        _comboKey = NO_KEY;
+        _comboHeld |= (uint8_t)(1u << combo);
+        if (_tapHoldKey != NO_KEY) {
+          resolveHold();
+        }
+        actionDown(_keymap.combos[combo].action);
+        _stats.combos++;
+        emit();
+        return;
+      }
+      flushComboKey();
+    }
+
+    // Hold the first key of a combo back until its partner arrives or the term runs out
+    if (_keymap.comboKeys[key] != 0) {
+      _comboKey = key;
+      _comboKeyMs = nowMs;
+      _timers.schedule(TIMER_COMBO, nowMs + _comboTermMs);
+      return;
+    }
+    keyDown(key, nowMs);
+  } else if (key == _comboKey) {
+    flushComboKey(); // Released alone: a plain press and release
+    emitNow();       // The press needs its own report, as for a tap
+    keyUp(key);
+  } else if (_comboOf[key] != NO_COMBO) {
+    // The first of the two keys to come up releases the combo
+    const uint8_t combo = _comboOf[key];
+    _comboOf[key] = NO_COMBO;
+    if (_comboHeld & (1u << combo)) {
+      _comboHeld &= (uint8_t)~(1u << combo);
+      actionUp(_keymap.combos[combo].action);
+    }
+  } else {
+    keyUp(key);
+  }
+  emit();
+}
+
+void KeymapEngine::flushComboKey() {
+  const uint8_t key = _comboKey;
+  _comboKey = NO_KEY;
+  _timers.cancel(TIMER_COMBO);
+  keyDown(key, _comboKeyMs);
+  emit();
+}
+
+void KeymapEngine::keyDown(uint8_t key, uint32_t pressedMs) {
+  // Another key going down decides an undecided tap-hold key as hold
+  if (_tapHoldKey != NO_KEY) {
+    resolveHold();
+  }
+
+  const uint16_t action = _active[key];
+  _pressedAction[key] = action;
+  if (is_tap_hold(action)) {
+    _tapHoldKey = key;
+    _timers.schedule(TIMER_TAP_HOLD, pressedMs + _tappingTermMs);
+    return;
+  }
+  actionDown(action);
+}
+
+void KeymapEngine::keyUp(uint8_t key) {
+  const uint16_t action = _pressedAction[key];
+  _pressedAction[key] = KM_TRNS;
+
+  if (key == _tapHoldKey) {
+    _tapHoldKey = NO_KEY;
+    _timers.cancel(TIMER_TAP_HOLD);
+    const uint8_t tapKey = (uint8_t)(action & 0xFF);
+    outKeyDown(tapKey);
+    emitNow(); // The tap needs its own press report
+    outKeyUp(tapKey);
+    _stats.taps++;
+    return;
+  }
+  actionUp(is_tap_hold(action) ? hold_action(action) : action);
+}
+
+void KeymapEngine::resolveHold() {
+  const uint8_t key = _tapHoldKey;
+  _tapHoldKey = NO_KEY;
+  _timers.cancel(TIMER_TAP_HOLD);
+  actionDown(hold_action(_pressedAction[key]));
+  _stats.holds++;
+}
+
+void KeymapEngine::actionDown(uint16_t action) {
+  const uint8_t arg = (uint8_t)(action & 0xFF);
+  switch (kind_of(action)) {
+  case KIND_KEY:
+    outKeyDown(arg);
+    break;
+  case KIND_MO:
+    _layerMomentary[arg % KEYMAP_LAYERS]++;
+    updateLayers();
+    break;
+  case KIND_TG:
+    _layerToggled ^= (uint8_t)(1u << (arg % KEYMAP_LAYERS));
+    updateLayers();
+    break;
+  case KIND_MACRO:
+    _stats.macros++;
+    if (_macro != nullptr) {
+      _macro(arg);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void KeymapEngine::actionUp(uint16_t action) {
+  const uint8_t arg = (uint8_t)(action & 0xFF);
+  switch (kind_of(action)) {
+  case KIND_KEY:
+    outKeyUp(arg);
+    break;
+  case KIND_MO:
+    if (_layerMomentary[arg % KEYMAP_LAYERS] > 0) {
+      _layerMomentary[arg % KEYMAP_LAYERS]--;
+      updateLayers();
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void KeymapEngine::outKeyDown(uint8_t key) {
+  if (_outCount[key]++ == 0) {
+    _out.set(key);
+  }
+}
+
+void KeymapEngine::outKeyUp(uint8_t key) {
+  if (_outCount[key] > 0 && --_outCount[key] == 0) {
+    _out.reset(key);
+  }
+}
+
+void KeymapEngine::emit() {
+  if (!_deferEmit) {
+    emitNow();
+  }
+}
+
+void KeymapEngine::emitNow() {
+  // Keys 0xE0-0xE7 are the low byte of the last bitmap word
+  const uint32_t modifierMask = 0xFFu;
+  const int modifierWord = KEYMAP_MODIFIER_KEY >> 5;
+  const uint8_t modifiers = (uint8_t)(_out.words[modifierWord] & modifierMask);
+  KeyBitmap keys = _out;
+  keys.words[modifierWord] &= ~modifierMask;
+
+  if (modifiers == _emittedModifiers && memcmp(&keys, &_emittedKeys, sizeof(keys)) == 0) {
+    return;
+  }
+  _emittedModifiers = modifiers;
+  _emittedKeys = keys;
+  _stats.outputs++;
+  if (_output != nullptr) {
+    _output(modifiers, keys);
+  }
+}
@@ -0,0 +1,205 @@
+/**
+ * @file Keymap.h
+ * @brief Layered keymap with momentary/toggle layers, tap-hold keys and combos.
+ *
+ * Keymaps are written in C++ as a list of (layer, key, action) overrides and
+ * compiled with keymapCompile() into one flat 256-entry action table per
+ * layer. Unlisted keys are transparent: they take the action of the next
+ * active layer below, down to the base layer where they map to themselves.
+ * The engine folds the active layers into one table whenever the layer state
+ * changes, so resolving a key in the hot path is a single indexed load.
+ *
+ * Modifiers are handled as the keys 0xE0-0xE7, so they can be remapped too.
+ * A tap-hold key (KM_MT, KM_LT) sends its tap key when released within the
+ * tapping term and becomes its hold action when the term expires or another
+ * key is pressed first. A combo fires when both of its keys go down within
+ * the combo term; until then the first key is held back. Both deadlines run
+ * on a TimerWheel; the caller sleeps until msUntilDue() and calls tick().
+ * A KM_MACRO key only calls the macro callback when it goes down; what the
+ * macro does (typically typing a text) is up to the caller.
+ *
+ * Output states are passed to a callback, at most one per update() apart
+ * from taps, which show up as a press followed by a release. This file has no Arduino or ESP-IDF
+ * dependencies so it can be built on the host.
+ */
+
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include "KeyState.h"
+#include "TimerWheel.h"
+
+#define KEYMAP_LAYERS 4
+#define KEYMAP_MAX_COMBOS 8
+#define KEYMAP_TAPPING_TERM_MS 200
+#define KEYMAP_COMBO_TERM_MS 40
+
+/** @brief First modifier usage; modifier bit n is key 0xE0 + n. */
+#define KEYMAP_MODIFIER_KEY 0xE0
+
+// Actions are 16 bits: the high byte selects the kind, the low byte is a key or layer
+#define KM_TRNS ((uint16_t)0x0000)                                  ///< Use the layer below
+#define KM_NO ((uint16_t)0x0100)                                    ///< Swallow the key
+#define KM_KEY(key) ((uint16_t)(0x0200 | (key)))                    ///< Send another key
+#define KM_MO(layer) ((uint16_t)(0x0300 | (layer)))                 ///< Layer while held
+#define KM_TG(layer) ((uint16_t)(0x0400 | (layer)))                 ///< Toggle a layer
+#define KM_MACRO(index) ((uint16_t)(0x0500 | (index)))              ///< Run a macro on press
+#define KM_MT(modKey, key) ((uint16_t)(0x1000 | (((modKey) & 7) << 8) | (key))) ///< Tap key, hold modifier 0xE0-0xE7
+#define KM_LT(layer, key) ((uint16_t)(0x2000 | ((layer) << 8) | (key)))         ///< Tap key, hold layer
+
+/** @brief One action of a keymap source listing. */
+struct KeymapEntry {
+  uint8_t layer;
+  uint8_t key;
+  uint16_t action;
+};
+
+/** @brief Two keys pressed together produce action (KM_KEY, KM_MO, KM_TG or KM_MACRO). */
+struct KeymapCombo {
+  uint8_t keys[2];
+  uint16_t action;
+};
+
+/** @brief A compiled keymap, normally a constexpr object in flash. */
+struct KeymapDefinition {
+  std::array<std::array<uint16_t, 256>, KEYMAP_LAYERS> layers;
+  std::array<KeymapCombo, KEYMAP_MAX_COMBOS> combos;
+  std::array<uint8_t, 256> comboKeys; ///< Bit n set if the key is part of combo n
+  uint8_t comboCount;
+};
+
+/** @brief The pass-through keymap: every key maps to itself. */
+constexpr KeymapDefinition keymapCompile() {
+  KeymapDefinition def{};
+  for (int key = 0; key < 256; key++) {
+    def.layers[0][key] = KM_KEY(key);
+  }
+  return def;
+}
+
+template <size_t N>
+constexpr KeymapDefinition keymapCompile(const KeymapEntry (&entries)[N]) {
+  KeymapDefinition def{};
+  for (size_t i = 0; i < N; i++) {
+    def.layers[entries[i].layer % KEYMAP_LAYERS][entries[i].key] = entries[i].action;
+  }
+  // The base layer has no layer below; its unlisted keys map to themselves
+  for (int key = 0; key < 256; key++) {
+    if (def.layers[0][key] == KM_TRNS) {
+      def.layers[0][key] = KM_KEY(key);
+    }
+  }
+  return def;
+}
+
+template <size_t N, size_t C>
+constexpr KeymapDefinition keymapCompile(const KeymapEntry (&entries)[N], const KeymapCombo (&combos)[C]) {
+  static_assert(C <= KEYMAP_MAX_COMBOS, "Too many combos");
+  KeymapDefinition def = keymapCompile(entries);
+  for (size_t i = 0; i < C; i++) {
+    def.combos[i] = combos[i];
+    def.comboKeys[combos[i].keys[0]] |= (uint8_t)(1u << i);
+    def.comboKeys[combos[i].keys[1]] |= (uint8_t)(1u << i);
+  }
+  def.comboCount = (uint8_t)C;
+  return def;
+}
+
+typedef struct {
+  uint32_t updates;      ///< Physical states fed in
+  uint32_t events;       ///< Key presses and releases processed
+  uint32_t outputs;      ///< Output states emitted
+  uint32_t taps;         ///< Tap-hold keys resolved as tap
+  uint32_t holds;        ///< Tap-hold keys resolved as hold
+  uint32_t combos;       ///< Combos fired
+  uint32_t layerChanges; ///< Active layer set changes
+  uint32_t macros;       ///< Macro keys pressed
+} keymap_stats_t;
+
+/// Receives every new output state.
+typedef void (*keymap_output_cb_t)(uint8_t modifiers, const KeyBitmap &keys);
+
+/// Called when a KM_MACRO key goes down.
+typedef void (*keymap_macro_cb_t)(uint8_t index);
+
+class KeymapEngine {
+public:
+  explicit KeymapEngine(const KeymapDefinition &keymap);
+
+  void setOutputCallback(keymap_output_cb_t callback) { _output = callback; }
+  void setMacroCallback(keymap_macro_cb_t callback) { _macro = callback; }
+  void setTiming(uint32_t tappingTermMs, uint32_t comboTermMs);
+
+  /// Releases everything without emitting and returns to the base layer.
+  void reset(uint32_t nowMs);
+
+  /// Feeds the full physical state; releases are processed before presses.
+  void update(uint32_t nowMs, uint8_t modifiers, const KeyBitmap &keys);
+
+  /// Fires expired tap-hold and combo deadlines.
+  void tick(uint32_t nowMs);
+
+  /// Milliseconds until tick() has work, UINT32_MAX if nothing is pending.
+  uint32_t msUntilDue(uint32_t nowMs) const { return _timers.msUntilNext(nowMs); }
+
+  /// Bit n set if layer n is active; bit 0 is always set.
+  uint8_t layerState() const { return _layerState; }
+
+  uint8_t modifiers() const { return _emittedModifiers; }
+  const KeyBitmap &keys() const { return _emittedKeys; }
+
+  const keymap_stats_t &stats() const { return _stats; }
+  void resetStats();
+
+private:
+  enum : uint8_t { TIMER_TAP_HOLD, TIMER_COMBO };
+  static const uint8_t NO_KEY = 0xFF; // Reserved usage
+  static const uint8_t NO_COMBO = 0xFF;
+
+  void onTimer(uint8_t id);
+  void handleEvent(uint8_t key, bool pressed, uint32_t nowMs);
+  void flushComboKey();
+  void keyDown(uint8_t key, uint32_t pressedMs);
+  void keyUp(uint8_t key);
+  void resolveHold();
+  void actionDown(uint16_t action);
+  void actionUp(uint16_t action);
+  void outKeyDown(uint8_t key);
+  void outKeyUp(uint8_t key);
+  void updateLayers();
+  void emit();
+  void emitNow();
+
+  const KeymapDefinition &_keymap;
+  keymap_output_cb_t _output = nullptr;
+  keymap_macro_cb_t _macro = nullptr;
+  uint32_t _tappingTermMs = KEYMAP_TAPPING_TERM_MS;
+  uint32_t _comboTermMs = KEYMAP_COMBO_TERM_MS;
+  TimerWheel _timers;
+
+  KeyBitmap _physical;
+  uint16_t _active[256];        ///< Actions of the active layers folded into one table
+  uint16_t _pressedAction[256]; ///< Action each held key resolved to when pressed
+  uint8_t _outCount[256];       ///< Held sources per output key
+  KeyBitmap _out;
+  KeyBitmap _emittedKeys;
+  uint8_t _emittedModifiers;
+  bool _deferEmit = false;      ///< Set while update() processes the events of one report
+
+  uint8_t _layerToggled;
+  uint8_t _layerMomentary[KEYMAP_LAYERS];
+  uint8_t _layerState;
+
+  uint8_t _tapHoldKey;          ///< Undecided tap-hold key or NO_KEY
+  uint8_t _comboKey;            ///< First key of a possible combo, held back, or NO_KEY
+  uint32_t _comboKeyMs;
+  uint8_t _comboOf[256];        ///< Combo a held key belongs to, NO_COMBO if none
+  uint8_t _comboHeld;           ///< Bit n set while combo n is down
+
+  keymap_stats_t _stats;
+};
+
+#endif // KEYMAP_H
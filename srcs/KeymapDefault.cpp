@@ -0,0 +1,36 @@
+#include "KeymapDefault.h"
+
+static constexpr KeymapEntry EXAMPLE_ENTRIES[] = {
+    {KEYMAP_LAYER_BASE, 0x39, KM_MT(0xE0, 0x39)},     // Caps Lock: tap Caps Lock, hold Left Control
+    {KEYMAP_LAYER_BASE, 0x65, KM_MO(KEYMAP_LAYER_FN)}, // Menu: Fn layer while held
+
+    {KEYMAP_LAYER_MAC, 0xE2, KM_KEY(0xE3)}, // Left Alt -> Left GUI
+    {KEYMAP_LAYER_MAC, 0xE3, KM_KEY(0xE2)}, // Left GUI -> Left Alt
+    {KEYMAP_LAYER_MAC, 0xE6, KM_KEY(0xE7)}, // Right Alt -> Right GUI
+    {KEYMAP_LAYER_MAC, 0xE7, KM_KEY(0xE6)}, // Right GUI -> Right Alt
+
+    {KEYMAP_LAYER_FN, 0x0B, KM_KEY(0x50)},            // H -> Left Arrow
+    {KEYMAP_LAYER_FN, 0x0D, KM_KEY(0x51)},            // J -> Down Arrow
+    {KEYMAP_LAYER_FN, 0x0E, KM_KEY(0x52)},            // K -> Up Arrow
+    {KEYMAP_LAYER_FN, 0x0F, KM_KEY(0x4F)},            // L -> Right Arrow
+    {KEYMAP_LAYER_FN, 0x2A, KM_KEY(0x4C)},            // Backspace -> Delete
+    {KEYMAP_LAYER_FN, 0x10, KM_TG(KEYMAP_LAYER_MAC)}, // M: toggle the Mac layer
+    {KEYMAP_LAYER_FN, 0x35, KM_MACRO(0)},             // `: code fence
+};
+
+static constexpr KeymapCombo EXAMPLE_COMBOS[] = {
+    {{0xE1, 0xE5}, KM_KEY(0x39)}, // Left Shift + Right Shift -> Caps Lock
+};
+
+const char *const keymapDefaultMacros[] = {
+    "```\n\n```",
+};
+const uint8_t keymapDefaultMacroCount = sizeof(keymapDefaultMacros) / sizeof(keymapDefaultMacros[0]);
+
+constexpr KeymapDefinition keymapExample = keymapCompile(EXAMPLE_ENTRIES, EXAMPLE_COMBOS);
+
+#if KEYMAP_EXAMPLE
+constexpr KeymapDefinition keymapDefault = keymapExample;
+#else
+constexpr KeymapDefinition keymapDefault = keymapCompile(); // Pass-through
+#endif
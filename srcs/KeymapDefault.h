@@ -0,0 +1,36 @@
+/**
+ * @file KeymapDefault.h
+ * @brief The keymap the bridge starts with.
+ *
+ * By default every key passes through unchanged. Build with
+ * -DKEYMAP_EXAMPLE=1 to start with the example keymap instead:
+ * Base layer: Caps Lock taps as Caps Lock and holds as Left Control, the
+ * Menu key holds the Fn layer, both Shift keys together toggle Caps Lock.
+ * Fn layer: H/J/K/L arrows, Backspace as Delete, M toggles the Mac layer,
+ * ` types a Markdown code fence (macro 0).
+ * Mac layer: Alt and GUI swapped on both sides for macOS hosts.
+ */
+
+#ifndef KEYMAP_DEFAULT_H
+#define KEYMAP_DEFAULT_H
+
+#include "Keymap.h"
+
+#ifndef KEYMAP_EXAMPLE
+#define KEYMAP_EXAMPLE 0
+#endif
+
+#define KEYMAP_LAYER_BASE 0
+#define KEYMAP_LAYER_MAC 1
+#define KEYMAP_LAYER_FN 2
+
+extern const KeymapDefinition keymapDefault;
+
+/// The example keymap, built either way so it can be tested on the host.
+extern const KeymapDefinition keymapExample;
+
+/// Texts of the KM_MACRO actions, by index.
+extern const char *const keymapDefaultMacros[];
+extern const uint8_t keymapDefaultMacroCount;
+
+#endif // KEYMAP_DEFAULT_H
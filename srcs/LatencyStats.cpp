@@ -0,0 +1,166 @@
+#include "LatencyStats.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *const path_names[LATENCY_PATH_COUNT] = {"keyboard", "mouse", "consumer"};
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {"queue", "translate", "total"};
+
+static LatencyHistogram histograms[LATENCY_PATH_COUNT][LATENCY_STAGE_COUNT];
+static std::atomic<bool> reset_pending{true};
+// Queue stages are recorded by the USB input task, deferred notifies by the BLE task
+static portMUX_TYPE record_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Trace of the input currently flowing through the USB input task
+static LatencyTrace trace = {};
+
+void LatencyHistogram::reset() {
+  memset(buckets, 0, sizeof(buckets));
+  count = 0;
+  minUs = UINT32_MAX;
+  maxUs = 0;
+  sumUs = 0;
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  int bucket = us > 1 ? 31 - __builtin_clz(us) : 0;
+  if (bucket >= LATENCY_BUCKETS) {
+    bucket = LATENCY_BUCKETS - 1;
+  }
+  buckets[bucket]++;
+  count++;
+  sumUs += us;
+  if (us < minUs) {
+    minUs = us;
+  }
+  if (us > maxUs) {
+    maxUs = us;
+  }
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t percent) const {
+  if (count == 0) {
+    return 0;
+  }
+  const uint64_t target = ((uint64_t)count * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= target) {
+      return 1u << (i + 1);
+    }
+  }
+  return 1u << LATENCY_BUCKETS;
+}
+
+static uint32_t elapsed_us(int64_t from, int64_t to) {
+  if (to <= from) {
+    return 0;
+  }
+  const int64_t delta = to - from;
+  return delta > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)delta;
+}
+
+void LatencyStats::applyPendingReset() {
+  if (reset_pending.exchange(false, std::memory_order_acquire)) {
+    for (int p = 0; p < LATENCY_PATH_COUNT; p++) {
+      for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        histograms[p][s].reset();
+      }
+    }
+  }
+}
+
+void LatencyStats::beginInput(latency_path_t path, int64_t inputUs) {
+  trace.active = path < LATENCY_PATH_COUNT;
+  trace.translated = false;
+  trace.path = (uint8_t)path;
+  trace.inputUs = inputUs;
+}
+
+void LatencyStats::markTranslated(int64_t nowUs) {
+  if (!trace.active || trace.translated) {
+    return;
+  }
+  trace.translated = true;
+  trace.translatedUs = nowUs;
+
+  portENTER_CRITICAL(&record_lock);
+  applyPendingReset();
+  histograms[trace.path][LATENCY_STAGE_QUEUE].record(elapsed_us(trace.inputUs, nowUs));
+  portEXIT_CRITICAL(&record_lock);
+}
+
+void LatencyStats::markNotify(int64_t nowUs) {
+  recordNotify(trace, nowUs);
+  trace.active = false;
+}
+
+void LatencyStats::endInput() {
+  trace.active = false;
+}
+
+LatencyTrace LatencyStats::currentTrace() {
+  return trace;
+}
+
+void LatencyStats::recordNotify(const LatencyTrace &input, int64_t nowUs) {
+  if (!input.active) {
+    return;
+  }
+  portENTER_CRITICAL(&record_lock);
+  applyPendingReset();
+  LatencyHistogram *stages = histograms[input.path];
+  if (input.translated) {
+    stages[LATENCY_STAGE_TRANSLATE].record(elapsed_us(input.translatedUs, nowUs));
+  }
+  stages[LATENCY_STAGE_TOTAL].record(elapsed_us(input.inputUs, nowUs));
+  portEXIT_CRITICAL(&record_lock);
+}
+
+void LatencyStats::reset() {
+  reset_pending.store(true, std::memory_order_release);
+}
+
+const LatencyHistogram &LatencyStats::histogram(latency_path_t path, latency_stage_t stage) {
+  return histograms[path][stage];
+}
+
+void LatencyStats::dump(LatencyLineWriter writer) {
+  char line[160];
+
+  if (reset_pending.load(std::memory_order_acquire)) {
+    writer("[LATENCY] No samples since reset");
+    return;
+  }
+
+  for (int p = 0; p < LATENCY_PATH_COUNT; p++) {
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+      // Copy first so recording is not held up while we format
+      portENTER_CRITICAL(&record_lock);
+      const LatencyHistogram h = histograms[p][s];
+      portEXIT_CRITICAL(&record_lock);
+      if (h.count == 0) {
+        continue;
+      }
+
+      snprintf(line, sizeof(line),
+               "[LATENCY] %s/%s: n=%u min=%u avg=%u max=%u us, p50<%u p99<%u us",
+               path_names[p], stage_names[s], (unsigned)h.count, (unsigned)h.minUs,
+               (unsigned)(h.sumUs / h.count), (unsigned)h.maxUs,
+               (unsigned)h.percentileUs(50), (unsigned)h.percentileUs(99));
+      writer(line);
+
+      // Non-empty buckets as "<upper bound>:count"
+      int len = snprintf(line, sizeof(line), "[LATENCY]   buckets");
+      for (int i = 0; i < LATENCY_BUCKETS && len < (int)sizeof(line); i++) {
+        if (h.buckets[i] != 0) {
+          len += snprintf(line + len, sizeof(line) - len, " <%lu:%u",
+                          1ul << (i + 1), (unsigned)h.buckets[i]);
+        }
+      }
+      writer(line);
+    }
+  }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file LatencyStats.h
+ * @brief End-to-end input latency histograms (USB IN transfer to BLE notify).
+ *
+ * Each input report is traced through three timestamps:
+ *  - input:      USB HID interface callback entry (usb_input_event_t::timestampUs)
+ *  - translated: the bridge has turned the report into BLE state
+ *  - notify:     right before the BLE characteristic notify
+ *
+ * The stage latencies between them are recorded per input path in log2
+ * bucketed histograms, so a 1 us and a 100 ms outlier both cost one counter.
+ * The trace is a single "current input" owned by the USB input task. Output
+ * that is notified later from another task carries a copy of the trace
+ * (currentTrace()) and records it with recordNotify(); histogram updates are
+ * serialized internally.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host;
+ * callers pass in the timestamps.
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+typedef enum {
+  LATENCY_PATH_KEYBOARD,
+  LATENCY_PATH_MOUSE,
+  LATENCY_PATH_CONSUMER,
+  LATENCY_PATH_COUNT
+} latency_path_t;
+
+typedef enum {
+  LATENCY_STAGE_QUEUE,     ///< Interface callback -> bridge translation (ring + decode)
+  LATENCY_STAGE_TRANSLATE, ///< Bridge translation -> BLE notify
+  LATENCY_STAGE_TOTAL,     ///< Interface callback -> BLE notify
+  LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+/** @brief Bucket i counts samples in [2^i, 2^(i+1)) us; bucket 0 also holds 0 us. */
+#define LATENCY_BUCKETS 24
+
+/** @brief Log2-bucketed latency histogram in microseconds. */
+struct LatencyHistogram {
+  uint32_t buckets[LATENCY_BUCKETS];
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t sumUs;
+
+  void reset();
+  void record(uint32_t us);
+
+  /// Upper bound (exclusive) of the bucket holding the given percentile, 0 if empty.
+  uint32_t percentileUs(uint8_t percent) const;
+};
+
+/** @brief Timestamps of one traced input, carried along when its output is deferred. */
+struct LatencyTrace {
+  bool active;
+  bool translated;
+  uint8_t path;
+  int64_t inputUs;
+  int64_t translatedUs;
+};
+
+/** @brief Receives one formatted line of a dump. */
+typedef void (*LatencyLineWriter)(const char *line);
+
+/**
+ * @class LatencyStats
+ * @brief Collects per-path, per-stage latency histograms.
+ */
+class LatencyStats {
+public:
+  /// Starts tracing one input report on the given path.
+  static void beginInput(latency_path_t path, int64_t inputUs);
+
+  /// Marks bridge translation of the current input; records the queue stage.
+  static void markTranslated(int64_t nowUs);
+
+  /**
+   * @brief Marks the first BLE notify of the current input; records the
+   * translate and total stages. Further notifies for the same input
+   * (e.g. boot and NKRO reports) are ignored.
+   */
+  static void markNotify(int64_t nowUs);
+
+  /// Ends the current trace (inputs that never reach a notify are just dropped).
+  static void endInput();
+
+  /// Snapshot of the current trace, for output that is notified later from another task.
+  static LatencyTrace currentTrace();
+
+  /// Records the translate and total stages of a trace captured with currentTrace().
+  static void recordNotify(const LatencyTrace &trace, int64_t nowUs);
+
+  /// Clears all histograms. Safe from any task; applied on the next recording.
+  static void reset();
+
+  static const LatencyHistogram &histogram(latency_path_t path, latency_stage_t stage);
+
+  /// Writes one summary line per non-empty histogram, plus its bucket counts.
+  static void dump(LatencyLineWriter writer);
+
+private:
+  static void applyPendingReset();
+};
+
+#endif // LATENCY_STATS_H
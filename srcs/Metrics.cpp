@@ -0,0 +1,131 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+// Constant-initialized, so metrics constructed during static initialization find it ready
+static std::atomic<Metric *> metrics_head{nullptr};
+
+Metric::Metric(const char *name, metric_kind_t kind) : _name(name), _kind(kind), _next(nullptr) {
+  Metric *head = metrics_head.load(std::memory_order_relaxed);
+  do {
+    _next = head;
+  } while (!metrics_head.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void MetricHistogram::record(uint32_t value) {
+  int index = 0;
+  if (value != 0) {
+    index = 32 - __builtin_clz(value);
+    if (index >= METRIC_HISTOGRAM_BUCKETS) {
+      index = METRIC_HISTOGRAM_BUCKETS - 1;
+    }
+  }
+  _buckets[index].fetch_add(1, std::memory_order_relaxed);
+  _count.fetch_add(1, std::memory_order_relaxed);
+  _sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void MetricHistogram::reset() {
+  for (int i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++) {
+    _buckets[i].store(0, std::memory_order_relaxed);
+  }
+  _count.store(0, std::memory_order_relaxed);
+  _sum.store(0, std::memory_order_relaxed);
+}
+
+uint32_t MetricHistogram::percentile(uint8_t percent) const {
+  uint32_t total = 0;
+  for (int i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++) {
+    total += bucket(i);
+  }
+  if (total == 0) {
+    return 0;
+  }
+  const uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (int i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++) {
+    seen += bucket(i);
+    if (seen >= rank && bucket(i) != 0) {
+      return 1u << i;
+    }
+  }
+  return 1u << (METRIC_HISTOGRAM_BUCKETS - 1);
+}
+
+const Metric *Metrics::first() {
+  return metrics_head.load(std::memory_order_acquire);
+}
+
+const Metric *Metrics::find(const char *name) {
+  for (const Metric *metric = first(); metric != nullptr; metric = metric->next()) {
+    if (strcmp(metric->name(), name) == 0) {
+      return metric;
+    }
+  }
+  return nullptr;
+}
+
+void Metrics::reset() {
+  // The registry only hands out const pointers; reset is the one writer besides the owners
+  for (Metric *metric = metrics_head.load(std::memory_order_acquire); metric != nullptr;
+       metric = const_cast<Metric *>(metric->next())) {
+    if (metric->kind() == METRIC_COUNTER) {
+      static_cast<MetricCounter *>(metric)->reset();
+    } else if (metric->kind() == METRIC_HISTOGRAM) {
+      static_cast<MetricHistogram *>(metric)->reset();
+    }
+  }
+}
+
+static void format_metric(const Metric *metric, char *line, size_t size) {
+  switch (metric->kind()) {
+  case METRIC_COUNTER:
+    snprintf(line, size, "[METRIC] %-28s %u", metric->name(), (unsigned)static_cast<const MetricCounter *>(metric)->value());
+    break;
+  case METRIC_GAUGE:
+    snprintf(line, size, "[METRIC] %-28s = %d", metric->name(), (int)static_cast<const MetricGauge *>(metric)->value());
+    break;
+  case METRIC_HISTOGRAM: {
+    const MetricHistogram *histogram = static_cast<const MetricHistogram *>(metric);
+    const uint32_t count = histogram->count();
+    snprintf(line, size, "[METRIC] %-28s n=%u avg=%u p50<%u p99<%u", metric->name(), (unsigned)count,
+             count > 0 ? (unsigned)(histogram->sum() / count) : 0u, (unsigned)histogram->percentile(50),
+             (unsigned)histogram->percentile(99));
+    break;
+  }
+  }
+}
+
+void Metrics::dump(MetricLineWriter writer, const char *prefix) {
+  const size_t prefixLength = prefix != nullptr ? strlen(prefix) : 0;
+  const Metric *sorted[METRICS_MAX_SORTED];
+  size_t count = 0;
+  char line[128];
+
+  // Insertion sort by name; the registry is small and this runs on demand only
+  for (const Metric *metric = first(); metric != nullptr; metric = metric->next()) {
+    if (prefixLength != 0 && strncmp(metric->name(), prefix, prefixLength) != 0) {
+      continue;
+    }
+    if (count == METRICS_MAX_SORTED) {
+      format_metric(metric, line, sizeof(line));
+      writer(line);
+      continue;
+    }
+    size_t i = count++;
+    while (i > 0 && strcmp(sorted[i - 1]->name(), metric->name()) > 0) {
+      sorted[i] = sorted[i - 1];
+      i--;
+    }
+    sorted[i] = metric;
+  }
+
+  if (count == 0) {
+    writer("[METRIC] No metrics");
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    format_metric(sorted[i], line, sizeof(line));
+    writer(line);
+  }
+}
@@ -0,0 +1,123 @@
+/**
+ * @file Metrics.h
+ * @brief Static registry of runtime counters, gauges and histograms.
+ *
+ * Modules declare their metrics as globals (or function statics):
+ *
+ *   static MetricCounter transferErrors("usb.transfer_errors");
+ *   transferErrors.inc();
+ *
+ * The constructor links the metric into a lock-free list, so nothing is
+ * allocated and registration works during static initialization in any
+ * order. Updates are single relaxed atomic operations on a 32-bit word, with
+ * no locks and no interrupt masking, so they are safe on every hot path and
+ * from any task. A histogram record is one log2 bucket increment plus the
+ * count and the sum. Readers see each word consistently but not a snapshot
+ * across words.
+ *
+ * Metrics::dump() prints everything sorted by name. Metrics::reset() zeroes
+ * counters and histograms; gauges hold current state and are left alone.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Bucket i counts values in [2^(i-1), 2^i); bucket 0 holds 0, the last one everything above. */
+#define METRIC_HISTOGRAM_BUCKETS 20
+
+/** @brief Metrics dump() can sort; more are printed unsorted after them. */
+#define METRICS_MAX_SORTED 96
+
+typedef enum : uint8_t {
+  METRIC_COUNTER,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM,
+} metric_kind_t;
+
+typedef void (*MetricLineWriter)(const char *line);
+
+class Metric {
+public:
+  const char *name() const { return _name; }
+  metric_kind_t kind() const { return _kind; }
+  const Metric *next() const { return _next; }
+
+  Metric(const Metric &) = delete;
+  Metric &operator=(const Metric &) = delete;
+
+protected:
+  Metric(const char *name, metric_kind_t kind);
+
+private:
+  const char *_name;
+  metric_kind_t _kind;
+  Metric *_next;
+};
+
+/** @brief Monotonic event count (wraps at 2^32). */
+class MetricCounter : public Metric {
+public:
+  explicit MetricCounter(const char *name) : Metric(name, METRIC_COUNTER) {}
+
+  void inc(uint32_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t value() const { return _value.load(std::memory_order_relaxed); }
+  void reset() { _value.store(0, std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint32_t> _value{0};
+};
+
+/** @brief Current value of something (interval, level, depth). */
+class MetricGauge : public Metric {
+public:
+  explicit MetricGauge(const char *name) : Metric(name, METRIC_GAUGE) {}
+
+  void set(int32_t value) { _value.store(value, std::memory_order_relaxed); }
+  int32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<int32_t> _value{0};
+};
+
+/** @brief Log2-bucketed distribution, e.g. of durations in microseconds. */
+class MetricHistogram : public Metric {
+public:
+  explicit MetricHistogram(const char *name) : Metric(name, METRIC_HISTOGRAM) {}
+
+  void record(uint32_t value);
+  void reset();
+
+  uint32_t count() const { return _count.load(std::memory_order_relaxed); }
+  uint32_t sum() const { return _sum.load(std::memory_order_relaxed); } ///< Wraps at 2^32
+  uint32_t bucket(int index) const { return _buckets[index].load(std::memory_order_relaxed); }
+
+  /// Upper bound (exclusive) of the bucket holding the percentile, 0 if empty.
+  uint32_t percentile(uint8_t percent) const;
+
+private:
+  std::atomic<uint32_t> _buckets[METRIC_HISTOGRAM_BUCKETS] = {};
+  std::atomic<uint32_t> _count{0};
+  std::atomic<uint32_t> _sum{0};
+};
+
+namespace Metrics {
+/// First registered metric (most recent first), nullptr if none.
+const Metric *first();
+
+/// Looks a metric up by its exact name.
+const Metric *find(const char *name);
+
+/// Zeroes counters and histograms.
+void reset();
+
+/// Writes one "[METRIC]" line per metric whose name starts with prefix (nullptr: all).
+void dump(MetricLineWriter writer, const char *prefix = nullptr);
+} // namespace Metrics
+
+#endif // METRICS_H
@@ -0,0 +1,280 @@
+#include "NotifyScheduler.h"
+#include <string.h>
+
+template <int W, int DEPTH, uint32_t VALUE_WORDS>
+void NotifyScheduler::EdgeQueue<W, DEPTH, VALUE_WORDS>::reset() {
+  memset(last, 0, sizeof(last));
+  count = 0;
+}
+
+template <int W, int DEPTH, uint32_t VALUE_WORDS>
+int NotifyScheduler::EdgeQueue<W, DEPTH, VALUE_WORDS>::push(const uint32_t *state, const LatencyTrace &trace) {
+  const uint32_t *tail = count > 0 ? states[count - 1] : last;
+  if (memcmp(tail, state, sizeof(uint32_t) * W) == 0) {
+    return 0;
+  }
+
+  if (count > 0) {
+    // Merge into the tail unless a bit that changed to reach it changes back
+    const uint32_t *before = count > 1 ? states[count - 2] : last;
+    uint32_t toggledTwice = 0;
+    for (int w = 0; w < W; w++) {
+      if ((VALUE_WORDS >> w) & 1u) {
+        // A value changed on the way to the tail would be skipped entirely
+        toggledTwice |= (before[w] != tail[w] && tail[w] != state[w]) ? 1u : 0u;
+      } else {
+        toggledTwice |= (before[w] ^ tail[w]) & (tail[w] ^ state[w]);
+      }
+    }
+    if (toggledTwice == 0) {
+      // The oldest input of a merged entry keeps its trace
+      memcpy(states[count - 1], state, sizeof(uint32_t) * W);
+      return 1;
+    }
+  }
+  if (count == DEPTH) {
+    return 3;
+  }
+
+  memcpy(states[count], state, sizeof(uint32_t) * W);
+  traces[count] = trace;
+  count++;
+  return 2;
+}
+
+template <int W, int DEPTH, uint32_t VALUE_WORDS>
+void NotifyScheduler::EdgeQueue<W, DEPTH, VALUE_WORDS>::pop(uint32_t *state, LatencyTrace &trace) {
+  memcpy(state, states[0], sizeof(uint32_t) * W);
+  memcpy(last, states[0], sizeof(uint32_t) * W);
+  trace = traces[0];
+  count--;
+  memmove(states[0], states[1], sizeof(states[0]) * count);
+  memmove(&traces[0], &traces[1], sizeof(traces[0]) * count);
+}
+
+void NotifyScheduler::reset() {
+  _keyboard.reset();
+  _media.reset();
+  _mouseCount = 0;
+  _liveModifiers = 0;
+  _liveKeys.clear();
+  _injectState = inject_step_t{};
+  _inject.clear();
+  _syncPending = false;
+  _lastFlushUs = 0;
+  _flushed = false;
+}
+
+void NotifyScheduler::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void NotifyScheduler::setConnectionInterval(uint32_t intervalUs) {
+  _intervalUs = intervalUs > 0 ? intervalUs : NOTIFY_DEFAULT_INTERVAL_US;
+}
+
+bool NotifyScheduler::countPush(notify_report_t type, int result) {
+  if (result == 3) {
+    // Not accepted; the caller pushes the same state again
+    _stats.refused[type]++;
+    return false;
+  }
+  _stats.queued[type]++;
+  if (result == 0 || result == 1) {
+    _stats.coalesced[type]++;
+  }
+  return true;
+}
+
+bool NotifyScheduler::pushKeyboard(uint8_t modifiers, const KeyBitmap &keys,
+                                   const LatencyTrace &trace) {
+  uint32_t state[KEYBOARD_WORDS];
+  memcpy(state, keys.words, sizeof(keys.words));
+  state[KEY_BITMAP_WORDS] = modifiers;
+  return countPush(NOTIFY_KEYBOARD, _keyboard.push(state, trace));
+}
+
+void NotifyScheduler::keyboardSent(uint8_t &modifiers, KeyBitmap &keys) const {
+  memcpy(keys.words, _keyboard.last, sizeof(keys.words));
+  modifiers = (uint8_t)_keyboard.last[KEY_BITMAP_WORDS];
+}
+
+bool NotifyScheduler::takeKeyboard(uint8_t &modifiers, KeyBitmap &keys) {
+  if (_keyboard.count == 0) {
+    return false;
+  }
+  uint32_t state[KEYBOARD_WORDS];
+  LatencyTrace trace;
+  _keyboard.pop(state, trace);
+  memcpy(keys.words, state, sizeof(keys.words));
+  modifiers = (uint8_t)state[KEY_BITMAP_WORDS];
+  return true;
+}
+
+bool NotifyScheduler::pushMedia(const ConsumerReport &consumer, const LatencyTrace &trace) {
+  uint32_t state[MEDIA_WORDS] = {consumer.media};
+  for (int i = 0; i < CONSUMER_ARRAY_SLOTS; i++) {
+    state[1 + i / 2] |= (uint32_t)consumer.array[i] << ((i & 1) * 16);
+  }
+  return countPush(NOTIFY_MEDIA, _media.push(state, trace));
+}
+
+bool NotifyScheduler::pushMouse(uint8_t buttons, int16_t x, int16_t y, int16_t wheel,
+                                const LatencyTrace &trace) {
+  // Motion is summed while the buttons stay the same; a button change starts a new entry
+  if (_mouseCount > 0) {
+    MouseEntry &tail = _mouse[_mouseCount - 1];
+    if (tail.buttons == buttons) {
+      tail.x += x;
+      tail.y += y;
+      tail.wheel += wheel;
+      _stats.queued[NOTIFY_MOUSE]++;
+      _stats.coalesced[NOTIFY_MOUSE]++;
+      return true;
+    }
+    if (_mouseCount == NOTIFY_MOUSE_QUEUE_DEPTH) {
+      _stats.refused[NOTIFY_MOUSE]++;
+      return false;
+    }
+  }
+
+  MouseEntry &entry = _mouse[_mouseCount++];
+  entry.buttons = buttons;
+  entry.x = x;
+  entry.y = y;
+  entry.wheel = wheel;
+  entry.trace = trace;
+  _stats.queued[NOTIFY_MOUSE]++;
+  return true;
+}
+
+void NotifyScheduler::resync(uint8_t modifiers, const KeyBitmap &keys, const ConsumerReport &consumer,
+                             uint8_t buttons) {
+  _liveKeys = keys;
+  _liveModifiers = modifiers;
+  memcpy(_keyboard.last, keys.words, sizeof(keys.words));
+  _keyboard.last[KEY_BITMAP_WORDS] = modifiers;
+  memset(_media.last, 0, sizeof(_media.last));
+  _media.last[0] = consumer.media;
+  for (int i = 0; i < CONSUMER_ARRAY_SLOTS; i++) {
+    _media.last[1 + i / 2] |= (uint32_t)consumer.array[i] << ((i & 1) * 16);
+  }
+  _syncConsumer = consumer;
+  _syncButtons = buttons;
+  _syncPending = true;
+}
+
+void NotifyScheduler::fillKeyboard(NotifyItem &item) const {
+  item.type = NOTIFY_KEYBOARD;
+  item.keys = _liveKeys;
+  item.modifiers = _liveModifiers | _injectState.modifiers;
+  for (uint8_t i = 0; i < _injectState.count; i++) {
+    item.keys.set(_injectState.keys[i]);
+  }
+}
+
+bool NotifyScheduler::pending() const {
+  return _keyboard.count > 0 || _media.count > 0 || _mouseCount > 0 || !_inject.empty() || _syncPending;
+}
+
+uint32_t NotifyScheduler::usUntilDue(int64_t nowUs) const {
+  if (!pending()) {
+    return UINT32_MAX;
+  }
+  if (!_flushed) {
+    return 0;
+  }
+  const int64_t due = _lastFlushUs + _intervalUs;
+  return nowUs >= due ? 0 : (uint32_t)(due - nowUs);
+}
+
+static int8_t take_step(int32_t &remaining) {
+  const int32_t step = remaining > 127 ? 127 : (remaining < -127 ? -127 : remaining);
+  remaining -= step;
+  return (int8_t)step;
+}
+
+uint8_t NotifyScheduler::collect(int64_t nowUs, NotifyItem *out, uint8_t max) {
+  if (usUntilDue(nowUs) != 0) {
+    return 0;
+  }
+  if (max > NOTIFY_MAX_ITEMS_PER_EVENT) {
+    max = NOTIFY_MAX_ITEMS_PER_EVENT;
+  }
+
+  uint8_t n = 0;
+
+  // The sync goes out whole and first; the caller forces it past its change filter
+  if (_syncPending && max >= 3) {
+    NotifyItem &keyboard = out[n++];
+    keyboard.trace = LatencyTrace{};
+    fillKeyboard(keyboard);
+    NotifyItem &media = out[n++];
+    media.type = NOTIFY_MEDIA;
+    media.trace = LatencyTrace{};
+    media.consumer = _syncConsumer;
+    NotifyItem &mouse = out[n++];
+    mouse.type = NOTIFY_MOUSE;
+    mouse.trace = LatencyTrace{};
+    mouse.buttons = _syncButtons;
+    mouse.x = mouse.y = mouse.wheel = 0;
+    _syncPending = false;
+    _stats.resyncs++;
+  }
+
+  while (n < max && _keyboard.count > 0) {
+    uint32_t state[KEYBOARD_WORDS];
+    NotifyItem &item = out[n++];
+    _keyboard.pop(state, item.trace);
+    memcpy(_liveKeys.words, state, sizeof(_liveKeys.words));
+    _liveModifiers = (uint8_t)state[KEY_BITMAP_WORDS];
+    fillKeyboard(item);
+    _stats.sent[NOTIFY_KEYBOARD]++;
+  }
+
+  // Injected states are never merged; each one has to reach the host
+  for (uint8_t i = 0; i < NOTIFY_INJECT_STEPS_PER_EVENT && n < max && _inject.pop(_injectState); i++) {
+    NotifyItem &item = out[n++];
+    item.trace = LatencyTrace{};
+    fillKeyboard(item);
+    _stats.injected++;
+  }
+
+  while (n < max && _media.count > 0) {
+    uint32_t state[MEDIA_WORDS];
+    NotifyItem &item = out[n++];
+    item.type = NOTIFY_MEDIA;
+    _media.pop(state, item.trace);
+    item.consumer.media = (uint16_t)state[0];
+    for (int i = 0; i < CONSUMER_ARRAY_SLOTS; i++) {
+      item.consumer.array[i] = (uint16_t)(state[1 + i / 2] >> ((i & 1) * 16));
+    }
+    _stats.sent[NOTIFY_MEDIA]++;
+  }
+
+  // At most one mouse report per event; a large accumulator drains over several events
+  if (n < max && _mouseCount > 0) {
+    MouseEntry &head = _mouse[0];
+    NotifyItem &item = out[n++];
+    item.type = NOTIFY_MOUSE;
+    item.trace = head.trace;
+    item.buttons = head.buttons;
+    item.x = take_step(head.x);
+    item.y = take_step(head.y);
+    item.wheel = take_step(head.wheel);
+    head.trace.active = false;
+    _stats.sent[NOTIFY_MOUSE]++;
+
+    if (head.x == 0 && head.y == 0 && head.wheel == 0) {
+      _mouseCount--;
+      memmove(&_mouse[0], &_mouse[1], sizeof(_mouse[0]) * _mouseCount);
+    }
+  }
+
+  if (n > 0) {
+    _stats.flushes++;
+    _lastFlushUs = nowUs;
+    _flushed = true;
+  }
+  return n;
+}
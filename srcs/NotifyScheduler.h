@@ -0,0 +1,210 @@
+/**
+ * @file NotifyScheduler.h
+ * @brief Connection-interval aware coalescing of BLE HID input reports.
+ *
+ * A BLE link only moves data once per connection event (7.5-30 ms apart on
+ * typical hosts), so notifying every USB report just queues stale states in
+ * the stack. The scheduler instead keeps pending state per report type and
+ * hands out one batch per connection interval, keyboard first, then media,
+ * then mouse.
+ *
+ * Keyboard and media states are merged only when no bit would change twice:
+ * with S the state before the pending one P, a new state N replaces P if
+ * (S ^ P) & (P ^ N) == 0. A press and release of the same key inside one
+ * interval are therefore kept as two reports instead of vanishing. The
+ * consumer array slots hold usage numbers rather than bits, so a pending
+ * state is only merged over them when the slots did not change to reach it.
+ * Mouse
+ * motion with unchanged buttons is summed and sent in +-127 steps until the
+ * accumulator is drained, so the last delta always goes out.
+ *
+ * A queue never merges across an edge. When a state needs a new entry and
+ * the queue is full, the push is refused and the caller waits for collect()
+ * to make room. Input is then held back upstream instead of being lost.
+ *
+ * When a host subscribes, resync() sends the full keyboard, consumer
+ * and mouse button state ahead of everything else. Keyboard states captured
+ * while the link was down (see ReplayBuffer.h) are then pushed like live
+ * ones, so they go out in order with the same edge-preserving merge. The
+ * keyboard queue is deep enough to take a full replay buffer.
+ *
+ * Injected text (see TextInjector.h) is a queue of keyboard states that must
+ * all reach the host. Up to NOTIFY_INJECT_STEPS_PER_EVENT of them go out per
+ * event after any live keyboard reports, never merged. Live and injected keys
+ * are sent as their union, so typing continues while text is injected.
+ *
+ * The scheduler is plain state: the caller serializes access and decides
+ * when to call collect(). This file has no Arduino or ESP-IDF dependencies
+ * so it can be built on the host.
+ */
+
+#ifndef NOTIFY_SCHEDULER_H
+#define NOTIFY_SCHEDULER_H
+
+#include <stdint.h>
+#include "ConsumerControl.h"
+#include "KeyState.h"
+#include "LatencyStats.h"
+#include "TextInjector.h"
+
+/** @brief Report types in priority order. */
+typedef enum {
+  NOTIFY_KEYBOARD,
+  NOTIFY_MEDIA,
+  NOTIFY_MOUSE,
+  NOTIFY_REPORT_TYPES
+} notify_report_t;
+
+#define NOTIFY_KEYBOARD_QUEUE_DEPTH 32
+#define NOTIFY_MEDIA_QUEUE_DEPTH 4
+#define NOTIFY_MOUSE_QUEUE_DEPTH 4
+
+/** @brief Injected keyboard states sent per connection event. */
+#define NOTIFY_INJECT_STEPS_PER_EVENT 2
+
+/** @brief Items handed to the BLE stack per connection event. */
+#define NOTIFY_MAX_ITEMS_PER_EVENT 4
+
+/** @brief Interval assumed until the connection parameters are known (7.5 ms). */
+#define NOTIFY_DEFAULT_INTERVAL_US 7500
+
+/** @brief One report to notify. Only the fields of its type are valid. */
+struct NotifyItem {
+  uint8_t type; ///< notify_report_t
+  LatencyTrace trace;
+
+  // NOTIFY_KEYBOARD
+  uint8_t modifiers;
+  KeyBitmap keys;
+
+  // NOTIFY_MEDIA
+  ConsumerReport consumer;
+
+  // NOTIFY_MOUSE
+  uint8_t buttons;
+  int8_t x;
+  int8_t y;
+  int8_t wheel;
+};
+
+/** @brief Scheduler counters, per report type where it applies. */
+typedef struct {
+  uint32_t queued[NOTIFY_REPORT_TYPES];     ///< Reports accepted from the bridge
+  uint32_t coalesced[NOTIFY_REPORT_TYPES];  ///< Reports merged into a pending one
+  uint32_t sent[NOTIFY_REPORT_TYPES];       ///< Reports handed out by collect()
+  uint32_t refused[NOTIFY_REPORT_TYPES];    ///< Pushes refused because the queue was full
+  uint32_t flushes;                         ///< collect() calls that returned reports
+  uint32_t injected;                        ///< Injected keyboard states sent
+  uint32_t resyncs;                         ///< Full state syncs sent
+} notify_stats_t;
+
+class NotifyScheduler {
+public:
+  NotifyScheduler() {
+    resetStats();
+    reset();
+  }
+
+  /// Drops everything pending and forgets the last sent states (new connection).
+  void reset();
+
+  /// Sets the negotiated connection interval in microseconds.
+  void setConnectionInterval(uint32_t intervalUs);
+  uint32_t connectionInterval() const { return _intervalUs; }
+
+  /// Queues a state. Returns false if the queue is full; push it again after collect().
+  bool pushKeyboard(uint8_t modifiers, const KeyBitmap &keys, const LatencyTrace &trace);
+  bool pushMedia(const ConsumerReport &consumer, const LatencyTrace &trace);
+  bool pushMouse(uint8_t buttons, int16_t x, int16_t y, int16_t wheel, const LatencyTrace &trace);
+
+  /// Queues compiled text steps, all or none. Returns false if they do not fit.
+  bool pushInject(const inject_step_t *steps, size_t count) { return _inject.push(steps, count); }
+  size_t injectSpace() const { return _inject.space(); }
+  bool injecting() const { return !_inject.empty(); }
+
+  /**
+   * @brief Sends the full state to a host that just subscribed.
+   * Goes out as the first batch, before anything pending. Keyboard and
+   * media states pushed afterwards are merged against this state.
+   */
+  void resync(uint8_t modifiers, const KeyBitmap &keys, const ConsumerReport &consumer,
+              uint8_t buttons);
+
+  bool pending() const;
+
+  /// The keyboard state last handed out, which the pending ones follow.
+  void keyboardSent(uint8_t &modifiers, KeyBitmap &keys) const;
+
+  /// Takes the oldest keyboard state not yet handed out, e.g. to keep it across a dropped link.
+  bool takeKeyboard(uint8_t &modifiers, KeyBitmap &keys);
+
+  /**
+   * @brief Microseconds until the next batch may go out.
+   * @return 0 if a batch is due now, UINT32_MAX if nothing is pending
+   */
+  uint32_t usUntilDue(int64_t nowUs) const;
+
+  /**
+   * @brief Takes the batch for this connection event, highest priority first.
+   * Returns 0 without touching state when no batch is due yet.
+   */
+  uint8_t collect(int64_t nowUs, NotifyItem *out, uint8_t max);
+
+  const notify_stats_t &stats() const { return _stats; }
+  void resetStats();
+
+private:
+  // Bit state with edge-preserving merge; one extra word holds the modifiers
+  static const int KEYBOARD_WORDS = KEY_BITMAP_WORDS + 1;
+  // Media bitmap, then the array slots two per word
+  static const int MEDIA_WORDS = 1 + (CONSUMER_ARRAY_SLOTS + 1) / 2;
+  static const uint32_t MEDIA_VALUE_WORDS = ((1u << MEDIA_WORDS) - 1) & ~1u;
+
+  /// VALUE_WORDS is a mask of words holding values instead of bits; they never merge over a change
+  template <int W, int DEPTH, uint32_t VALUE_WORDS = 0>
+  struct EdgeQueue {
+    uint32_t last[W]; ///< State before the first pending entry
+    uint32_t states[DEPTH][W];
+    LatencyTrace traces[DEPTH];
+    uint8_t count;
+
+    void reset();
+    /// Returns 0 if dropped (no change), 1 if merged, 2 if appended, 3 if refused (full).
+    int push(const uint32_t *state, const LatencyTrace &trace);
+    void pop(uint32_t *state, LatencyTrace &trace);
+  };
+
+  struct MouseEntry {
+    uint8_t buttons;
+    int32_t x;
+    int32_t y;
+    int32_t wheel;
+    LatencyTrace trace;
+  };
+
+  bool countPush(notify_report_t type, int result);
+  void fillKeyboard(NotifyItem &item) const;
+
+  EdgeQueue<KEYBOARD_WORDS, NOTIFY_KEYBOARD_QUEUE_DEPTH> _keyboard;
+  EdgeQueue<MEDIA_WORDS, NOTIFY_MEDIA_QUEUE_DEPTH, MEDIA_VALUE_WORDS> _media;
+  MouseEntry _mouse[NOTIFY_MOUSE_QUEUE_DEPTH];
+  uint8_t _mouseCount;
+
+  // Last live keyboard state sent and the current injected state; reports carry their union
+  uint8_t _liveModifiers;
+  KeyBitmap _liveKeys;
+  inject_step_t _injectState;
+  TextInjectQueue _inject;
+
+  // Full state owed to a resynced host
+  bool _syncPending;
+  ConsumerReport _syncConsumer;
+  uint8_t _syncButtons;
+
+  uint32_t _intervalUs = NOTIFY_DEFAULT_INTERVAL_US;
+  int64_t _lastFlushUs;
+  bool _flushed;
+  notify_stats_t _stats;
+};
+
+#endif // NOTIFY_SCHEDULER_H
@@ -0,0 +1,64 @@
+#include "PointerIntegrator.h"
+#include <string.h>
+
+static const int64_t US_PER_S = 1000000;
+static const int64_t PIXEL = (int64_t)65536 * US_PER_S; // One pixel in accumulator units
+
+uint32_t PointerIntegrator::speedQ16(int16_t deflection, const uint16_t *curve) {
+  const int32_t magnitude = deflection < 0 ? -(int32_t)deflection : deflection;
+  const int32_t step = 32768 / (POINTER_CURVE_POINTS - 1);
+  const int32_t index = magnitude / step;
+  if (index >= POINTER_CURVE_POINTS - 1) {
+    return (uint32_t)curve[POINTER_CURVE_POINTS - 1] << 16;
+  }
+  // Linear between the two curve points, with the fraction kept in Q16
+  const int32_t fraction = (magnitude % step) * 65536 / step;
+  const int32_t low = curve[index];
+  const int32_t high = curve[index + 1];
+  return (uint32_t)(((int64_t)low << 16) + (int64_t)(high - low) * fraction);
+}
+
+int8_t PointerAxis::update(int16_t deflection, uint32_t elapsedUs, const uint16_t *curve) {
+  const int64_t speed = PointerIntegrator::speedQ16(deflection, curve);
+  _remainder += (deflection < 0 ? -speed : speed) * (int64_t)elapsedUs;
+
+  int64_t pixels = _remainder / PIXEL; // Toward zero: the fraction stays, whichever the direction
+  if (pixels > POINTER_MAX_REPORT) {
+    pixels = POINTER_MAX_REPORT;
+  } else if (pixels < -POINTER_MAX_REPORT) {
+    pixels = -POINTER_MAX_REPORT;
+  }
+  _remainder -= pixels * PIXEL;
+
+  // Carry at most one report's worth, so a stalled report does not turn into a long glide
+  const int64_t limit = (int64_t)POINTER_MAX_REPORT * PIXEL;
+  if (_remainder > limit) {
+    _remainder = limit;
+  } else if (_remainder < -limit) {
+    _remainder = -limit;
+  }
+  return (int8_t)pixels;
+}
+
+int32_t PointerAxis::remainderQ16() const {
+  return (int32_t)(_remainder / US_PER_S);
+}
+
+PointerIntegrator::PointerIntegrator() {
+  const uint16_t curve[POINTER_CURVE_POINTS] = POINTER_CURVE_DEFAULT;
+  setCurve(curve);
+}
+
+void PointerIntegrator::setCurve(const uint16_t curve[POINTER_CURVE_POINTS]) {
+  memcpy(_curve, curve, sizeof(_curve));
+}
+
+void PointerIntegrator::update(int16_t x, int16_t y, uint32_t elapsedUs, int8_t &dx, int8_t &dy) {
+  dx = _x.update(x, elapsedUs, _curve);
+  dy = _y.update(y, elapsedUs, _curve);
+}
+
+void PointerIntegrator::reset() {
+  _x.reset();
+  _y.reset();
+}
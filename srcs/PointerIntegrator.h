@@ -0,0 +1,68 @@
+/**
+ * @file PointerIntegrator.h
+ * @brief Turns joystick deflection into mouse motion from real elapsed time.
+ *
+ * A response curve (lookup table, linear in between) maps deflection to a
+ * speed in pixels per second, kept as Q16 so slow speeds keep their
+ * fraction. Each update adds speed x elapsed microseconds to an exact
+ * integer accumulator (Q16 pixels scaled by 10^6) and returns the whole
+ * pixels. The rest stays for the next update. The same deflection held
+ * for the same time therefore moves the same distance, however the
+ * updates are spaced. A small deflection moves slowly instead of
+ * truncating to nothing. Reports are limited to the HID range of -127..127;
+ * motion beyond that is carried into the next report, up to one report's
+ * worth.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef POINTER_INTEGRATOR_H
+#define POINTER_INTEGRATOR_H
+
+#include <stdint.h>
+
+#define POINTER_CURVE_POINTS 17 // Deflection 0, 2048, ... 32768
+#define POINTER_MAX_REPORT 127
+
+/// Default curve: quadratic up to 1200 px/s at full deflection
+#define POINTER_CURVE_DEFAULT {0, 5, 19, 42, 75, 117, 169, 230, 300, 380, 469, 567, 675, 792, 919, 1055, 1200}
+
+class PointerAxis {
+public:
+  /**
+   * @param deflection -32767..32767 (deadzone already applied)
+   * @param elapsedUs Time since the previous update
+   * @return Whole pixels to report, -127..127
+   */
+  int8_t update(int16_t deflection, uint32_t elapsedUs, const uint16_t *curve);
+
+  /// Drops the sub-pixel remainder (e.g. when the pointer is switched off).
+  void reset() { _remainder = 0; }
+
+  /// Motion owed but not yet reported, in 1/65536 pixels.
+  int32_t remainderQ16() const;
+
+private:
+  int64_t _remainder = 0; ///< Q16 pixels x 10^6
+};
+
+class PointerIntegrator {
+public:
+  PointerIntegrator();
+
+  /// Replaces the response curve: speed in pixels per second at each curve point.
+  void setCurve(const uint16_t curve[POINTER_CURVE_POINTS]);
+
+  /// Speed in Q16 pixels per second for a deflection, interpolated between curve points.
+  static uint32_t speedQ16(int16_t deflection, const uint16_t *curve);
+
+  void update(int16_t x, int16_t y, uint32_t elapsedUs, int8_t &dx, int8_t &dy);
+  void reset();
+
+private:
+  uint16_t _curve[POINTER_CURVE_POINTS];
+  PointerAxis _x;
+  PointerAxis _y;
+};
+
+#endif // POINTER_INTEGRATOR_H
@@ -0,0 +1,100 @@
+#include "Profiler.h"
+#include <esp_heap_caps.h>
+
+// Sampled on the profiler task; profilerDump() copies it under the lock before formatting
+static TaskProfiler profiler;
+static QueueHandle_t queues[PROFILER_MAX_QUEUES];
+static size_t queueCount = 0;
+static portMUX_TYPE profilerLock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t profilerTaskHandle = nullptr;
+
+// Room for every task the firmware creates plus the ESP-IDF ones (idle, timers, BLE, USB)
+static TaskStatus_t status[PROFILER_MAX_TASKS + 8];
+static profiler_task_t tasks[PROFILER_MAX_TASKS];
+
+static void profilerTask(void *parameter)
+{
+  TickType_t wake = xTaskGetTickCount();
+  while (true)
+  {
+    uint32_t totalRuntime = 0;
+    const UBaseType_t count = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), &totalRuntime);
+    size_t used = 0;
+    for (UBaseType_t i = 0; i < count && used < PROFILER_MAX_TASKS; i++)
+    {
+      profiler_task_t &task = tasks[used++];
+      strncpy(task.name, status[i].pcTaskName, PROFILER_NAME_LEN - 1);
+      task.name[PROFILER_NAME_LEN - 1] = '\0';
+      task.id = status[i].xTaskNumber;
+#if configGENERATE_RUN_TIME_STATS
+      task.runtime = status[i].ulRunTimeCounter;
+#else
+      task.runtime = 0;
+#endif
+      task.stackFree = status[i].usStackHighWaterMark; // Bytes on ESP-IDF
+      task.priority = (uint8_t)status[i].uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+      task.core = status[i].xCoreID == tskNO_AFFINITY ? PROFILER_NO_CORE : (int8_t)status[i].xCoreID;
+#else
+      task.core = PROFILER_NO_CORE;
+#endif
+    }
+#if !configGENERATE_RUN_TIME_STATS
+    totalRuntime = 0;
+#endif
+
+    profiler_heap_t heap;
+    heap.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    heap.internalMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    heap.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    heap.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    heap.psramMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+
+    portENTER_CRITICAL(&profilerLock);
+    profiler.updateTasks(tasks, used, totalRuntime);
+    profiler.updateHeap(heap);
+    for (size_t i = 0; i < queueCount; i++)
+    {
+      profiler.updateQueue((int)i, (uint16_t)uxQueueMessagesWaiting(queues[i]));
+    }
+    portEXIT_CRITICAL(&profilerLock);
+
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(PROFILER_PERIOD_MS));
+  }
+}
+
+void profilerBegin()
+{
+  if (profilerTaskHandle != nullptr)
+  {
+    return;
+  }
+  xTaskCreatePinnedToCore(profilerTask, "profiler", 3072, nullptr, 1, &profilerTaskHandle, 0);
+}
+
+void profilerWatchQueue(const char *name, QueueHandle_t queue)
+{
+  if (queue == nullptr)
+  {
+    return;
+  }
+  const uint16_t length = (uint16_t)(uxQueueMessagesWaiting(queue) + uxQueueSpacesAvailable(queue));
+  portENTER_CRITICAL(&profilerLock);
+  const int index = profiler.addQueue(name, length);
+  if (index >= 0)
+  {
+    queues[index] = queue;
+    queueCount = index + 1;
+  }
+  portEXIT_CRITICAL(&profilerLock);
+}
+
+void profilerDump(ProfilerLineWriter writer)
+{
+  // Format from a copy so the sampler is not held up by the serial port
+  static TaskProfiler copy;
+  portENTER_CRITICAL(&profilerLock);
+  copy = profiler;
+  portEXIT_CRITICAL(&profilerLock);
+  copy.dump(writer);
+}
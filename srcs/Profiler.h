@@ -0,0 +1,19 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "TaskProfiler.h"
+
+// Sampling period of the profiler task; CPU shares are per period
+#define PROFILER_PERIOD_MS 1000
+
+// Starts the sampling task (lowest application priority, core 0)
+void profilerBegin();
+
+// Adds a queue to the snapshot; may be called before profilerBegin()
+void profilerWatchQueue(const char *name, QueueHandle_t queue);
+
+// Writes the latest snapshot as "[PROF]" lines (serial command 'p')
+void profilerDump(ProfilerLineWriter writer);
+
+#endif // PROFILER_H
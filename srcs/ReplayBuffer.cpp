@@ -0,0 +1,56 @@
+#include "ReplayBuffer.h"
+
+bool ReplayBuffer::capture(uint8_t modifiers, const KeyBitmap &keys, uint32_t nowMs) {
+  if (_windowMs == 0) {
+    return true;
+  }
+  expire(nowMs);
+
+  bool kept = true;
+  if (_count == REPLAY_BUFFER_DEPTH) {
+    dropOldest();
+    kept = false;
+  }
+  Entry &entry = _entries[(_head + _count) % REPLAY_BUFFER_DEPTH];
+  entry.capturedMs = nowMs;
+  entry.modifiers = modifiers;
+  entry.keys = keys;
+  _count++;
+  return kept;
+}
+
+size_t ReplayBuffer::expire(uint32_t nowMs) {
+  size_t expired = 0;
+  while (_count > 0 && nowMs - _entries[_head].capturedMs > _windowMs) {
+    dropOldest();
+    expired++;
+  }
+  return expired;
+}
+
+void ReplayBuffer::setBase(uint8_t modifiers, const KeyBitmap &keys) {
+  _base.modifiers = modifiers;
+  _base.keys = keys;
+}
+
+void ReplayBuffer::base(uint8_t &modifiers, KeyBitmap &keys) const {
+  modifiers = _base.modifiers;
+  keys = _base.keys;
+}
+
+void ReplayBuffer::dropOldest() {
+  // Whatever the host missed before the new oldest entry is folded into the base
+  _base = _entries[_head];
+  _head = (uint8_t)((_head + 1) % REPLAY_BUFFER_DEPTH);
+  _count--;
+}
+
+bool ReplayBuffer::pop(uint8_t &modifiers, KeyBitmap &keys) {
+  if (_count == 0) {
+    return false;
+  }
+  modifiers = _entries[_head].modifiers;
+  keys = _entries[_head].keys;
+  dropOldest();
+  return true;
+}
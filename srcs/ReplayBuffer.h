@@ -0,0 +1,77 @@
+/**
+ * @file ReplayBuffer.h
+ * @brief Keyboard states captured while no BLE host can receive them.
+ *
+ * While the link is down, or up but not yet subscribed, every keyboard state
+ * change is kept with its capture time. When the host subscribes, the states
+ * still inside the window are replayed in order, so keys typed during a
+ * reconnect reach the host instead of being lost. The window bounds how old
+ * replayed input may be: text typed a second ago is expected, while a key
+ * from a minute ago landing in another window is not. The buffer is also
+ * bounded in size. When it is full the oldest state goes first, the same
+ * as if it had expired.
+ *
+ * Each entry is a full state, not an edge, so the replay always ends at the
+ * state that was current when the link came back. The buffer also keeps the
+ * base state, the one just before the oldest entry. A host is synced to the
+ * base before the replay, so it never sees keys rewind.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef REPLAY_BUFFER_H
+#define REPLAY_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "KeyState.h"
+
+#define REPLAY_BUFFER_DEPTH 32
+#define REPLAY_DEFAULT_WINDOW_MS 500
+
+class ReplayBuffer {
+public:
+  ReplayBuffer() { clear(); }
+
+  /// Sets how long captured states stay replayable; 0 disables capturing.
+  void setWindow(uint32_t windowMs) { _windowMs = windowMs; }
+  uint32_t window() const { return _windowMs; }
+
+  /**
+   * @brief Keeps a state change for replay and expires old states.
+   * @return false if the buffer was full and the oldest state was dropped
+   */
+  bool capture(uint8_t modifiers, const KeyBitmap &keys, uint32_t nowMs);
+
+  /// Drops states captured more than the window ago. Returns how many.
+  size_t expire(uint32_t nowMs);
+
+  /// Sets the state the first capture follows; only meaningful while empty.
+  void setBase(uint8_t modifiers, const KeyBitmap &keys);
+
+  /// The state just before the oldest entry.
+  void base(uint8_t &modifiers, KeyBitmap &keys) const;
+
+  /// Takes the oldest state.
+  bool pop(uint8_t &modifiers, KeyBitmap &keys);
+
+  size_t size() const { return _count; }
+  void clear() { _head = _count = 0; }
+
+private:
+  struct Entry {
+    uint32_t capturedMs;
+    uint8_t modifiers;
+    KeyBitmap keys;
+  };
+
+  void dropOldest();
+
+  Entry _entries[REPLAY_BUFFER_DEPTH];
+  Entry _base = {};
+  uint8_t _head;
+  uint8_t _count;
+  uint32_t _windowMs = REPLAY_DEFAULT_WINDOW_MS;
+};
+
+#endif // REPLAY_BUFFER_H
@@ -0,0 +1,76 @@
+/**
+ * @file Seqlock.h
+ * @brief Single-writer snapshot that readers copy without a lock.
+ *
+ * The writer bumps a sequence counter to odd, stores the value and bumps it
+ * back to even. A reader copies the value between two loads of the counter
+ * and retries if they differ or are odd, so it never sees a half-written
+ * snapshot. The writer never waits for readers. The value is kept as
+ * relaxed atomic words, so the concurrent copy is not a data race.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied word by word");
+
+public:
+  /// Publishes a new value. Writer side only.
+  void write(const T &value) {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+    const uint32_t seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) {
+      _words[i].store(words[i], std::memory_order_relaxed);
+    }
+    _seq.store(seq + 2, std::memory_order_release);
+  }
+
+  /// Copies the latest value; false if the writer was in the middle of an update.
+  bool tryRead(T &out) const {
+    const uint32_t before = _seq.load(std::memory_order_acquire);
+    if (before & 1) {
+      return false;
+    }
+    uint32_t words[WORDS];
+    for (size_t i = 0; i < WORDS; i++) {
+      words[i] = _words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_seq.load(std::memory_order_relaxed) != before) {
+      return false;
+    }
+    memcpy(&out, words, sizeof(T));
+    return true;
+  }
+
+  /// Copies the latest value, retrying until the copy is consistent.
+  T read() const {
+    T value;
+    while (!tryRead(value)) {
+    }
+    return value;
+  }
+
+  /// Values published so far.
+  uint32_t version() const { return _seq.load(std::memory_order_acquire) / 2; }
+
+private:
+  static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> _seq{0};
+  std::atomic<uint32_t> _words[WORDS] = {};
+};
+
+#endif // SEQLOCK_H
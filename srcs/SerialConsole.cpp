@@ -0,0 +1,70 @@
+#include "SerialConsole.h"
+#include <stdio.h>
+#include <string.h>
+
+void SerialConsole::feed(char c) {
+  const char previous = _previous;
+  _previous = c;
+  if (c == '\n' && previous == '\r') {
+    return; // Second half of CRLF
+  }
+  if (c != '\n' && c != '\r') {
+    if (_length < CONSOLE_LINE_MAX - 1) {
+      _line[_length++] = c;
+    } else {
+      _overflow = true;
+    }
+    return;
+  }
+
+  _line[_length] = '\0';
+  if (_overflow) {
+    char message[64];
+    snprintf(message, sizeof(message), "[CONSOLE] Line longer than %d characters ignored", CONSOLE_LINE_MAX - 1);
+    _writer(message);
+  } else if (_length > 0) {
+    execute(_line);
+  }
+  _length = 0;
+  _overflow = false;
+}
+
+void SerialConsole::execute(const char *line) {
+  while (*line == ' ') {
+    line++;
+  }
+  if (*line == '\0') {
+    return;
+  }
+  size_t word = 0;
+  while (line[word] != '\0' && line[word] != ' ') {
+    word++;
+  }
+
+  for (size_t i = 0; i < _count; i++) {
+    const console_command_t &command = _commands[i];
+    if (strlen(command.name) != word || strncmp(line, command.name, word) != 0) {
+      continue;
+    }
+    const char *args = line + word;
+    while (*args == ' ') {
+      args++;
+    }
+    command.handler(args);
+    return;
+  }
+
+  char message[CONSOLE_LINE_MAX + 48];
+  snprintf(message, sizeof(message), "[CONSOLE] Unknown command '%.*s', try 'help'", (int)word, line);
+  _writer(message);
+}
+
+void SerialConsole::help() const {
+  char line[96];
+  for (size_t i = 0; i < _count; i++) {
+    if (_commands[i].help != nullptr) {
+      snprintf(line, sizeof(line), "[CONSOLE] %-10s %s", _commands[i].name, _commands[i].help);
+      _writer(line);
+    }
+  }
+}
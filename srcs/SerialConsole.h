@@ -0,0 +1,56 @@
+/**
+ * @file SerialConsole.h
+ * @brief Non-blocking line-oriented command console.
+ *
+ * The caller feeds received characters one at a time, e.g. whatever
+ * Serial.available() reports in loop(), so it never waits for a line. CR, LF
+ * or CRLF ends a line. The first word of the line selects a command from a
+ * static table, and the rest of the line, without leading spaces, is its
+ * argument. Only whole words match, so a mistyped command is reported rather
+ * than run as a shorter one. Lines longer than CONSOLE_LINE_MAX - 1 are
+ * rejected as a whole rather than run truncated.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include <stddef.h>
+
+#define CONSOLE_LINE_MAX 128
+
+typedef void (*ConsoleLineWriter)(const char *line);
+typedef void (*ConsoleHandler)(const char *args);
+
+typedef struct {
+  const char *name;
+  const char *help;       ///< One line for "help"; nullptr hides the entry (aliases)
+  ConsoleHandler handler;
+} console_command_t;
+
+class SerialConsole {
+public:
+  SerialConsole(const console_command_t *commands, size_t count, ConsoleLineWriter writer)
+      : _commands(commands), _count(count), _writer(writer) {}
+
+  /// Takes one received character; runs the command when it ends a line.
+  void feed(char c);
+
+  /// Runs one complete line.
+  void execute(const char *line);
+
+  /// Writes the visible commands and their help.
+  void help() const;
+
+private:
+  const console_command_t *_commands;
+  size_t _count;
+  ConsoleLineWriter _writer;
+  char _line[CONSOLE_LINE_MAX];
+  size_t _length = 0;
+  bool _overflow = false;
+  char _previous = 0;
+};
+
+#endif // SERIAL_CONSOLE_H
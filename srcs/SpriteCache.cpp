@@ -0,0 +1,97 @@
+#include "SpriteCache.h"
+#include <string.h>
+
+int SpriteCache::add(const char *name, int16_t w, int16_t h) {
+  if (_count == SPRITE_CACHE_MAX_FRAMES || w <= 0 || h <= 0) {
+    _stats.failed++;
+    return -1;
+  }
+  const size_t bytes = (size_t)w * h * sizeof(uint16_t);
+  uint16_t *pixels = (uint16_t *)_alloc(bytes);
+  if (pixels == nullptr) {
+    _stats.failed++;
+    return -1;
+  }
+  memset(pixels, 0, bytes);
+
+  CachedSprite &frame = _frames[_count];
+  strncpy(frame.name, name, sizeof(frame.name) - 1);
+  frame.name[sizeof(frame.name) - 1] = '\0';
+  frame.pixels = pixels;
+  frame.w = w;
+  frame.h = h;
+  _stats.frames++;
+  _stats.bytes += bytes;
+  return _count++;
+}
+
+void SpriteCache::blit(uint8_t index, int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels) {
+  if (index >= _count) {
+    return;
+  }
+  const CachedSprite &frame = _frames[index];
+  // Decoders emit whole blocks; the right and bottom ones may stick out
+  const int16_t left = x < 0 ? 0 : x;
+  const int16_t top = y < 0 ? 0 : y;
+  const int16_t right = x + w < frame.w ? x + w : frame.w;
+  const int16_t bottom = y + h < frame.h ? y + h : frame.h;
+  if (right <= left || bottom <= top) {
+    return;
+  }
+  for (int16_t row = top; row < bottom; row++) {
+    memcpy(frame.pixels + row * frame.w + left, pixels + (row - y) * w + (left - x),
+           (right - left) * sizeof(uint16_t));
+  }
+}
+
+int SpriteCache::find(const char *name) const {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (strncmp(_frames[i].name, name, sizeof(_frames[i].name)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool SpriteCache::diffBounds(uint8_t a, uint8_t b, int16_t &x, int16_t &y, int16_t &w, int16_t &h) const {
+  if (a >= _count || b >= _count || _frames[a].w != _frames[b].w || _frames[a].h != _frames[b].h) {
+    return false;
+  }
+  const CachedSprite &first = _frames[a];
+  const CachedSprite &second = _frames[b];
+  int16_t top = -1;
+  int16_t bottom = -1;
+  int16_t left = first.w;
+  int16_t right = -1;
+  for (int16_t row = 0; row < first.h; row++) {
+    const uint16_t *p = first.pixels + row * first.w;
+    const uint16_t *q = second.pixels + row * first.w;
+    if (memcmp(p, q, first.w * sizeof(uint16_t)) == 0) {
+      continue;
+    }
+    if (top < 0) {
+      top = row;
+    }
+    bottom = row;
+    for (int16_t col = 0; col < left; col++) {
+      if (p[col] != q[col]) {
+        left = col;
+        break;
+      }
+    }
+    for (int16_t col = first.w - 1; col > right; col--) {
+      if (p[col] != q[col]) {
+        right = col;
+        break;
+      }
+    }
+  }
+  if (top < 0) {
+    return false;
+  }
+  x = left;
+  y = top;
+  w = right - left + 1;
+  h = bottom - top + 1;
+  return true;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file SpriteCache.h
+ * @brief Named RGB565 frames decoded once and kept in memory (PSRAM on the device).
+ *
+ * Images are decoded at boot straight into their cache entry: add() reserves
+ * the frame and the decoder's output callback copies its blocks in with
+ * blit(), clipped to the frame. Showing a frame afterwards needs no file
+ * access and no decoding; the pixels can be handed to the compositor or
+ * pushed to the display as they are. diffBounds() finds the area two frames
+ * differ in, so switching between similar frames only redraws that area.
+ *
+ * The cache is filled once and then only read, so readers need no lock.
+ * Memory comes from an allocator callback, so the owner decides where it
+ * lives. This file has no Arduino or ESP-IDF dependencies so it can be built
+ * on the host.
+ */
+
+#ifndef SPRITE_CACHE_H
+#define SPRITE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPRITE_CACHE_MAX_FRAMES 12
+#define SPRITE_CACHE_NAME_LENGTH 24
+
+/// Returns bytes of memory for one frame, nullptr if there is none.
+typedef void *(*sprite_alloc_cb_t)(size_t bytes);
+
+/** @brief One cached frame, pixels row by row. */
+struct CachedSprite {
+  char name[SPRITE_CACHE_NAME_LENGTH];
+  uint16_t *pixels;
+  int16_t w;
+  int16_t h;
+};
+
+typedef struct {
+  uint8_t frames;  ///< Frames cached
+  uint32_t bytes;  ///< Memory held by the frames
+  uint32_t failed; ///< Frames that could not be allocated
+} sprite_cache_stats_t;
+
+class SpriteCache {
+public:
+  explicit SpriteCache(sprite_alloc_cb_t alloc) : _alloc(alloc) {}
+
+  /**
+   * @brief Reserves a w x h frame, cleared to 0.
+   * @return Index of the frame, -1 if the cache is full or out of memory
+   */
+  int add(const char *name, int16_t w, int16_t h);
+
+  /// Copies a w x h block to (x, y) of frame index, clipped to the frame.
+  void blit(uint8_t index, int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels);
+
+  /// Index of the frame called name, -1 if it is not cached.
+  int find(const char *name) const;
+
+  /**
+   * @brief Bounding box of the pixels that differ between two frames of the same size.
+   * @return false if the frames are identical or cannot be compared (then the box is not set)
+   */
+  bool diffBounds(uint8_t a, uint8_t b, int16_t &x, int16_t &y, int16_t &w, int16_t &h) const;
+
+  const CachedSprite *get(uint8_t index) const { return index < _count ? &_frames[index] : nullptr; }
+  uint8_t count() const { return _count; }
+
+  const sprite_cache_stats_t &stats() const { return _stats; }
+
+private:
+  sprite_alloc_cb_t _alloc;
+  CachedSprite _frames[SPRITE_CACHE_MAX_FRAMES];
+  uint8_t _count = 0;
+  sprite_cache_stats_t _stats = {};
+};
+
+#endif // SPRITE_CACHE_H
@@ -0,0 +1,97 @@
+/**
+ * @file SpscRing.h
+ * @brief Fixed-size lock-free single-producer/single-consumer ring buffer.
+ *
+ * One task pushes, one task pops; neither ever blocks or takes a lock. The
+ * producer and consumer indices live on separate cache lines so the two
+ * cores do not fight over them. Overflows (push on a full ring) are counted
+ * and the deepest fill level seen is kept as a high-watermark.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SPSC_CACHE_LINE_SIZE
+#define SPSC_CACHE_LINE_SIZE 64
+#endif
+
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+  /**
+   * @brief Appends an item. Producer side only.
+   * @return false if the ring was full; the item is dropped and counted
+   */
+  bool push(const T &item) {
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    const uint32_t tail = _tail.load(std::memory_order_acquire);
+    const uint32_t used = head - tail;
+
+    if (used >= N) {
+      _overflows.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    _items[head & (N - 1)] = item;
+    _head.store(head + 1, std::memory_order_release);
+
+    if (used + 1 > _highWatermark.load(std::memory_order_relaxed)) {
+      _highWatermark.store(used + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest item. Consumer side only.
+   * @return false if the ring was empty
+   */
+  bool pop(T &item) {
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    item = _items[tail & (N - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Number of items waiting. Exact only when called from the producer or consumer.
+  size_t size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+  /// Pushes rejected because the ring was full.
+  uint32_t overflowCount() const { return _overflows.load(std::memory_order_relaxed); }
+
+  /// Deepest fill level seen since the last reset.
+  uint32_t highWatermark() const { return _highWatermark.load(std::memory_order_relaxed); }
+
+  void resetStats() {
+    _overflows.store(0, std::memory_order_relaxed);
+    _highWatermark.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  // Producer-owned
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _overflows{0};
+  std::atomic<uint32_t> _highWatermark{0};
+
+  // Consumer-owned
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> _tail{0};
+
+  alignas(SPSC_CACHE_LINE_SIZE) T _items[N];
+};
+
+#endif // SPSC_RING_H
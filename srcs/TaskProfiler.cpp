@@ -0,0 +1,157 @@
+#include "TaskProfiler.h"
+#include <stdio.h>
+#include <string.h>
+
+void TaskProfiler::updateTasks(const profiler_task_t *tasks, size_t count, uint32_t totalRuntime) {
+  if (count > PROFILER_MAX_TASKS) {
+    count = PROFILER_MAX_TASKS;
+  }
+  const uint32_t interval = totalRuntime - _totalRuntime;
+  const bool timed = totalRuntime != 0 && _samples > 0 && interval != 0;
+
+  profiler_task_t next[PROFILER_MAX_TASKS];
+  for (size_t i = 0; i < count; i++) {
+    next[i] = tasks[i];
+    next[i].name[PROFILER_NAME_LEN - 1] = '\0';
+    next[i].cpuPermille = PROFILER_NO_CPU;
+    if (!timed) {
+      continue;
+    }
+    // Tasks created since the previous sample count from zero
+    uint32_t previous = 0;
+    for (size_t j = 0; j < _taskCount; j++) {
+      if (_tasks[j].id == tasks[i].id) {
+        previous = _tasks[j].runtime;
+        break;
+      }
+    }
+    const uint64_t permille = (uint64_t)(tasks[i].runtime - previous) * 1000 / interval;
+    next[i].cpuPermille = (uint16_t)(permille > 1000 ? 1000 : permille);
+  }
+
+  memcpy(_tasks, next, count * sizeof(profiler_task_t));
+  _taskCount = count;
+  _intervalUs = timed ? interval : 0;
+  _totalRuntime = totalRuntime;
+  _samples++;
+}
+
+int TaskProfiler::addQueue(const char *name, uint16_t length) {
+  if (_queueCount >= PROFILER_MAX_QUEUES) {
+    return -1;
+  }
+  profiler_queue_t &queue = _queues[_queueCount];
+  queue.name = name;
+  queue.length = length;
+  queue.depth = 0;
+  queue.maxDepth = 0;
+  return (int)_queueCount++;
+}
+
+void TaskProfiler::updateQueue(int index, uint16_t depth) {
+  if (index < 0 || (size_t)index >= _queueCount) {
+    return;
+  }
+  profiler_queue_t &queue = _queues[index];
+  queue.depth = depth;
+  if (depth > queue.maxDepth) {
+    queue.maxDepth = depth;
+  }
+}
+
+uint16_t TaskProfiler::coreLoad(int core) const {
+  for (size_t i = 0; i < _taskCount; i++) {
+    const profiler_task_t &task = _tasks[i];
+    if (task.core == core && task.priority == 0 && strncmp(task.name, "IDLE", 4) == 0) {
+      return task.cpuPermille == PROFILER_NO_CPU ? PROFILER_NO_CPU : (uint16_t)(1000 - task.cpuPermille);
+    }
+  }
+  return PROFILER_NO_CPU;
+}
+
+static void format_permille(char *out, size_t size, uint16_t permille) {
+  if (permille == PROFILER_NO_CPU) {
+    snprintf(out, size, "-");
+  } else {
+    snprintf(out, size, "%u.%u%%", permille / 10, permille % 10);
+  }
+}
+
+void TaskProfiler::dump(ProfilerLineWriter writer) const {
+  char line[128];
+  char cpu[12];
+
+  if (_samples == 0) {
+    writer("[PROF] No sample yet");
+    return;
+  }
+
+  int len = snprintf(line, sizeof(line), "[PROF] sample %u, %u tasks", (unsigned)_samples, (unsigned)_taskCount);
+  if (_intervalUs != 0) {
+    len += snprintf(line + len, sizeof(line) - len, " over %u ms", (unsigned)(_intervalUs / 1000));
+  } else {
+    len += snprintf(line + len, sizeof(line) - len, ", no run-time counters");
+  }
+  for (int core = 0; core < PROFILER_CORES && len < (int)sizeof(line); core++) {
+    const uint16_t load = coreLoad(core);
+    if (load != PROFILER_NO_CPU) {
+      format_permille(cpu, sizeof(cpu), load);
+      len += snprintf(line + len, sizeof(line) - len, ", core %d %s busy", core, cpu);
+    }
+  }
+  writer(line);
+
+  // Busiest first; an index sort keeps the table untouched
+  uint8_t order[PROFILER_MAX_TASKS];
+  for (size_t i = 0; i < _taskCount; i++) {
+    order[i] = (uint8_t)i;
+  }
+  for (size_t i = 1; i < _taskCount; i++) {
+    const uint8_t current = order[i];
+    const uint16_t key = _tasks[current].cpuPermille == PROFILER_NO_CPU ? 0 : _tasks[current].cpuPermille;
+    size_t j = i;
+    while (j > 0) {
+      const profiler_task_t &before = _tasks[order[j - 1]];
+      const uint16_t other = before.cpuPermille == PROFILER_NO_CPU ? 0 : before.cpuPermille;
+      if (other >= key) {
+        break;
+      }
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = current;
+  }
+
+  writer("[PROF]   task             core prio    cpu  stack free");
+  for (size_t i = 0; i < _taskCount; i++) {
+    const profiler_task_t &task = _tasks[order[i]];
+    char core[5];
+    if (task.core == PROFILER_NO_CORE) {
+      snprintf(core, sizeof(core), "-");
+    } else {
+      snprintf(core, sizeof(core), "%d", task.core);
+    }
+    format_permille(cpu, sizeof(cpu), task.cpuPermille);
+    snprintf(line, sizeof(line), "[PROF]   %-16s %4s %4u %6s %6u", task.name, core, task.priority, cpu,
+             (unsigned)task.stackFree);
+    writer(line);
+  }
+
+  for (size_t i = 0; i < _queueCount; i++) {
+    const profiler_queue_t &queue = _queues[i];
+    snprintf(line, sizeof(line), "[PROF]   queue %-20s %u/%u, max %u", queue.name, queue.depth, queue.length,
+             queue.maxDepth);
+    writer(line);
+  }
+
+  if (_heap.internalFree == 0 && _heap.psramFree == 0) {
+    writer("[PROF]   heap: not measured");
+    return;
+  }
+  snprintf(line, sizeof(line),
+           "[PROF]   heap: internal %u KB free (min %u KB, largest block %u KB), PSRAM %u KB free (min %u KB)",
+           (unsigned)(_heap.internalFree / 1024), (unsigned)(_heap.internalMinFree / 1024),
+           (unsigned)(_heap.internalLargest / 1024), (unsigned)(_heap.psramFree / 1024),
+           (unsigned)(_heap.psramMinFree / 1024));
+  writer(line);
+}
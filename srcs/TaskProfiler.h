@@ -0,0 +1,96 @@
+/**
+ * @file TaskProfiler.h
+ * @brief Per-task CPU share, stack headroom, queue depths and heap, as one snapshot.
+ *
+ * The platform side (srcs/Profiler.cpp on the device, sim/SimProfiler.cpp in
+ * the simulation) samples the scheduler once a period and hands the task
+ * table to updateTasks(). The run-time counters are cumulative. A task's CPU
+ * share is therefore its counter delta over the delta of the total run time
+ * since the previous sample, in per mille of one core. Each core's load is
+ * 100 % minus its idle task's share. Queue depths keep the highest value
+ * sampled. dump() formats the latest snapshot as compact "[PROF]" lines,
+ * busiest task first.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROFILER_MAX_TASKS 32
+#define PROFILER_MAX_QUEUES 8
+#define PROFILER_NAME_LEN 16
+#define PROFILER_CORES 2
+#define PROFILER_NO_CPU 0xFFFF // cpuPermille when the scheduler keeps no run-time counters
+#define PROFILER_NO_CORE -1
+
+typedef struct {
+  char name[PROFILER_NAME_LEN];
+  uint32_t id;          ///< Scheduler task number, to match samples
+  uint32_t runtime;     ///< Cumulative run time in microseconds (wraps)
+  uint32_t stackFree;   ///< Bytes of stack never used (high-water mark)
+  uint8_t priority;
+  int8_t core;          ///< Pinned core, PROFILER_NO_CORE if it floats
+  uint16_t cpuPermille; ///< Share of one core since the previous sample (filled by the profiler)
+} profiler_task_t;
+
+typedef struct {
+  const char *name;
+  uint16_t depth;    ///< Items waiting at the last sample
+  uint16_t length;   ///< Capacity
+  uint16_t maxDepth; ///< Highest depth sampled
+} profiler_queue_t;
+
+typedef struct {
+  uint32_t internalFree;
+  uint32_t internalMinFree; ///< Lowest free internal RAM since boot
+  uint32_t internalLargest; ///< Largest free internal block
+  uint32_t psramFree;
+  uint32_t psramMinFree;
+} profiler_heap_t;
+
+typedef void (*ProfilerLineWriter)(const char *line);
+
+class TaskProfiler {
+public:
+  /**
+   * @brief Replaces the task table with a new sample.
+   * @param tasks Up to PROFILER_MAX_TASKS tasks; more are ignored
+   * @param totalRuntime Cumulative run time in microseconds, 0 if run-time stats are off
+   */
+  void updateTasks(const profiler_task_t *tasks, size_t count, uint32_t totalRuntime);
+
+  /// Adds a queue to watch; returns its index, or -1 if the table is full.
+  int addQueue(const char *name, uint16_t length);
+  void updateQueue(int index, uint16_t depth);
+
+  void updateHeap(const profiler_heap_t &heap) { _heap = heap; }
+
+  /// Busy share of a core in per mille, PROFILER_NO_CPU if unknown.
+  uint16_t coreLoad(int core) const;
+
+  size_t taskCount() const { return _taskCount; }
+  const profiler_task_t &task(size_t index) const { return _tasks[index]; }
+  size_t queueCount() const { return _queueCount; }
+  const profiler_queue_t &queue(size_t index) const { return _queues[index]; }
+  const profiler_heap_t &heap() const { return _heap; }
+  uint32_t samples() const { return _samples; }
+
+  /// Writes the latest snapshot as "[PROF]" lines.
+  void dump(ProfilerLineWriter writer) const;
+
+private:
+  profiler_task_t _tasks[PROFILER_MAX_TASKS] = {};
+  size_t _taskCount = 0;
+  uint32_t _totalRuntime = 0;
+  uint32_t _intervalUs = 0;
+  profiler_queue_t _queues[PROFILER_MAX_QUEUES] = {};
+  size_t _queueCount = 0;
+  profiler_heap_t _heap = {};
+  uint32_t _samples = 0;
+};
+
+#endif // TASK_PROFILER_H
@@ -0,0 +1,149 @@
+#include "TextInjector.h"
+#include <string.h>
+
+#define SHIFT 0x80        // Flag in the table below: type with Left Shift
+#define LEFT_SHIFT_BIT 0x02
+
+/// Keyboard usage per ASCII character, SHIFT set for shifted characters, 0 if none
+static constexpr uint8_t ascii_usage(int c) {
+  if (c >= 'a' && c <= 'z') return (uint8_t)(0x04 + (c - 'a'));
+  if (c >= 'A' && c <= 'Z') return (uint8_t)(SHIFT | (0x04 + (c - 'A')));
+  if (c >= '1' && c <= '9') return (uint8_t)(0x1E + (c - '1'));
+  switch (c) {
+  case '0': return 0x27;
+  case '\n': return 0x28;
+  case '\t': return 0x2B;
+  case ' ': return 0x2C;
+  case '!': return SHIFT | 0x1E;
+  case '@': return SHIFT | 0x1F;
+  case '#': return SHIFT | 0x20;
+  case '$': return SHIFT | 0x21;
+  case '%': return SHIFT | 0x22;
+  case '^': return SHIFT | 0x23;
+  case '&': return SHIFT | 0x24;
+  case '*': return SHIFT | 0x25;
+  case '(': return SHIFT | 0x26;
+  case ')': return SHIFT | 0x27;
+  case '-': return 0x2D;
+  case '_': return SHIFT | 0x2D;
+  case '=': return 0x2E;
+  case '+': return SHIFT | 0x2E;
+  case '[': return 0x2F;
+  case '{': return SHIFT | 0x2F;
+  case ']': return 0x30;
+  case '}': return SHIFT | 0x30;
+  case '\\': return 0x31;
+  case '|': return SHIFT | 0x31;
+  case ';': return 0x33;
+  case ':': return SHIFT | 0x33;
+  case '\'': return 0x34;
+  case '"': return SHIFT | 0x34;
+  case '`': return 0x35;
+  case '~': return SHIFT | 0x35;
+  case ',': return 0x36;
+  case '<': return SHIFT | 0x36;
+  case '.': return 0x37;
+  case '>': return SHIFT | 0x37;
+  case '/': return 0x38;
+  case '?': return SHIFT | 0x38;
+  default: return 0;
+  }
+}
+
+struct AsciiTable {
+  uint8_t usage[128];
+};
+
+static constexpr AsciiTable make_ascii_table() {
+  AsciiTable table{};
+  for (int c = 0; c < 128; c++) {
+    table.usage[c] = ascii_usage(c);
+  }
+  return table;
+}
+
+static constexpr AsciiTable ASCII_TABLE = make_ascii_table();
+
+bool textInjectLookup(char c, uint8_t &key, uint8_t &modifiers) {
+  const uint8_t index = (uint8_t)c;
+  if (index >= 128 || ASCII_TABLE.usage[index] == 0) {
+    return false;
+  }
+  key = ASCII_TABLE.usage[index] & ~SHIFT;
+  modifiers = (ASCII_TABLE.usage[index] & SHIFT) ? LEFT_SHIFT_BIT : 0;
+  return true;
+}
+
+static bool step_holds(const inject_step_t &step, uint8_t key) {
+  for (uint8_t i = 0; i < step.count; i++) {
+    if (step.keys[i] == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t textInjectCompile(const char *text, size_t len, bool packed, inject_step_t *out,
+                         size_t maxSteps, size_t *consumed, uint32_t *skipped) {
+  inject_step_t current = {};
+  size_t n = 0;
+  size_t i = 0;
+
+  for (; i < len; i++) {
+    uint8_t key;
+    uint8_t modifiers;
+    if (!textInjectLookup(text[i], key, modifiers)) {
+      if (skipped != nullptr) {
+        (*skipped)++;
+      }
+      continue;
+    }
+
+    // A key that is already down or a modifier change is only seen by the host after a release
+    const bool release = current.count > 0 &&
+                         (!packed || current.count == TEXT_INJECT_MAX_KEYS ||
+                          current.modifiers != modifiers || step_holds(current, key));
+    // Room for this character and the final release
+    if (n + (release ? 1 : 0) + 2 > maxSteps) {
+      break;
+    }
+
+    if (release) {
+      current.count = 0;
+      // Packed mode switches the modifiers in the release report to save one
+      current.modifiers = packed ? modifiers : 0;
+      out[n++] = current;
+    }
+    current.modifiers = modifiers;
+    current.keys[current.count++] = key;
+    out[n++] = current;
+  }
+
+  if (current.count > 0 || current.modifiers != 0) {
+    out[n++] = inject_step_t{};
+  }
+  if (consumed != nullptr) {
+    *consumed = i;
+  }
+  return n;
+}
+
+bool TextInjectQueue::push(const inject_step_t *steps, size_t count) {
+  if (count > space()) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    _steps[(_head + i) & (TEXT_INJECT_QUEUE_DEPTH - 1)] = steps[i];
+  }
+  _head += count;
+  return true;
+}
+
+bool TextInjectQueue::pop(inject_step_t &step) {
+  if (empty()) {
+    return false;
+  }
+  step = _steps[_tail & (TEXT_INJECT_QUEUE_DEPTH - 1)];
+  _tail++;
+  return true;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file TextInjector.h
+ * @brief Compiles text into keyboard report sequences for typing over BLE.
+ *
+ * Typing a character the obvious way takes two reports, a press and a
+ * release. The host only reacts to keys that are newly down in a report, so
+ * packed mode keeps earlier keys held and adds one key per report instead:
+ * "hello" becomes {h} {h e} {h e l} {} {l} {l o} {}. Keys are released
+ * only when a key repeats, the modifiers change or six keys are down (the
+ * boot report limit), which brings a typical text close to one report per
+ * character.
+ *
+ * The reports must reach the host one by one, so the queue is drained by
+ * NotifyScheduler a few steps per connection event and bypasses coalescing.
+ * Only US layout ASCII is supported; other characters are skipped.
+ *
+ * This file has no Arduino or ESP-IDF dependencies so it can be built on the host.
+ */
+
+#ifndef TEXT_INJECTOR_H
+#define TEXT_INJECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "KeyState.h"
+
+#define TEXT_INJECT_MAX_KEYS 6
+#define TEXT_INJECT_QUEUE_DEPTH 128
+
+/** @brief One keyboard report of an injected sequence. */
+typedef struct {
+  uint8_t modifiers;
+  uint8_t count;
+  uint8_t keys[TEXT_INJECT_MAX_KEYS];
+} inject_step_t;
+
+/**
+ * @brief Looks up the key and modifiers (Left Shift or none) that type c on a US layout.
+ * @return false if the character cannot be typed
+ */
+bool textInjectLookup(char c, uint8_t &key, uint8_t &modifiers);
+
+/**
+ * @brief Compiles text into report steps. The sequence always ends with a release.
+ * @param packed false for one press and one release per character
+ * @param consumed Receives the number of characters compiled; less than len if out was too small
+ * @param skipped Incremented for every character that has no key
+ * @return Number of steps written
+ */
+size_t textInjectCompile(const char *text, size_t len, bool packed, inject_step_t *out,
+                         size_t maxSteps, size_t *consumed, uint32_t *skipped);
+
+/** @brief Queue of compiled steps. The owner serializes access. */
+class TextInjectQueue {
+public:
+  void clear() { _head = _tail = 0; }
+
+  size_t size() const { return _head - _tail; }
+  size_t space() const { return TEXT_INJECT_QUEUE_DEPTH - size(); }
+  bool empty() const { return _head == _tail; }
+
+  /// Appends all steps or none. Returns false if they do not fit.
+  bool push(const inject_step_t *steps, size_t count);
+
+  bool pop(inject_step_t &step);
+
+private:
+  inject_step_t _steps[TEXT_INJECT_QUEUE_DEPTH];
+  uint32_t _head = 0;
+  uint32_t _tail = 0;
+};
+
+#endif // TEXT_INJECTOR_H
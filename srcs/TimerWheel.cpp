@@ -0,0 +1,71 @@
+#include "TimerWheel.h"
+#include <string.h>
+
+void TimerWheel::reset(uint32_t nowMs) {
+  _tick = nowMs / _tickMs;
+  memset(_head, TIMER_WHEEL_NONE, sizeof(_head));
+  memset(_next, TIMER_WHEEL_NONE, sizeof(_next));
+  memset(_prev, TIMER_WHEEL_NONE, sizeof(_prev));
+  memset(_slot, TIMER_WHEEL_NONE, sizeof(_slot));
+  memset(_due, 0, sizeof(_due));
+}
+
+void TimerWheel::unlink(uint8_t id) {
+  const uint8_t slot = _slot[id];
+  if (_prev[id] != TIMER_WHEEL_NONE) {
+    _next[_prev[id]] = _next[id];
+  } else {
+    _head[slot] = _next[id];
+  }
+  if (_next[id] != TIMER_WHEEL_NONE) {
+    _prev[_next[id]] = _prev[id];
+  }
+  _next[id] = TIMER_WHEEL_NONE;
+  _prev[id] = TIMER_WHEEL_NONE;
+  _slot[id] = TIMER_WHEEL_NONE;
+}
+
+void TimerWheel::schedule(uint8_t id, uint32_t dueMs) {
+  if (id >= TIMER_WHEEL_MAX_TIMERS) {
+    return;
+  }
+  if (_slot[id] != TIMER_WHEEL_NONE) {
+    unlink(id);
+  }
+
+  // A due time in the past lands in the current tick and fires on the next advance()
+  uint32_t dueTick = dueMs / _tickMs;
+  if ((int32_t)(dueTick - _tick) < 0) {
+    dueTick = _tick;
+  }
+  const uint8_t slot = dueTick & (TIMER_WHEEL_SLOTS - 1);
+  _due[id] = dueMs;
+  _slot[id] = slot;
+  _prev[id] = TIMER_WHEEL_NONE;
+  _next[id] = _head[slot];
+  if (_head[slot] != TIMER_WHEEL_NONE) {
+    _prev[_head[slot]] = id;
+  }
+  _head[slot] = id;
+}
+
+void TimerWheel::cancel(uint8_t id) {
+  if (armed(id)) {
+    unlink(id);
+  }
+}
+
+uint32_t TimerWheel::msUntilNext(uint32_t nowMs) const {
+  uint32_t next = UINT32_MAX;
+  for (uint8_t id = 0; id < TIMER_WHEEL_MAX_TIMERS; id++) {
+    if (_slot[id] == TIMER_WHEEL_NONE) {
+      continue;
+    }
+    const int32_t left = (int32_t)(_due[id] - nowMs);
+    const uint32_t wait = left > 0 ? (uint32_t)left : 0;
+    if (wait < next) {
+      next = wait;
+    }
+  }
+  return next;
+}
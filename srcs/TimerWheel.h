@@ -0,0 +1,85 @@
+/**
+ * @file TimerWheel.h
+ * @brief Hashed timer wheel for a handful of millisecond one-shot timers.
+ *
+ * Each timer hangs in the slot of its due tick, so advance() only visits the
+ * slots of the ticks that passed instead of checking every timer. Timers
+ * further out than one turn stay in their slot until their due time. Timers
+ * are identified by small fixed ids owned by the caller; scheduling an armed
+ * id moves it.
+ *
+ * The wheel is plain state: the caller serializes access and sleeps until
+ * msUntilNext(). This file has no Arduino or ESP-IDF dependencies so it can
+ * be built on the host.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_SLOTS 32
+#define TIMER_WHEEL_MAX_TIMERS 8
+#define TIMER_WHEEL_NONE 0xFF
+
+class TimerWheel {
+public:
+  explicit TimerWheel(uint32_t tickMs = 4) : _tickMs(tickMs) { reset(0); }
+
+  /// Disarms all timers and restarts the wheel at nowMs.
+  void reset(uint32_t nowMs);
+
+  /// Arms (or moves) timer id to fire at dueMs.
+  void schedule(uint8_t id, uint32_t dueMs);
+
+  void cancel(uint8_t id);
+
+  bool armed(uint8_t id) const { return id < TIMER_WHEEL_MAX_TIMERS && _slot[id] != TIMER_WHEEL_NONE; }
+
+  /// Milliseconds until the earliest armed timer is due, UINT32_MAX if none is armed.
+  uint32_t msUntilNext(uint32_t nowMs) const;
+
+  /**
+   * @brief Fires every timer due at nowMs, calling fn(id) after disarming it.
+   * fn may schedule timers again.
+   */
+  template <typename Fn>
+  void advance(uint32_t nowMs, Fn fn) {
+    const uint32_t target = nowMs / _tickMs;
+    // After a gap of a full turn or more every slot is visited once
+    uint32_t tick = target - _tick >= TIMER_WHEEL_SLOTS ? target - (TIMER_WHEEL_SLOTS - 1) : _tick;
+    for (;; tick++) {
+      // Collect first: fn may cancel or move the other timers of this slot
+      uint8_t due[TIMER_WHEEL_MAX_TIMERS];
+      uint8_t count = 0;
+      for (uint8_t id = _head[tick & (TIMER_WHEEL_SLOTS - 1)]; id != TIMER_WHEEL_NONE; id = _next[id]) {
+        if ((int32_t)(_due[id] - nowMs) <= 0) {
+          due[count++] = id;
+        }
+      }
+      for (uint8_t i = 0; i < count; i++) {
+        if (armed(due[i]) && (int32_t)(_due[due[i]] - nowMs) <= 0) {
+          unlink(due[i]);
+          fn(due[i]);
+        }
+      }
+      if (tick == target) {
+        break;
+      }
+    }
+    _tick = target;
+  }
+
+private:
+  void unlink(uint8_t id);
+
+  uint32_t _tickMs;
+  uint32_t _tick; ///< Last tick advanced to
+  uint8_t _head[TIMER_WHEEL_SLOTS];
+  uint8_t _next[TIMER_WHEEL_MAX_TIMERS];
+  uint8_t _prev[TIMER_WHEEL_MAX_TIMERS];
+  uint8_t _slot[TIMER_WHEEL_MAX_TIMERS]; ///< TIMER_WHEEL_NONE when disarmed
+  uint32_t _due[TIMER_WHEEL_MAX_TIMERS];
+};
+
+#endif // TIMER_WHEEL_H
@@ -12,13 +12,61 @@ extern "C" {
 #endif
 
 #include <hid_usage_keyboard.h>
+#include <esp_timer.h>
+#include "SpscRing.h"
+#include "BinLog.h"
+#include "LatencyStats.h"
+#include "Metrics.h"
+#include "Profiler.h"
 
 KeyboardReportCallback USBManager::_keyboardCb = nullptr;
 MouseReportCallback USBManager::_mouseCb = nullptr;
+ConsumerReportCallback USBManager::_consumerCb = nullptr;
 GenericReportCallback USBManager::_genericCb = nullptr;
+InterfaceReleaseCallback USBManager::_releaseCb = nullptr;
 
 static QueueHandle_t hid_host_event_queue;
 
+// Extraction plan of every open interface, built once on connect. hid_task
+// claims a free slot and builds its plan, the interface callback tags each
+// event with the slot and its generation, and hid_input_task frees the slot
+// when it handles the DISCONNECTED event. A handle reused by a new device gets
+// a new generation, so events still queued for the old one never match it.
+// The lock covers ownership and the flags; a plan is only written while its
+// slot is claimed and not yet valid, and only read once it is valid.
+//
+// The driver task never waits for the ring. An event that finds it full is
+// parked in its slot instead: the newest report (each one carries the full
+// state of its report ID) and the DISCONNECTED event. hid_input_task takes
+// them once the ring is empty, so they still follow everything queued earlier.
+typedef struct {
+  hid_host_device_handle_t handle;
+  uint32_t generation;
+  bool closing;   ///< DISCONNECTED queued; new events for the handle no longer map here
+  bool planValid;
+  bool pendingReport;  ///< Newest report that found the ring full, in pending
+  bool pendingRelease; ///< DISCONNECTED found the ring full
+  usb_input_event_t pending;
+  HidInterfacePlan plan;
+} hid_interface_slot_t;
+
+static hid_interface_slot_t interface_slots[USB_MAX_HID_INTERFACES];
+static portMUX_TYPE interface_slots_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Runtime metrics (see Metrics.h); reports are counted per interface slot
+static MetricCounter reportsPerSlot[USB_MAX_HID_INTERFACES] = {
+    MetricCounter("usb.reports.if0"), MetricCounter("usb.reports.if1"), MetricCounter("usb.reports.if2"),
+    MetricCounter("usb.reports.if3")};
+static MetricCounter reportsUnknown("usb.reports.unknown");
+static MetricCounter transferErrors("usb.transfer_errors");
+static MetricCounter usbConnects("usb.connects");
+static MetricCounter usbDisconnects("usb.disconnects");
+static MetricCounter inputResyncs("usb.input_resyncs");
+
+// Input reports from the HID driver task to hid_input_task
+static SpscRing<usb_input_event_t, USB_INPUT_RING_SIZE> input_ring;
+static TaskHandle_t input_task_handle = NULL;
+
 typedef struct {
   hid_host_device_handle_t hid_device_handle;
   hid_host_driver_event_t event;
@@ -27,6 +75,177 @@ typedef struct {
 
 static const char *hid_proto_name_str[] = {"NONE", "KEYBOARD", "MOUSE"};
 
+static hid_interface_slot_t *claim_interface_slot(hid_host_device_handle_t handle) {
+  hid_interface_slot_t *slot = nullptr;
+  portENTER_CRITICAL(&interface_slots_lock);
+  for (int i = 0; i < USB_MAX_HID_INTERFACES && slot == nullptr; i++) {
+    if (interface_slots[i].handle == nullptr) {
+      slot = &interface_slots[i];
+      slot->handle = handle;
+      slot->generation++;
+      slot->closing = false;
+      slot->planValid = false;
+      slot->pendingReport = false;
+      slot->pendingRelease = false;
+    }
+  }
+  portEXIT_CRITICAL(&interface_slots_lock);
+  return slot;
+}
+
+// Runs in the HID driver task; a DISCONNECTED event also detaches the handle
+static void tag_interface_event(usb_input_event_t &evt) {
+  evt.slot = -1;
+  evt.generation = 0;
+  portENTER_CRITICAL(&interface_slots_lock);
+  for (int i = 0; i < USB_MAX_HID_INTERFACES; i++) {
+    hid_interface_slot_t &slot = interface_slots[i];
+    if (slot.handle == evt.handle && !slot.closing) {
+      evt.slot = (int8_t)i;
+      evt.generation = slot.generation;
+      slot.closing = evt.type == USB_INPUT_EVENT_DISCONNECTED;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&interface_slots_lock);
+}
+
+static uint8_t plan_report_kinds(const HidInterfacePlan &plan, uint8_t reportId) {
+  for (uint8_t i = 0; i < plan.reportCount; i++) {
+    if (plan.reports[i].reportId == reportId) {
+      return plan.reports[i].kinds;
+    }
+  }
+  return 0;
+}
+
+// Runs in the HID driver task, after tag_interface_event. Never waits: an event
+// that finds the ring full is counted and parked in its slot (see above).
+static void queue_input_event(const usb_input_event_t &evt) {
+  if (evt.slot < 0) {
+    input_ring.push(evt); // Nothing to rebuild; a drop is only counted
+    xTaskNotifyGive(input_task_handle);
+    return;
+  }
+
+  hid_interface_slot_t &slot = interface_slots[evt.slot];
+  portENTER_CRITICAL(&interface_slots_lock);
+  // A parked report goes first so the interface's events stay in order
+  if (slot.pendingReport && input_ring.push(slot.pending)) {
+    slot.pendingReport = false;
+    inputResyncs.inc();
+  }
+  const bool queued = !slot.pendingReport && input_ring.push(evt);
+  if (!queued) {
+    if (evt.type == USB_INPUT_EVENT_DISCONNECTED) {
+      slot.pendingRelease = true;
+    } else {
+      // Reports carry the full state of their ID; only the newest is worth
+      // keeping. If it overwrites another ID's report, that one's kinds are
+      // released before it until they report again.
+      uint8_t releaseKinds = 0;
+      if (slot.pendingReport && slot.pending.reportId != evt.reportId && slot.planValid) {
+        releaseKinds = (slot.pending.releaseKinds | plan_report_kinds(slot.plan, slot.pending.reportId)) &
+                       ~plan_report_kinds(slot.plan, evt.reportId);
+      } else if (slot.pendingReport) {
+        releaseKinds = slot.pending.releaseKinds;
+      }
+      slot.pending = evt;
+      slot.pending.releaseKinds = releaseKinds;
+      slot.pendingReport = true;
+    }
+  }
+  portEXIT_CRITICAL(&interface_slots_lock);
+  xTaskNotifyGive(input_task_handle);
+}
+
+// The slot an event was queued for, or nullptr if it has since been released
+static hid_interface_slot_t *event_interface_slot(const usb_input_event_t &evt, bool &planValid) {
+  planValid = false;
+  if (evt.slot < 0) {
+    return nullptr;
+  }
+  hid_interface_slot_t *slot = &interface_slots[evt.slot];
+  portENTER_CRITICAL(&interface_slots_lock);
+  const bool current = slot->handle == evt.handle && slot->generation == evt.generation;
+  planValid = current && slot->planValid;
+  portEXIT_CRITICAL(&interface_slots_lock);
+  return current ? slot : nullptr;
+}
+
+// Returns true if the interface has to be switched to the boot protocol
+static bool build_interface_plan(hid_host_device_handle_t handle,
+                                 const hid_host_dev_params_t &dev_params) {
+  const bool bootKeyboard = HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class &&
+                            HID_PROTOCOL_KEYBOARD == dev_params.proto;
+  const bool bootMouse = HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class &&
+                         HID_PROTOCOL_MOUSE == dev_params.proto;
+  hid_interface_slot_t *slot = claim_interface_slot(handle);
+  if (slot == nullptr) {
+    Serial.println("[USB] No free interface slot, reports will be passed raw");
+    return bootKeyboard || bootMouse;
+  }
+
+  // Nobody reads the plan until planValid is published below
+  bool planValid = false;
+  bool bootProtocol = false;
+
+  // Report protocol whenever the descriptor decodes: boot interfaces of NKRO
+  // keyboards often describe a bitmap there that the boot layout would cap at 6 keys
+  size_t desc_length = 0;
+  const uint8_t *desc = hid_host_get_report_descriptor(handle, &desc_length);
+  if (desc != nullptr) {
+    planValid = hidParseReportDescriptor(desc, desc_length, slot->plan);
+  }
+  Serial.printf("[USB] Report descriptor: %u bytes\n", (unsigned)desc_length);
+
+  // A boot interface whose descriptor says nothing about its own kind falls
+  // back to the boot protocol, whose layout is fixed
+  const uint8_t bootKind = bootKeyboard ? HID_REPORT_KIND_KEYBOARD : bootMouse ? HID_REPORT_KIND_MOUSE : 0;
+  if (bootKind != 0) {
+    uint8_t kinds = 0;
+    for (uint8_t i = 0; planValid && i < slot->plan.reportCount; i++) {
+      kinds |= slot->plan.reports[i].kinds;
+    }
+    if (!(kinds & bootKind)) {
+      if (bootKeyboard) {
+        hidBuildBootKeyboardPlan(slot->plan);
+      } else {
+        hidBuildBootMousePlan(slot->plan);
+      }
+      planValid = true;
+      bootProtocol = true;
+    }
+  }
+
+  portENTER_CRITICAL(&interface_slots_lock);
+  slot->planValid = planValid;
+  portEXIT_CRITICAL(&interface_slots_lock);
+
+  if (!planValid) {
+    Serial.println("[USB] No decodable reports, reports will be passed raw");
+    return false;
+  }
+
+  for (uint8_t i = 0; i < slot->plan.reportCount; i++) {
+    const HidReportPlan &report = slot->plan.reports[i];
+    Serial.printf("[USB] Report ID 0x%02X: %s%s%s(%d fields)\n", report.reportId,
+                  (report.kinds & HID_REPORT_KIND_KEYBOARD) ? "KEYBOARD " : "",
+                  (report.kinds & HID_REPORT_KIND_MOUSE) ? "MOUSE " : "",
+                  (report.kinds & HID_REPORT_KIND_CONSUMER) ? "CONSUMER " : "",
+                  report.fieldCount);
+  }
+  return bootProtocol;
+}
+
+static void release_interface_slot(hid_interface_slot_t *slot) {
+  portENTER_CRITICAL(&interface_slots_lock);
+  slot->handle = nullptr;
+  slot->closing = false;
+  slot->planValid = false;
+  portEXIT_CRITICAL(&interface_slots_lock);
+}
+
 void USBManager::begin() {
   Serial.println("[USB] Installing USB Host library...");
   BaseType_t task_created =
@@ -49,6 +268,11 @@ void USBManager::begin() {
 
   task_created = xTaskCreate(&hid_host_task, "hid_task", 4096, NULL, 2, NULL);
   assert(task_created == pdTRUE);
+
+  // Consumer of the input ring; kept off core 0 where the USB and BLE stacks run
+  task_created = xTaskCreatePinnedToCore(&hid_input_task, "hid_input", 4096,
+                                         NULL, 4, &input_task_handle, 1);
+  assert(task_created == pdTRUE);
   Serial.println("[USB] HID driver ready");
 }
 
@@ -74,6 +298,7 @@ void USBManager::usb_lib_task(void *arg) {
 void USBManager::hid_host_task(void *pvParameters) {
   hid_host_event_queue_t evt_queue;
   hid_host_event_queue = xQueueCreate(10, sizeof(hid_host_event_queue_t));
+  profilerWatchQueue("hid_host_event_queue", hid_host_event_queue);
 
   while (true) {
     if (xQueueReceive(hid_host_event_queue, &evt_queue, pdMS_TO_TICKS(50))) {
@@ -105,6 +330,7 @@ void USBManager::hid_host_device_event(
 
   switch (event) {
   case HID_HOST_DRIVER_EVENT_CONNECTED:
+    usbConnects.inc();
     Serial.printf("[USB] %s connected!\n",
                   hid_proto_name_str[dev_params.proto]);
     Serial.printf("[USB] Protocol: %d, SubClass: %d, Address: %d\n",
@@ -116,24 +342,24 @@ void USBManager::hid_host_device_event(
       break;
     }
 
-    if (HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class) {
-      Serial.println("[USB] Boot interface detected");
+    // Must be in place before the interface starts delivering reports. The
+    // plan decides the protocol: report protocol whenever the descriptor
+    // decodes, boot protocol only for boot interfaces it does not cover
+    if (build_interface_plan(hid_device_handle, dev_params)) {
+      Serial.println("[USB] Boot interface without a usable descriptor");
       hid_class_request_set_protocol(hid_device_handle,
                                      HID_REPORT_PROTOCOL_BOOT);
-      if (HID_PROTOCOL_KEYBOARD == dev_params.proto) {
-        Serial.println("[USB] Setting keyboard idle");
-        hid_class_request_set_idle(hid_device_handle, 0, 0);
-      }
-      if (HID_PROTOCOL_MOUSE == dev_params.proto) {
-        Serial.println("[USB] Mouse is boot interface");
-      }
     } else {
-      Serial.printf("[USB] Non-boot interface: SubClass=%d (Proto=%d)\n", 
+      Serial.printf("[USB] Report protocol: SubClass=%d (Proto=%d)\n",
                     dev_params.sub_class, dev_params.proto);
-      // Set to report protocol for non-boot interfaces
       hid_class_request_set_protocol(hid_device_handle,
                                      HID_REPORT_PROTOCOL_REPORT);
     }
+    if (HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class &&
+        HID_PROTOCOL_KEYBOARD == dev_params.proto) {
+      Serial.println("[USB] Setting keyboard idle");
+      hid_class_request_set_idle(hid_device_handle, 0, 0);
+    }
 
     if (hid_host_device_start(hid_device_handle) != ESP_OK) {
       Serial.println("[USB] Failed to start HID device");
@@ -148,62 +374,57 @@ void USBManager::hid_host_device_event(
 void USBManager::hid_host_interface_callback(
     hid_host_device_handle_t hid_device_handle,
     const hid_host_interface_event_t event, void *arg) {
-  uint8_t data[64] = {0};
-  size_t data_length = 0;
+  // Runs in the HID driver task: copy the report into the ring and return.
+  // Decoding, translation and BLE output happen in hid_input_task.
+  if (event == HID_HOST_INTERFACE_EVENT_INPUT_REPORT) {
+    usb_input_event_t evt;
+    size_t data_length = 0;
+    evt.timestampUs = esp_timer_get_time();
+    if (hid_host_device_get_raw_input_report_data(hid_device_handle, evt.payload,
+                                                  sizeof(evt.payload),
+                                                  &data_length) != ESP_OK) {
+      return;
+    }
+    evt.type = USB_INPUT_EVENT_REPORT;
+    evt.handle = hid_device_handle;
+    evt.length = (uint8_t)data_length;
+    evt.reportId = data_length > 0 ? evt.payload[0] : 0;
+    evt.releaseKinds = 0;
+    tag_interface_event(evt);
+    queue_input_event(evt);
+    return;
+  }
+
   hid_host_dev_params_t dev_params;
 
   if (hid_host_device_get_params(hid_device_handle, &dev_params) != ESP_OK) {
     return;
   }
 
-  // Define HID subclass constants
-  static const char *hid_subclass_str[] = {"NONE", "BOOT_INTERFACE", "VENDOR"};
-
   switch (event) {
-  case HID_HOST_INTERFACE_EVENT_INPUT_REPORT:
-    if (hid_host_device_get_raw_input_report_data(hid_device_handle, data, 64,
-                                                  &data_length) == ESP_OK) {
-
-      // Debug: log all input reports
-      Serial.printf("[USB] Input Report - Proto: %s, SubClass: %s (%d), Length: %d, Data: ",
-                    hid_proto_name_str[dev_params.proto],
-                    dev_params.sub_class <= 2 ? hid_subclass_str[dev_params.sub_class] : "UNKNOWN",
-                    dev_params.sub_class, data_length);
-      for (size_t i = 0; i < data_length && i < 8; i++) {
-        Serial.printf("%02X ", data[i]);
-      }
-      Serial.println();
-
-      // Handle both boot and non-boot interfaces
-      if (HID_PROTOCOL_KEYBOARD == dev_params.proto) {
-        if (_keyboardCb) {
-          _keyboardCb(data, data_length);
-        }
-      } else if (HID_PROTOCOL_MOUSE == dev_params.proto) {
-        Serial.println("[USB] Calling mouse callback");
-        if (_mouseCb) {
-          _mouseCb(data, data_length);
-        } else {
-          Serial.println("[USB] ERROR: Mouse callback is NULL!");
-        }
-      } else {
-        // Handle other devices (consumer control, system control, vendor-specific, etc)
-        // This includes knobs, media keys, and other non-keyboard/mouse devices
-        if (_genericCb) {
-          Serial.println("[USB] Calling generic callback for non-keyboard/mouse device");
-          _genericCb(data, data_length);
-        }
-      }
-    }
-    break;
-
-  case HID_HOST_INTERFACE_EVENT_DISCONNECTED:
+  case HID_HOST_INTERFACE_EVENT_DISCONNECTED: {
+    usbDisconnects.inc();
     Serial.printf("[USB] %s disconnected\n",
                   hid_proto_name_str[dev_params.proto]);
+
+    // Queued behind the interface's last reports so the consumer releases its
+    // keys and its plan in order; on a full ring the slot remembers it
+    usb_input_event_t evt;
+    evt.type = USB_INPUT_EVENT_DISCONNECTED;
+    evt.timestampUs = esp_timer_get_time();
+    evt.handle = hid_device_handle;
+    evt.length = 0;
+    evt.reportId = 0;
+    evt.releaseKinds = 0;
+    tag_interface_event(evt);
+    queue_input_event(evt);
+
     hid_host_device_close(hid_device_handle);
     break;
+  }
 
   case HID_HOST_INTERFACE_EVENT_TRANSFER_ERROR:
+    transferErrors.inc();
     Serial.printf("[USB] %s transfer error\n",
                   hid_proto_name_str[dev_params.proto]);
     break;
@@ -212,3 +433,134 @@ void USBManager::hid_host_interface_callback(
     break;
   }
 }
+
+void USBManager::hid_input_task(void *pvParameters) {
+  usb_input_event_t evt;
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // While BLE refuses a push the callbacks block and nothing is popped;
+    // parked events are taken once everything queued before them is done
+    do {
+      while (input_ring.pop(evt)) {
+        dispatch_input_event(evt);
+      }
+    } while (dispatch_pending_events());
+  }
+}
+
+bool USBManager::dispatch_pending_events() {
+  bool dispatched = false;
+  for (int i = 0; i < USB_MAX_HID_INTERFACES; i++) {
+    hid_interface_slot_t &slot = interface_slots[i];
+    usb_input_event_t evt;
+    portENTER_CRITICAL(&interface_slots_lock);
+    const bool report = slot.pendingReport;
+    const bool release = slot.pendingRelease;
+    if (report) {
+      evt = slot.pending;
+    }
+    slot.pendingReport = false;
+    slot.pendingRelease = false;
+    const hid_host_device_handle_t handle = slot.handle;
+    const uint32_t generation = slot.generation;
+    portEXIT_CRITICAL(&interface_slots_lock);
+
+    if (report) {
+      // Rebuilds the interface's state from its newest report
+      inputResyncs.inc();
+      dispatch_input_event(evt);
+    }
+    if (release) {
+      usb_input_event_t disconnected = {};
+      disconnected.type = USB_INPUT_EVENT_DISCONNECTED;
+      disconnected.timestampUs = esp_timer_get_time();
+      disconnected.handle = handle;
+      disconnected.generation = generation;
+      disconnected.slot = (int8_t)i;
+      dispatch_input_event(disconnected);
+    }
+    dispatched |= report || release;
+  }
+  return dispatched;
+}
+
+void USBManager::dispatch_input_event(const usb_input_event_t &evt) {
+  bool planValid;
+  hid_interface_slot_t *slot = event_interface_slot(evt, planValid);
+
+  if (evt.type == USB_INPUT_EVENT_DISCONNECTED) {
+    if (slot == nullptr) {
+      return;
+    }
+    // Release whatever this interface was holding so no key, usage or button stays stuck
+    if (planValid && _releaseCb) {
+      uint8_t kinds = 0;
+      for (uint8_t i = 0; i < slot->plan.reportCount; i++) {
+        kinds |= slot->plan.reports[i].kinds;
+      }
+      _releaseCb((uint8_t)(slot - interface_slots), kinds);
+    }
+    release_interface_slot(slot);
+    return;
+  }
+
+  // A parked report that overwrote another ID's report releases that one's kinds
+  if (planValid && evt.releaseKinds != 0 && _releaseCb) {
+    _releaseCb((uint8_t)(slot - interface_slots), evt.releaseKinds);
+  }
+
+  // Debug: log the first 8 bytes of every input report (deferred, see BinLog.h)
+  uint32_t head[2] = {0, 0};
+  for (size_t i = 0; i < evt.length && i < 8; i++) {
+    head[i >> 2] |= (uint32_t)evt.payload[i] << (24 - 8 * (i & 3));
+  }
+  BINLOG(USB_INPUT_REPORT, slot != nullptr ? (int)(slot - interface_slots) : -1,
+         evt.length, head[0], head[1]);
+
+  // Decode through the interface's extraction plan; the plan already knows
+  // the protocol and report layout, so routing only looks at the result
+  HidDecodedReport report;
+
+  if (slot != nullptr) {
+    reportsPerSlot[slot - interface_slots].inc();
+  } else {
+    reportsUnknown.inc();
+  }
+
+  if (planValid && hidDecodeReport(slot->plan, evt.payload, evt.length, report)) {
+    report.source = (uint8_t)(slot - interface_slots);
+    // Each path is traced from the interface callback timestamp to its BLE notify
+    if ((report.kinds & HID_REPORT_KIND_KEYBOARD) && _keyboardCb) {
+      LatencyStats::beginInput(LATENCY_PATH_KEYBOARD, evt.timestampUs);
+      _keyboardCb(report);
+    }
+    if ((report.kinds & HID_REPORT_KIND_MOUSE) && _mouseCb) {
+      LatencyStats::beginInput(LATENCY_PATH_MOUSE, evt.timestampUs);
+      _mouseCb(report);
+    }
+    if ((report.kinds & HID_REPORT_KIND_CONSUMER) && _consumerCb) {
+      LatencyStats::beginInput(LATENCY_PATH_CONSUMER, evt.timestampUs);
+      _consumerCb(report);
+    }
+    LatencyStats::endInput();
+  } else if (_genericCb) {
+    // Vendor, system control and other reports without a plan
+    _genericCb(evt.payload, evt.length);
+  }
+}
+
+usb_input_stats_t USBManager::getInputStats() {
+  usb_input_stats_t stats;
+  stats.queued = input_ring.size();
+  stats.capacity = input_ring.capacity();
+  stats.overflows = input_ring.overflowCount();
+  stats.resyncs = inputResyncs.value();
+  stats.highWatermark = input_ring.highWatermark();
+  return stats;
+}
+
+void USBManager::resetInputStats() {
+  input_ring.resetStats();
+  inputResyncs.reset();
+}
@@ -7,21 +7,69 @@
 #define USB_MANAGER_H
 
 #include <Arduino.h>
+#include "HidReportParser.h"
 
 // Forward declarations for opaque HID types
 typedef void* hid_host_device_handle_t;
 typedef unsigned int hid_host_driver_event_t;
 typedef unsigned int hid_host_interface_event_t;
 
-/** @brief Callback type for keyboard reports. */
-typedef void (*KeyboardReportCallback)(const uint8_t *data, size_t length);
+/** @brief Maximum number of HID interfaces tracked at once (bounded by HCD channels). */
+#define USB_MAX_HID_INTERFACES 4
 
-/** @brief Callback type for mouse reports. */
-typedef void (*MouseReportCallback)(const uint8_t *data, size_t length);
+/**
+ * @brief Capacity of the ring between the HID driver task and the input consumer task.
+ * The consumer stops popping while the BLE scheduler refuses a push, which lasts
+ * until the next connection event; 64 reports cover a 1 kHz device through the
+ * slowest (60 ms) interval the governor negotiates.
+ */
+#define USB_INPUT_RING_SIZE 64
+
+/** @brief Largest input report copied into the ring. */
+#define USB_INPUT_MAX_PAYLOAD 64
+
+typedef enum {
+  USB_INPUT_EVENT_REPORT,       ///< Input report in payload
+  USB_INPUT_EVENT_DISCONNECTED, ///< Interface went away; release its state
+} usb_input_event_type_t;
+
+/** @brief One entry of the input ring, stamped when the USB transfer completed. */
+typedef struct {
+  int64_t timestampUs; ///< esp_timer_get_time() at callback entry
+  hid_host_device_handle_t handle;
+  uint32_t generation; ///< Generation of the interface slot when the event was queued
+  int8_t slot;         ///< Interface slot, -1 if the interface has none
+  uint8_t type;        ///< usb_input_event_type_t
+  uint8_t reportId;    ///< First payload byte (report ID on interfaces that use them)
+  uint8_t releaseKinds; ///< HidReportKind mask to release first: their newest report was dropped
+  uint8_t length;
+  uint8_t payload[USB_INPUT_MAX_PAYLOAD];
+} usb_input_event_t;
+
+/** @brief Input ring counters. */
+typedef struct {
+  uint32_t queued;        ///< Events waiting right now
+  uint32_t capacity;
+  uint32_t overflows;     ///< Reports that found the ring full (the driver task never waits)
+  uint32_t resyncs;       ///< Interfaces rebuilt from their newest dropped report
+  uint32_t highWatermark; ///< Deepest fill level since the last reset
+} usb_input_stats_t;
+
+/** @brief Callback type for decoded keyboard reports. */
+typedef void (*KeyboardReportCallback)(const HidDecodedReport &report);
+
+/** @brief Callback type for decoded mouse reports. */
+typedef void (*MouseReportCallback)(const HidDecodedReport &report);
 
-/** @brief Callback type for generic/consumer control reports. */
+/** @brief Callback type for decoded consumer control reports (knob, media keys). */
+typedef void (*ConsumerReportCallback)(const HidDecodedReport &report);
+
+/** @brief Callback type for raw reports that no extraction plan could decode. */
 typedef void (*GenericReportCallback)(const uint8_t *data, size_t length);
 
+/** @brief Callback type for an interface that went away; kinds is the HidReportKind mask of its plan. */
+typedef void (*InterfaceReleaseCallback)(uint8_t source, uint8_t kinds);
+
 class USBManager {
 public:
   /**
@@ -40,18 +88,39 @@ public:
     _mouseCb = cb;
   }
 
-  /** @brief Sets the callback for incoming generic/consumer reports (knob, media keys, etc). */
+  /** @brief Sets the callback for incoming consumer control reports (knob, media keys, etc). */
+  static void setConsumerCallback(ConsumerReportCallback cb) {
+    _consumerCb = cb;
+  }
+
+  /** @brief Sets the callback for raw reports without a matching extraction plan. */
   static void setGenericCallback(GenericReportCallback cb) {
     _genericCb = cb;
   }
 
+  /** @brief Sets the callback that releases the state of a disconnected interface. */
+  static void setReleaseCallback(InterfaceReleaseCallback cb) {
+    _releaseCb = cb;
+  }
+
+  /** @brief Returns input ring counters. */
+  static usb_input_stats_t getInputStats();
+
+  /** @brief Clears the overflow and resync counters and the high-watermark. */
+  static void resetInputStats();
+
 private:
   static KeyboardReportCallback _keyboardCb;
   static MouseReportCallback _mouseCb;
+  static ConsumerReportCallback _consumerCb;
   static GenericReportCallback _genericCb;
+  static InterfaceReleaseCallback _releaseCb;
 
   static void usb_lib_task(void *arg);
   static void hid_host_task(void *pvParameters);
+  static void hid_input_task(void *pvParameters);
+  static void dispatch_input_event(const usb_input_event_t &evt);
+  static bool dispatch_pending_events();
 
   static void hid_host_device_callback(hid_host_device_handle_t hid_device_handle,
                            const hid_host_driver_event_t event, void *arg);
@@ -7,8 +7,8 @@
 #include "USBManager.h"
 
 // Forward declarations for USB callbacks
-void onKeyboardReport(const uint8_t *data, size_t length);
-void onMouseReport(const uint8_t *data, size_t length);
+void onKeyboardReport(const HidDecodedReport &report);
+void onMouseReport(const HidDecodedReport &report);
 void onGenericReport(const uint8_t *data, size_t length);
 
 void setup()
@@ -71,13 +71,11 @@ void setup()
   Serial.println();
 }
 
-void onKeyboardReport(const uint8_t *data, size_t length)
+void onKeyboardReport(const HidDecodedReport &report)
 {
-  if (length < 8)
-    return;
-
-  uint8_t modifier = data[0];
-  const uint8_t *keys = &data[2]; // Keys start at byte 2
+  uint8_t modifier = report.modifiers;
+  uint8_t keys[6] = {0, 0, 0, 0, 0, 0};
+  report.keys.toArray(keys, 6);
 
   if (USBKeyboard::isConnected())
   {
@@ -88,11 +86,8 @@ void onKeyboardReport(const uint8_t *data, size_t length)
                 modifier, keys[0], keys[1], keys[2], keys[3], keys[4], keys[5]);
 }
 
-void onMouseReport(const uint8_t *data, size_t length)
+void onMouseReport(const HidDecodedReport &report)
 {
-  if (length < 3)
-    return;
-
   // Mouse support can be added here if needed
   Serial.println("[MOUSE] Input detected (not yet forwarded)");
 }
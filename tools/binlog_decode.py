@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Decode BinLog binary frames back into text.
+
+The message catalogue (IDs and format strings) is read from srcs/BinLog.h,
+so the decoder always matches the firmware it was built from as long as
+messages are only ever appended.
+
+Usage:
+    binlog_decode.py capture.bin
+    binlog_decode.py /dev/ttyACM0 --baud 115200      (needs pyserial)
+
+Bytes outside frames (boot messages, regular Serial.println output) are
+passed through unchanged.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+HEADER = struct.Struct("<IHBB")  # timestamp, id, argc, checksum
+MAX_ARGS = 8
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(__file__), "..", "srcs", "BinLog.h")
+
+
+def load_catalogue(path):
+    """Returns [(name, format)] in ID order from the BINLOG_MESSAGES X-macro."""
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    start = text.index("#define BINLOG_MESSAGES(X)")
+    body = text[start:text.index("\n\n", start)].replace("\\\n", " ")
+    entries = re.findall(r'X\(\s*(\w+)\s*,\s*\w+\s*,\s*\w+\s*,\s*((?:"(?:[^"\\]|\\.)*"\s*)+)\)', body)
+    return [(name, "".join(re.findall(r'"((?:[^"\\]|\\.)*)"', fmt))) for name, fmt in entries]
+
+
+def format_message(fmt, args):
+    """Applies a printf-style format to raw 32-bit words."""
+    values = []
+    for conv in re.findall(r"%[-+ #0]*\d*(?:\.\d+)?[hlz]*([diuxXc%])", fmt):
+        if conv == "%":
+            continue
+        word = args[len(values)] if len(values) < len(args) else 0
+        if conv in "di":
+            word = word - (1 << 32) if word & 0x80000000 else word
+        values.append(word)
+    py_fmt = re.sub(r"%([-+ #0]*\d*(?:\.\d+)?)[hlz]*([diuxXc])",
+                    lambda m: "%" + m.group(1) + ("d" if m.group(2) == "u" else m.group(2)), fmt)
+    return py_fmt % tuple(values)
+
+
+def decode(stream, catalogue, out):
+    buf = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buf += chunk
+
+        while True:
+            pos = buf.find(SYNC)
+            if pos < 0:
+                # Keep a trailing 0xA5 in case the sync is split across reads
+                keep = 1 if buf.endswith(SYNC[:1]) else 0
+                out.write(buf[:len(buf) - keep].decode("utf-8", "replace"))
+                buf = buf[len(buf) - keep:]
+                break
+            if pos > 0:
+                out.write(buf[:pos].decode("utf-8", "replace"))
+                buf = buf[pos:]
+
+            if len(buf) < 2 + HEADER.size:
+                break
+            timestamp, msg_id, argc, checksum = HEADER.unpack_from(buf, 2)
+            if argc > MAX_ARGS or msg_id >= len(catalogue):
+                out.write(buf[:1].decode("utf-8", "replace"))
+                buf = buf[1:]
+                continue
+            frame_len = 2 + HEADER.size + 4 * argc
+            if len(buf) < frame_len:
+                break
+
+            calc = 0
+            for i, b in enumerate(buf[2:frame_len]):
+                if i != HEADER.size - 1:
+                    calc ^= b
+            if calc != checksum:
+                out.write(buf[:1].decode("utf-8", "replace"))
+                buf = buf[1:]
+                continue
+
+            args = struct.unpack_from("<%dI" % argc, buf, 2 + HEADER.size)
+            name, fmt = catalogue[msg_id]
+            out.write("%10.6f %s\n" % (timestamp / 1e6, format_message(fmt, args)))
+            buf = buf[frame_len:]
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="capture file or serial port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="path to BinLog.h")
+    opts = parser.parse_args()
+
+    catalogue = load_catalogue(opts.header)
+
+    if os.path.isfile(opts.source):
+        with open(opts.source, "rb") as stream:
+            decode(stream, catalogue, sys.stdout)
+    else:
+        import serial
+        with serial.Serial(opts.source, opts.baud, timeout=0.1) as port:
+            class Blocking:
+                def read(self, n):
+                    while True:
+                        data = port.read(n)
+                        if data:
+                            return data
+            try:
+                decode(Blocking(), catalogue, sys.stdout)
+            except KeyboardInterrupt:
+                pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Pack data/ into an image for the memory-mapped asset partition.
+
+The firmware maps the "assets" partition (see partitions.csv) and reads
+files straight from flash through srcs/AssetBundle.h. Anything missing
+from the image is still read from SPIFFS, so both can be flashed side by
+side.
+
+Images (.jpg, .png, .bmp) are converted to RGB565 in SPI byte order, the
+format the display takes without conversion. If run-length encoding is
+smaller, that is stored instead. So the firmware never decodes a JPEG
+from the bundle. Other files (GIFs) are stored as they are. Converting
+needs Pillow; --raw-images keeps the image files as they are.
+
+Usage:
+    pack_assets.py [data_dir] [-o assets.bin] [--raw-images]
+    esptool.py --chip esp32s3 write_flash 0x400000 assets.bin
+
+`pio run -t uploadassets` does both (tools/pio_assets.py). Files are stored
+under their path relative to data_dir with a leading slash
+("/bongo/1.jpg"), the same name SPIFFS uses.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = 0x54455341  # "ASET"
+VERSION = 2
+NAME_LEN = 32
+MAX_WIDTH = 320
+HEADER = struct.Struct("<IHHII")  # magic, version, count, image size, entry table CRC
+ENTRY = struct.Struct("<%dsIIHHHHI" % NAME_LEN)  # name, offset, size, format, width, height, 0, CRC
+PARTITION_SIZE = 0x400000
+
+FORMAT_RAW, FORMAT_RGB565, FORMAT_RLE565 = 0, 1, 2
+FORMAT_NAMES = {FORMAT_RAW: "raw", FORMAT_RGB565: "rgb565", FORMAT_RLE565: "rle565"}
+IMAGE_EXTENSIONS = (".jpg", ".jpeg", ".png", ".bmp")
+RLE_REPEAT = 0x8000
+RLE_MAX = 0x7FFF
+
+DEFAULT_DATA = os.path.join(os.path.dirname(__file__), "..", "data")
+
+
+def to_rgb565(path):
+    """Returns (width, height, pixels) with pixels as big-endian RGB565 bytes."""
+    from PIL import Image  # Only needed for images
+
+    with Image.open(path) as image:
+        image = image.convert("RGB")
+        width, height = image.size
+        if width > MAX_WIDTH:
+            raise ValueError("%s is %d pixels wide, the firmware takes at most %d" % (path, width, MAX_WIDTH))
+        rgb = image.tobytes()
+    out = bytearray(width * height * 2)
+    for i in range(width * height):
+        r, g, b = rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]
+        struct.pack_into(">H", out, 2 * i, (r >> 3) << 11 | (g >> 2) << 5 | b >> 3)
+    return width, height, bytes(out)
+
+
+def rle_encode(pixels):
+    """Runs of two or more equal pixels become repeat tokens, the rest literal tokens."""
+    words = [pixels[i:i + 2] for i in range(0, len(pixels), 2)]
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:RLE_MAX]
+            del literal[:RLE_MAX]
+            out.extend(struct.pack("<H", len(chunk)))
+            out.extend(b"".join(chunk))
+
+    i = 0
+    while i < len(words):
+        run = 1
+        while i + run < len(words) and run < RLE_MAX and words[i + run] == words[i]:
+            run += 1
+        if run >= 2:
+            flush_literal()
+            out.extend(struct.pack("<H", RLE_REPEAT | run))
+            out.extend(words[i])
+        else:
+            literal.append(words[i])
+        i += run
+    flush_literal()
+    return bytes(out)
+
+
+def rle_decode(data):
+    """Inverse of rle_encode, used to check every encoded entry before it is packed."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        (token,) = struct.unpack_from("<H", data, i)
+        count = token & RLE_MAX
+        i += 2
+        if token & RLE_REPEAT:
+            out.extend(data[i:i + 2] * count)
+            i += 2
+        else:
+            out.extend(data[i:i + 2 * count])
+            i += 2 * count
+    return bytes(out)
+
+
+def convert(name, path, raw_images):
+    """Returns (format, width, height, stored bytes, content CRC, source size)."""
+    with open(path, "rb") as f:
+        source = f.read()
+    if raw_images or not name.lower().endswith(IMAGE_EXTENSIONS):
+        return FORMAT_RAW, 0, 0, source, zlib.crc32(source), len(source)
+
+    width, height, pixels = to_rgb565(path)
+    crc = zlib.crc32(pixels)
+    rle = rle_encode(pixels)
+    if rle_decode(rle) != pixels:
+        raise AssertionError("RLE round trip failed for %s" % name)
+    if len(rle) < len(pixels):
+        return FORMAT_RLE565, width, height, rle, crc, len(source)
+    return FORMAT_RGB565, width, height, pixels, crc, len(source)
+
+
+def collect(data_dir, raw_images=False):
+    """Returns [(name, format, width, height, data, crc, source size)] for every file, sorted by name."""
+    files = []
+    for root, _, names in os.walk(data_dir):
+        for name in names:
+            path = os.path.join(root, name)
+            rel = "/" + os.path.relpath(path, data_dir).replace(os.sep, "/")
+            if len(rel.encode()) >= NAME_LEN:
+                raise ValueError("name too long for the asset table: %s" % rel)
+            files.append((rel,) + convert(rel, path, raw_images))
+    return sorted(files)
+
+
+def pack(files):
+    """Builds the image: header, entry table, then the files at 4-byte aligned offsets."""
+    table_end = HEADER.size + ENTRY.size * len(files)
+    table = b""
+    blobs = b""
+    for name, fmt, width, height, data, crc, _ in files:
+        blobs += b"\0" * (-(table_end + len(blobs)) % 4)
+        table += ENTRY.pack(name.encode(), table_end + len(blobs), len(data), fmt, width, height, 0, crc)
+        blobs += data
+    size = table_end + len(blobs)
+    return HEADER.pack(MAGIC, VERSION, len(files), size, zlib.crc32(table)) + table + blobs
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("data_dir", nargs="?", default=DEFAULT_DATA)
+    parser.add_argument("-o", "--output", default="assets.bin")
+    parser.add_argument("--raw-images", action="store_true", help="store images without converting them")
+    args = parser.parse_args()
+
+    try:
+        files = collect(args.data_dir, args.raw_images)
+    except ImportError:
+        sys.exit("converting images needs Pillow (pip install pillow), or pass --raw-images")
+    image = pack(files)
+    if len(image) > PARTITION_SIZE:
+        sys.exit("image is %d bytes, the partition holds %d" % (len(image), PARTITION_SIZE))
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    source_total = 0
+    for name, fmt, width, height, data, _, source in files:
+        size = "%dx%d" % (width, height) if fmt != FORMAT_RAW else ""
+        print("%-32s %-7s %-8s %8d bytes (source %d)" % (name, FORMAT_NAMES[fmt], size, len(data), source))
+        source_total += source
+    print("%d files, %d bytes -> %s (sources %d bytes)" % (len(files), len(image), args.output, source_total))
+
+
+if __name__ == "__main__":
+    main()
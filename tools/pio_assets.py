@@ -0,0 +1,58 @@
+"""PlatformIO hook: packs data/ into the asset partition image on every build.
+
+Enabled with `extra_scripts = pre:tools/pio_assets.py`. The image is written
+to $BUILD_DIR/assets.bin when data/ or the packer changed. It is flashed
+with `pio run -t uploadassets` at the offset of the "assets" partition in
+partitions.csv. Without Pillow the build goes on and prints a warning; the
+firmware then reads everything from SPIFFS.
+"""
+
+import os
+import subprocess
+import sys
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+DATA_DIR = os.path.join(PROJECT_DIR, "data")
+PACKER = os.path.join(PROJECT_DIR, "tools", "pack_assets.py")
+IMAGE = os.path.join(env.subst("$BUILD_DIR"), "assets.bin")  # noqa: F821
+ASSET_OFFSET = "0x400000"
+
+
+def newest_input():
+    times = [os.path.getmtime(PACKER)]
+    for root, _, names in os.walk(DATA_DIR):
+        times.extend(os.path.getmtime(os.path.join(root, name)) for name in names)
+    return max(times)
+
+
+def pack_assets():
+    if os.path.exists(IMAGE) and os.path.getmtime(IMAGE) >= newest_input():
+        return True
+    os.makedirs(os.path.dirname(IMAGE), exist_ok=True)
+    result = subprocess.run([sys.executable, PACKER, DATA_DIR, "-o", IMAGE], capture_output=True, text=True)
+    if result.returncode != 0:
+        print("Asset bundle not built: %s" % (result.stderr.strip() or result.stdout.strip()))
+        return False
+    print(result.stdout.strip().splitlines()[-1])
+    return True
+
+
+def upload_assets(*args, **kwargs):
+    if not pack_assets():
+        return 1
+    esptool = os.path.join(env.PioPlatform().get_package_dir("tool-esptoolpy"), "esptool.py")  # noqa: F821
+    return env.Execute(  # noqa: F821
+        env.VerboseAction(  # noqa: F821
+            '"$PYTHONEXE" "%s" --chip esp32s3 --port "$UPLOAD_PORT" write_flash %s "%s"'
+            % (esptool, ASSET_OFFSET, IMAGE),
+            "Writing the asset partition",
+        )
+    )
+
+
+pack_assets()
+env.AddCustomTarget(  # noqa: F821
+    "uploadassets", None, upload_assets, title="Upload assets", description="Pack data/ and flash the asset partition"
+)